@@ -52,6 +52,20 @@ public class RD : ModuleRules
 		PrivateDefinitions.Add("spdlog_EXPORTS");
 		PrivateDefinitions.Add("FMT_EXPORT");
 
+		// RD_LOG_* calls below this level are compiled out along with formatting of their arguments
+		if (Target.Configuration == UnrealTargetConfiguration.Debug ||
+		    Target.Configuration == UnrealTargetConfiguration.DebugGame)
+		{
+			PublicDefinitions.Add("SPDLOG_ACTIVE_LEVEL=SPDLOG_LEVEL_TRACE");
+		}
+		else
+		{
+			PublicDefinitions.Add("SPDLOG_ACTIVE_LEVEL=SPDLOG_LEVEL_INFO");
+		}
+		// RD loggers write through one background thread, a full queue drops its oldest message
+		// rather than block socket and scheduler threads (RD_LOG_OVERFLOW_BLOCK=1 to block)
+		PublicDefinitions.Add("RD_LOG_QUEUE_SIZE=8192");
+		PublicDefinitions.Add("RD_LOG_OVERFLOW_BLOCK=0");
 		PublicDefinitions.Add("SPDLOG_NO_EXCEPTIONS");
 		PublicDefinitions.Add("SPDLOG_COMPILED_LIB");
 		PublicDefinitions.Add("SPDLOG_SHARED_LIB");
@@ -1,10 +1,11 @@
 #include "Lifetime.h"
 
+#include "util/core_log.h"
+
 #include <memory>
 
 #include <thirdparty.hpp>
 #include <spdlog/spdlog.h>
-#include <spdlog/sinks/stdout_color_sinks.h>
 
 namespace rd
 {
@@ -20,7 +21,7 @@ std::once_flag onceFlag;
 Lifetime::Lifetime(bool is_eternal) : ptr(std::allocate_shared<LifetimeImpl, Allocator>(allocator, is_eternal))
 {
 	std::call_once(onceFlag, [] {
-		spdlog::set_default_logger(spdlog::stderr_color_mt<spdlog::synchronous_factory>("default", spdlog::color_mode::automatic));
+		spdlog::set_default_logger(util::create_logger("default"));
 	});
 }
 
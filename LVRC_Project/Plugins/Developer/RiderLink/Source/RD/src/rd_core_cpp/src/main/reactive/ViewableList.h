@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <memory>
 #include <utility>
 
 namespace rd
@@ -21,7 +22,7 @@ public:
 	using Event = typename IViewableList<T>::Event;
 
 private:
-	using WA = typename A::template rebind<Wrapper<T>>::other;
+	using WA = typename std::allocator_traits<A>::template rebind_alloc<Wrapper<T>>;
 	using data_t = std::vector<Wrapper<T>, WA>;
 	mutable data_t list;
 	Signal<Event> change;
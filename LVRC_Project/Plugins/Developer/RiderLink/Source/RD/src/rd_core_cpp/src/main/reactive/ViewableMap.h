@@ -10,6 +10,7 @@
 #include <thirdparty.hpp>
 
 #include <iterator>
+#include <memory>
 #include <utility>
 
 namespace rd
@@ -28,7 +29,7 @@ private:
 	using WV = typename IViewableMap<K, V>::WV;
 	using OV = typename IViewableMap<K, V>::OV;
 
-	using PA = typename VA::template rebind<std::pair<Wrapper<K>, Wrapper<V>>>::other;
+	using PA = typename std::allocator_traits<VA>::template rebind_alloc<std::pair<Wrapper<K>, Wrapper<V>>>;
 
 	Signal<Event> change;
 
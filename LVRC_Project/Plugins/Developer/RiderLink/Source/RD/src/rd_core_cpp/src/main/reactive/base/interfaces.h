@@ -76,6 +76,16 @@ public:
 
 	virtual void fire(T const& value) const = 0;
 
+	/**
+	 * \brief Fires [value] unless it would have to wait, e.g. a signal on a congested wire drops it instead of sending.
+	 * \return false if the value was dropped.
+	 */
+	virtual bool try_fire(T const& value) const
+	{
+		fire(value);
+		return true;
+	}
+
 	/**
 	 * \brief @code fire specialisation at T=Void
 	 */
@@ -2,11 +2,45 @@
 #define RD_CPP_ALLOCATOR_H
 
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace rd
 {
 template <typename T>
 using allocator = std::allocator<T>;
-}
+
+/**
+ * \brief Allocator which default-initializes values constructed without arguments, so that e.g. `resize` of a byte
+ * vector leaves the new bytes as they are instead of zeroing them. Meant for storage which is written right after it grows.
+ */
+template <typename T, typename A = std::allocator<T>>
+class default_init_allocator : public A
+{
+	using traits = std::allocator_traits<A>;
+
+public:
+	template <typename U>
+	struct rebind
+	{
+		using other = default_init_allocator<U, typename traits::template rebind_alloc<U>>;
+	};
+
+	using A::A;
+
+	template <typename U>
+	void construct(U* ptr) noexcept(std::is_nothrow_default_constructible<U>::value)
+	{
+		::new (static_cast<void*>(ptr)) U;
+	}
+
+	template <typename U, typename... Args>
+	void construct(U* ptr, Args&&... args)
+	{
+		traits::construct(static_cast<A&>(*this), ptr, std::forward<Args>(args)...);
+	}
+};
+}	 // namespace rd
 
 #endif	  // RD_CPP_ALLOCATOR_H
@@ -0,0 +1,87 @@
+#include "core_log.h"
+
+#include <spdlog/async.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <mutex>
+
+namespace rd
+{
+namespace util
+{
+namespace
+{
+constexpr spdlog::async_overflow_policy OVERFLOW_POLICY =
+	RD_LOG_OVERFLOW_BLOCK ? spdlog::async_overflow_policy::block : spdlog::async_overflow_policy::overrun_oldest;
+
+using async_factory = spdlog::async_factory_impl<OVERFLOW_POLICY>;
+
+// loggers are created from static initializers of other translation units
+std::mutex& backend_lock()
+{
+	static std::mutex lock;
+	return lock;
+}
+
+bool& backend_shut_down()
+{
+	static bool shut_down = false;
+	return shut_down;
+}
+}	 // namespace
+
+std::shared_ptr<spdlog::logger> create_logger(std::string const& name)
+{
+	std::lock_guard<std::mutex> guard(backend_lock());
+	if (backend_shut_down())
+	{
+		// e.g. a scheduler created during module unload, keep the name registered but don't restart the pool
+		auto logger = spdlog::stderr_color_mt<spdlog::synchronous_factory>(name, spdlog::color_mode::automatic);
+		logger->set_level(spdlog::level::off);
+		return logger;
+	}
+
+	auto& registry = spdlog::details::registry::instance();
+	{
+		std::lock_guard<std::recursive_mutex> tp_guard(registry.tp_mutex());
+		if (registry.get_tp() == nullptr)
+		{
+			registry.set_tp(std::make_shared<spdlog::details::thread_pool>(RD_LOG_QUEUE_SIZE, 1));
+		}
+	}
+	// spdlog::stderr_color_mt is precompiled for the blocking factory only
+	return async_factory::create<spdlog::sinks::stderr_color_sink_mt>(name, spdlog::color_mode::automatic);
+}
+
+void set_log_flush_interval(std::chrono::seconds interval)
+{
+	std::lock_guard<std::mutex> guard(backend_lock());
+	if (!backend_shut_down())
+	{
+		spdlog::flush_every(interval);
+	}
+}
+
+void shutdown_logging()
+{
+	std::lock_guard<std::mutex> guard(backend_lock());
+	if (backend_shut_down())
+	{
+		return;
+	}
+	backend_shut_down() = true;
+
+	// the periodic flusher would post to the pool after it's gone
+	spdlog::flush_every(std::chrono::seconds::zero());
+	spdlog::apply_all([](std::shared_ptr<spdlog::logger> logger) {
+		if (std::dynamic_pointer_cast<spdlog::async_logger>(logger) != nullptr)
+		{
+			logger->flush();
+			logger->set_level(spdlog::level::off);
+		}
+	});
+	// the worker drains the queue before it's joined
+	spdlog::details::registry::instance().set_tp(nullptr);
+}
+}	 // namespace util
+}	 // namespace rd
@@ -0,0 +1,117 @@
+#ifndef RD_CPP_CORE_LOG_H
+#define RD_CPP_CORE_LOG_H
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <rd_core_export.h>
+
+/**
+ * Capacity of the queue between logging threads and the thread which formats and writes RD logs.
+ */
+#ifndef RD_LOG_QUEUE_SIZE
+#define RD_LOG_QUEUE_SIZE 8192
+#endif
+
+/**
+ * 0: a full queue overwrites its oldest message, 1: a full queue blocks the logging thread until the writer catches up.
+ * RD loggers are created during static initialization, so it can't be a runtime setting.
+ */
+#ifndef RD_LOG_OVERFLOW_BLOCK
+#define RD_LOG_OVERFLOW_BLOCK 0
+#endif
+
+/**
+ * Logging on RD paths which run per message. Unlike logger->trace(...) the arguments (to_string, logmsg, etc.)
+ * are evaluated only if [logger] accepts the level, and calls below SPDLOG_ACTIVE_LEVEL are compiled out.
+ * [logger] is anything dereferenceable to spdlog::logger: a shared_ptr, a raw pointer.
+ */
+#define RD_LOG_CALL(logger, level, ...)             \
+	do                                              \
+	{                                               \
+		auto&& rd_log_logger = (logger);            \
+		if (rd_log_logger->should_log(level))       \
+		{                                           \
+			rd_log_logger->log(level, __VA_ARGS__); \
+		}                                           \
+	} while (false)
+
+/**
+ * Below SPDLOG_ACTIVE_LEVEL the arguments are never evaluated, but still count as used, so that locals which exist
+ * only for a log message don't become unused-variable warnings.
+ */
+#define RD_LOG_DISABLED(logger, ...)                        \
+	do                                                      \
+	{                                                       \
+		if (false)                                          \
+		{                                                   \
+			(void) (logger);                                \
+			::rd::util::discard_log_arguments(__VA_ARGS__); \
+		}                                                   \
+	} while (false)
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+#define RD_LOG_TRACE(logger, ...) RD_LOG_CALL(logger, spdlog::level::trace, __VA_ARGS__)
+#else
+#define RD_LOG_TRACE(logger, ...) RD_LOG_DISABLED(logger, __VA_ARGS__)
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define RD_LOG_DEBUG(logger, ...) RD_LOG_CALL(logger, spdlog::level::debug, __VA_ARGS__)
+#else
+#define RD_LOG_DEBUG(logger, ...) RD_LOG_DISABLED(logger, __VA_ARGS__)
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+#define RD_LOG_INFO(logger, ...) RD_LOG_CALL(logger, spdlog::level::info, __VA_ARGS__)
+#else
+#define RD_LOG_INFO(logger, ...) RD_LOG_DISABLED(logger, __VA_ARGS__)
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
+#define RD_LOG_WARN(logger, ...) RD_LOG_CALL(logger, spdlog::level::warn, __VA_ARGS__)
+#else
+#define RD_LOG_WARN(logger, ...) RD_LOG_DISABLED(logger, __VA_ARGS__)
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
+#define RD_LOG_ERROR(logger, ...) RD_LOG_CALL(logger, spdlog::level::err, __VA_ARGS__)
+#else
+#define RD_LOG_ERROR(logger, ...) RD_LOG_DISABLED(logger, __VA_ARGS__)
+#endif
+
+namespace rd
+{
+namespace util
+{
+/**
+ * \brief Sink of the arguments of a compiled out [RD_LOG_DISABLED] call.
+ */
+template <typename... Args>
+inline void discard_log_arguments(Args const&...)
+{
+}
+
+/**
+ * \brief Creates and registers a logger writing to stderr through the thread pool shared by all RD loggers,
+ * so threads which log never wait for the console or files attached later.
+ */
+std::shared_ptr<spdlog::logger> RD_CORE_API create_logger(std::string const& name);
+
+/**
+ * \brief Flushes all loggers every [interval], zero disables periodic flushing.
+ */
+void RD_CORE_API set_log_flush_interval(std::chrono::seconds interval);
+
+/**
+ * \brief Writes out queued messages, joins the logging thread and turns RD loggers off for the rest of the process.
+ * Must be called after threads which log are stopped and before the module is unloaded.
+ */
+void RD_CORE_API shutdown_logging();
+}	 // namespace util
+}	 // namespace rd
+
+#endif	  // RD_CPP_CORE_LOG_H
@@ -1,6 +1,7 @@
 #ifndef RD_CPP_CORE_CPP_UTIL_H
 #define RD_CPP_CORE_CPP_UTIL_H
 
+#include "core_log.h"
 #include "erase_if.h"
 #include "gen_util.h"
 #include "overloaded.h"
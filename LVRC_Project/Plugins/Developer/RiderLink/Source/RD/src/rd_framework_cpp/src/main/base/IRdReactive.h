@@ -21,6 +21,15 @@ public:
 	 * Otherwise, local changes can be performed only on the UI thread.
 	 */
 	bool async = false;
+
+protected:
+	/**
+	 * \brief Lane in which incoming messages of this object are queued to its wire scheduler, e.g.
+	 * [SchedulerLane::Bulk] for a stream of log events or [SchedulerLane::Control] for requests of the IDE.
+	 */
+	SchedulerLane lane = SchedulerLane::Interactive;
+
+public:
 	// region ctor/dtor
 
 	IRdReactive() = default;
@@ -34,6 +43,11 @@ public:
 	 */
 	virtual IScheduler* get_wire_scheduler() const = 0;
 
+	SchedulerLane get_lane() const
+	{
+		return lane;
+	}
+
 	/**
 	 * \brief Callback that wire triggers when it receives messaged
 	 * \param buffer where serialised info is stored
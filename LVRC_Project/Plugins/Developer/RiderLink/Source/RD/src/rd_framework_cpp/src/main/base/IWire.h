@@ -39,6 +39,18 @@ public:
 	 */
 	virtual void send(RdId const& id, std::function<void(Buffer& buffer)> writer) const = 0;
 
+	/**
+	 * \brief Non-blocking version of [send] for producers which can shed load.
+	 * \param id of recipient.
+	 * \param writer is used to serialise data before send.
+	 * \return false if the wire is congested, the data is not sent in this case.
+	 */
+	virtual bool try_send(RdId const& id, std::function<void(Buffer& buffer)> writer) const
+	{
+		send(id, std::move(writer));
+		return true;
+	}
+
 	/**
 	 * \brief Adds a [handler] for receiving updated values of the object with the given [id]. The handler is removed
 	 * when the given [lifetime] is terminated.
@@ -46,6 +58,61 @@ public:
 	 * \param entity to be subscripted
 	 */
 	virtual void advise(Lifetime lifetime, IRdReactive const* entity) const = 0;
+
+	/**
+	 * \brief Makes the messages which the current thread sends through [wire] while it's alive leave together, e.g.
+	 * a pipelined batch of calls: a wire which frames packages puts them into as few packages as it can, with one header
+	 * and one acknowledgement each. Messages keep their order. Scopes nest, only the outermost one sends.
+	 *
+	 * The messages are held until the scope ends, so nothing may wait for a reply inside it, e.g. [RdCall::sync].
+	 * Messages which other threads send meanwhile may leave first, so a scope is kept only around sends whose order
+	 * relative to other threads doesn't matter.
+	 *
+	 * A wire batches messages of one thread at a time, a scope opened by another thread meanwhile has no effect.
+	 */
+	class SendBatch
+	{
+	public:
+		// region ctor/dtor
+
+		explicit SendBatch(IWire const& wire) : wire(wire), owner(wire.begin_send_batch())
+		{
+		}
+
+		SendBatch(SendBatch const&) = delete;
+
+		SendBatch& operator=(SendBatch const&) = delete;
+
+		~SendBatch()
+		{
+			if (owner)
+			{
+				wire.end_send_batch();
+			}
+		}
+		// endregion
+
+	private:
+		IWire const& wire;
+		bool owner;
+	};
+
+protected:
+	/**
+	 * \return whether the current thread has started a batch, see [SendBatch]. Wires which send every message
+	 * right away don't batch.
+	 */
+	virtual bool begin_send_batch() const
+	{
+		return false;
+	}
+
+	/**
+	 * \brief Sends the messages batched since [begin_send_batch].
+	 */
+	virtual void end_send_batch() const
+	{
+	}
 };
 }	 // namespace rd
 #if defined(_MSC_VER)
@@ -0,0 +1,35 @@
+#include "RdChunkedReactiveBase.h"
+
+#include "base/IWire.h"
+#include "util/core_log.h"
+
+namespace rd
+{
+RdChunkedReactiveBase::RdChunkedReactiveBase()
+	: reader([this](WireChunk const& chunk) { on_wire_chunk_received(chunk); },
+		  [this](int32_t stream, int64_t received, int64_t total) { on_wire_stream_aborted(stream, received, total); })
+{
+}
+
+void RdChunkedReactiveBase::init(Lifetime lifetime) const
+{
+	RdReactiveBase::init(lifetime);
+	get_wire()->advise(lifetime, this);
+}
+
+void RdChunkedReactiveBase::on_wire_received(Buffer buffer) const
+{
+	reader.on_wire_received(buffer);
+}
+
+void RdChunkedReactiveBase::on_wire_stream_aborted(int32_t stream, int64_t received, int64_t total) const
+{
+	RD_LOG_WARN(logReceived, "RECV stream {} of {} aborted after {} of {} bytes", stream, to_string(rdid), received, total);
+}
+
+ChunkedMessageWriter RdChunkedReactiveBase::send_chunked(int64_t total, int32_t chunk_size) const
+{
+	assert_bound();
+	return ChunkedMessageWriter(get_wire(), rdid, next_stream++, total, chunk_size);
+}
+}	 // namespace rd
@@ -0,0 +1,63 @@
+#ifndef RD_CPP_RDCHUNKEDREACTIVEBASE_H
+#define RD_CPP_RDCHUNKEDREACTIVEBASE_H
+
+#include "base/RdReactiveBase.h"
+#include "wire/ChunkedMessage.h"
+
+#include <atomic>
+
+#include <rd_framework_export.h>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4250)
+#pragma warning(disable : 4251)
+#endif
+
+namespace rd
+{
+/**
+ * \brief Opt-in streaming for reactive entities with payloads too large to send as one message. The sender writes a
+ * payload with [send_chunked], the receiver gets it in [on_wire_chunk_received] piece by piece as the messages
+ * arrive, so memory on both sides is bounded by the chunk size rather than by the payload.
+ */
+class RD_FRAMEWORK_API RdChunkedReactiveBase : public RdReactiveBase
+{
+private:
+	mutable ChunkedMessageReader reader;
+	mutable std::atomic<int32_t> next_stream{0};
+
+protected:
+	/**
+	 * \brief Next piece of a payload, called on [get_wire_scheduler] in order.
+	 */
+	virtual void on_wire_chunk_received(WireChunk const& chunk) const = 0;
+
+	/**
+	 * \brief The rest of the payload won't arrive, e.g. a chunk was evicted by the send window of the wire.
+	 */
+	virtual void on_wire_stream_aborted(int32_t stream, int64_t received, int64_t total) const;
+
+public:
+	// region ctor/dtor
+
+	RdChunkedReactiveBase();
+
+	virtual ~RdChunkedReactiveBase() = default;
+	// endregion
+
+	void init(Lifetime lifetime) const override;
+
+	void on_wire_received(Buffer buffer) const final;
+
+	/**
+	 * \brief Starts a payload of [total] bytes, which must be written completely and finished.
+	 */
+	ChunkedMessageWriter send_chunked(int64_t total, int32_t chunk_size = ChunkedMessageWriter::DEFAULT_CHUNK_SIZE) const;
+};
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_RDCHUNKEDREACTIVEBASE_H
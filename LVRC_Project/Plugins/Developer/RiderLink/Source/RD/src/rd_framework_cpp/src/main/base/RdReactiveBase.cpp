@@ -1,22 +1,24 @@
 #include "RdReactiveBase.h"
 
-#include "spdlog/sinks/stdout_color_sinks.h"
+#include "util/core_log.h"
 
 namespace rd
 {
-static std::shared_ptr<spdlog::logger> logReceived =
-	spdlog::stderr_color_mt<spdlog::synchronous_factory>("logReceived", spdlog::color_mode::automatic);
-std::shared_ptr<spdlog::logger> logSend =
-	spdlog::stderr_color_mt<spdlog::synchronous_factory>("logSend", spdlog::color_mode::automatic);
+std::shared_ptr<spdlog::logger> RdReactiveBase::logReceived =
+	util::create_logger("logReceived");
+std::shared_ptr<spdlog::logger> RdReactiveBase::logSend =
+	util::create_logger("logSend");
 
 RdReactiveBase::RdReactiveBase(RdReactiveBase&& other) : RdBindableBase(std::move(other)) /*, async(other.async)*/
 {
 	async = other.async;
+	lane = other.lane;
 }
 
 RdReactiveBase& RdReactiveBase::operator=(RdReactiveBase&& other)
 {
 	async = other.async;
+	lane = other.lane;
 	static_cast<RdBindableBase&>(*this) = std::move(other);
 	return *this;
 }
@@ -56,4 +58,10 @@ IScheduler* RdReactiveBase::get_wire_scheduler() const
 {
 	return get_default_scheduler();
 }
+
+void RdReactiveBase::set_lane(SchedulerLane value)
+{
+	RD_ASSERT_MSG(!is_bound(), "lane of RdReactiveBase with id:" + to_string(rdid) + " is set after it's bound");
+	lane = value;
+}
 }	 // namespace rd
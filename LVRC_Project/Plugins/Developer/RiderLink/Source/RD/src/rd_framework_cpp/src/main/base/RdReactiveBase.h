@@ -27,6 +27,13 @@ class Serializers;
 
 class RD_FRAMEWORK_API RdReactiveBase : public RdBindableBase, public IRdReactive
 {
+protected:
+	/**
+	 * \brief Entity traffic loggers, registered in spdlog as "logSend" and "logReceived".
+	 */
+	static std::shared_ptr<spdlog::logger> logSend;
+	static std::shared_ptr<spdlog::logger> logReceived;
+
 public:
 	// region ctor/dtor
 
@@ -51,6 +58,12 @@ public:
 
 	IScheduler* get_wire_scheduler() const override;
 
+	/**
+	 * \brief Sets [lane] of incoming messages. The wire reads it on its own thread, so it can be set only before the
+	 * object is bound.
+	 */
+	void set_lane(SchedulerLane value);
+
 	void assert_threading() const;
 
 	void assert_bound() const;
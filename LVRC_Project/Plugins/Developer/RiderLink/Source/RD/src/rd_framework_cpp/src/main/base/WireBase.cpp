@@ -6,4 +6,14 @@ void WireBase::advise(Lifetime lifetime, const IRdReactive* entity) const
 {
 	message_broker.advise_on(lifetime, entity);
 }
+
+void WireBase::set_mailbox_limits(MessageBroker::MailboxLimits limits)
+{
+	message_broker.set_mailbox_limits(limits);
+}
+
+MessageBroker::MailboxStats WireBase::get_mailbox_stats() const
+{
+	return message_broker.get_mailbox_stats();
+}
 }	 // namespace rd
@@ -26,6 +26,13 @@ public:
 	// endregion
 
 	void advise(Lifetime lifetime, IRdReactive const* entity) const override;
+
+	/**
+	 * \brief Bounds messages which arrive for ids before anything subscribes to them, see [MessageBroker::MailboxLimits].
+	 */
+	void set_mailbox_limits(MessageBroker::MailboxLimits limits);
+
+	MessageBroker::MailboxStats get_mailbox_stats() const;
 };
 }	 // namespace rd
 
@@ -20,8 +20,11 @@ ExtWire::ExtWire()
 					// auto[id, payload] = std::move(sendQ.front());
 					auto it = std::move(sendQ.front());
 					sendQ.pop();
-					realWire->send(
-						it.first, [payload = std::move(it.second)](Buffer& buffer) { buffer.write_byte_array_raw(payload); });
+					// the payload is written before the real wire has chosen the encoding, so it's sent as written
+					realWire->send(it.first, [payload = std::move(it.second)](Buffer& buffer) {
+						buffer.set_compact(false);
+						buffer.write_byte_array_raw(payload);
+					});
 				}
 			}
 		}
@@ -47,4 +50,19 @@ void ExtWire::send(RdId const& id, std::function<void(Buffer& buffer)> writer) c
 	}
 	realWire->send(id, std::move(writer));
 }
+
+bool ExtWire::try_send(RdId const& id, std::function<void(Buffer& buffer)> writer) const
+{
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		if (!sendQ.empty() || !connected.get())
+		{
+			Buffer buffer;
+			writer(buffer);
+			sendQ.emplace(id, buffer.getRealArray());
+			return true;
+		}
+	}
+	return realWire->try_send(id, std::move(writer));
+}
 }	 // namespace rd
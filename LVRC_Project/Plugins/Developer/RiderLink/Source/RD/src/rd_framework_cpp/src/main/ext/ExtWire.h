@@ -32,6 +32,8 @@ public:
 	void advise(Lifetime lifetime, IRdReactive const* entity) const override;
 
 	void send(RdId const& id, std::function<void(Buffer& buffer)> writer) const override;
+
+	bool try_send(RdId const& id, std::function<void(Buffer& buffer)> writer) const override;
 };
 }	 // namespace rd
 #if defined(_MSC_VER)
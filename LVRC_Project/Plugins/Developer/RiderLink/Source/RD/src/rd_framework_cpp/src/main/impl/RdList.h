@@ -96,15 +96,15 @@ public:
 				get_wire()->send(rdid, [this, e](Buffer& buffer) {
 					Op op = static_cast<Op>(e.v.index());
 
-					buffer.write_integral<int64_t>(static_cast<int64_t>(op) | (next_version++ << versionedFlagShift));
-					buffer.write_integral<int32_t>(static_cast<const int32_t>(e.get_index()));
+					buffer.write_compact<int64_t>(static_cast<int64_t>(op) | (next_version++ << versionedFlagShift));
+					buffer.write_compact<int32_t>(static_cast<const int32_t>(e.get_index()));
 
 					T const* new_value = e.get_new_value();
 					if (new_value)
 					{
 						S::write(this->get_serialization_context(), buffer, *new_value);
 					}
-					spdlog::get("logSend")->trace(logmsg(op, next_version - 1, e.get_index(), new_value));
+					RD_LOG_TRACE(logSend, "{}", logmsg(op, next_version - 1, e.get_index(), new_value));
 				});
 			});
 		});
@@ -121,10 +121,10 @@ public:
 
 	void on_wire_received(Buffer buffer) const override
 	{
-		int64_t header = (buffer.read_integral<int64_t>());
+		int64_t header = (buffer.read_compact<int64_t>());
 		int64_t version = header >> versionedFlagShift;
 		Op op = static_cast<Op>((header & ((1 << versionedFlagShift) - 1L)));
-		int32_t index = (buffer.read_integral<int32_t>());
+		int32_t index = (buffer.read_compact<int32_t>());
 
 		RD_ASSERT_MSG(version == next_version,
 			("Version conflict for " + to_string(location) + "}. Expected version " + std::to_string(next_version) + ", received " +
@@ -138,7 +138,7 @@ public:
 			{
 				auto value = S::read(this->get_serialization_context(), buffer);
 
-				spdlog::get("logReceived")->trace(logmsg(op, version, index, &(wrapper::get<T>(value))));
+				RD_LOG_TRACE(logReceived, "{}", logmsg(op, version, index, &(wrapper::get<T>(value))));
 
 				(index < 0) ? list::add(std::move(value)) : list::add(static_cast<size_t>(index), std::move(value));
 				break;
@@ -147,14 +147,14 @@ public:
 			{
 				auto value = S::read(this->get_serialization_context(), buffer);
 
-				spdlog::get("logReceived")->trace(logmsg(op, version, index, &(wrapper::get<T>(value))));
+				RD_LOG_TRACE(logReceived, "{}", logmsg(op, version, index, &(wrapper::get<T>(value))));
 
 				list::set(static_cast<size_t>(index), std::move(value));
 				break;
 			}
 			case Op::REMOVE:
 			{
-				spdlog::get("logReceived")->trace(logmsg(op, version, index));
+				RD_LOG_TRACE(logReceived, "{}", logmsg(op, version, index));
 
 				list::removeAt(static_cast<size_t>(index));
 				break;
@@ -107,14 +107,14 @@ public:
 					int32_t versionedFlag = ((is_master ? 1 : 0)) << versionedFlagShift;
 					Op op = static_cast<Op>(e.v.index());
 
-					buffer.write_integral<int32_t>(static_cast<int32_t>(op) | versionedFlag);
+					buffer.write_compact<int32_t>(static_cast<int32_t>(op) | versionedFlag);
 
 					int64_t version = is_master ? ++next_version : 0L;
 
 					if (is_master)
 					{
 						pendingForAck.emplace(e.get_key(), version);
-						buffer.write_integral(version);
+						buffer.write_compact(version);
 					}
 
 					KS::write(this->get_serialization_context(), buffer, *e.get_key());
@@ -125,7 +125,7 @@ public:
 						VS::write(this->get_serialization_context(), buffer, *new_value);
 					}
 
-					spdlog::get("logSend")->trace("SEND{}", logmsg(op, next_version - 1, e.get_key(), new_value));
+					RD_LOG_TRACE(logSend, "SEND{}", logmsg(op, next_version - 1, e.get_key(), new_value));
 				});
 			});
 		});
@@ -140,11 +140,11 @@ public:
 
 	void on_wire_received(Buffer buffer) const override
 	{
-		int32_t header = buffer.read_integral<int32_t>();
+		int32_t header = buffer.read_compact<int32_t>();
 		bool msg_versioned = (header >> versionedFlagShift) != 0;
 		Op op = static_cast<Op>(header & ((1 << versionedFlagShift) - 1));
 
-		int64_t version = msg_versioned ? buffer.read_integral<int64_t>() : 0;
+		int64_t version = msg_versioned ? buffer.read_compact<int64_t>() : 0;
 
 		WK key = KS::read(this->get_serialization_context(), buffer);
 
@@ -186,16 +186,18 @@ public:
 			}
 			if (errmsg.empty())
 			{
-				spdlog::get("logReceived")->trace(logmsg(Op::ACK, version, &(wrapper::get<K>(key))));
+				RD_LOG_TRACE(logReceived, "{}", logmsg(Op::ACK, version, &(wrapper::get<K>(key))));
 			}
 			else
 			{
-				spdlog::get("logReceived")->error(logmsg(Op::ACK, version, &(wrapper::get<K>(key))) + " >> " + errmsg);
+				RD_LOG_ERROR(logReceived, "{}", logmsg(Op::ACK, version, &(wrapper::get<K>(key))) + " >> " + errmsg);
 			}
 		}
 		else
 		{
+			// written the way the counterpart writes, since it's read back the same way
 			Buffer serialized_key;
+			serialized_key.set_compact(buffer.is_compact());
 			KS::write(this->get_serialization_context(), serialized_key, wrapper::get<K>(key));
 
 			bool is_put = (op == Op::ADD || op == Op::UPDATE);
@@ -207,7 +209,7 @@ public:
 
 			if (msg_versioned || !is_master || pendingForAck.count(key) == 0)
 			{
-				spdlog::get("logReceived")->trace("RECV{}", logmsg(op, version, &(wrapper::get<K>(key)), value));
+				RD_LOG_TRACE(logReceived, "RECV{}", logmsg(op, version, &(wrapper::get<K>(key)), value));
 				if (value.has_value())
 				{
 					map::set(std::move(key), *std::move(value));
@@ -219,23 +221,24 @@ public:
 			}
 			else
 			{
-				spdlog::get("logReceived")->trace("{} >> REJECTED", logmsg(op, version, &(wrapper::get<K>(key)), value));
+				RD_LOG_TRACE(logReceived, "{} >> REJECTED", logmsg(op, version, &(wrapper::get<K>(key)), value));
 			}
 
 			if (msg_versioned)
 			{
 				auto writer =
 					util::make_shared_function([version, serialized_key = std::move(serialized_key)](Buffer& innerBuffer) mutable {
-						innerBuffer.write_integral<int32_t>((1u << versionedFlagShift) | static_cast<int32_t>(Op::ACK));
-						innerBuffer.write_integral<int64_t>(version);
+						innerBuffer.set_compact(serialized_key.is_compact());
+						innerBuffer.write_compact<int32_t>((1u << versionedFlagShift) | static_cast<int32_t>(Op::ACK));
+						innerBuffer.write_compact<int64_t>(version);
 						// KS::write(this->get_serialization_context(), innerBuffer, wrapper::get<K>(key));
-						innerBuffer.write_byte_array_raw(serialized_key.getArray());
+						innerBuffer.write_byte_array_raw(serialized_key.getRealArray());
 						// logSend.trace(logmsg(Op::ACK, version, serialized_key));
 					});
 				get_wire()->send(rdid, std::move(writer));
 				if (is_master)
 				{
-					spdlog::get("logReceived")->error("Both ends are masters: {}", to_string(location));
+					RD_LOG_ERROR(logReceived, "Both ends are masters: {}", to_string(location));
 				}
 			}
 		}
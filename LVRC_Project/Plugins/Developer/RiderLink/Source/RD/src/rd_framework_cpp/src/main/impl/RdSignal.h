@@ -82,7 +82,7 @@ public:
 	void on_wire_received(Buffer buffer) const override
 	{
 		auto value = S::read(this->get_serialization_context(), buffer);
-		spdlog::get("logReceived")->trace("RECV{}", logmsg(wrapper::get<T>(value)));
+		RD_LOG_TRACE(logReceived, "RECV{}", logmsg(wrapper::get<T>(value)));
 
 		signal.fire(wrapper::get<T>(value));
 	}
@@ -103,12 +103,33 @@ public:
 		if (async && !is_bound()) return;
 
 		get_wire()->send(rdid, [this, &value](Buffer& buffer) {
-			spdlog::get("logSend")->trace("SEND{}", logmsg(value));
+			RD_LOG_TRACE(logSend, "SEND{}", logmsg(value));
 			S::write(get_serialization_context(), buffer, value);
 		});
 		signal.fire(value);
 	}
 
+	/**
+	 * \brief Fires [value] unless the wire is congested. Local subscribers get the value in any case.
+	 * \return false if the value was dropped instead of being sent.
+	 */
+	bool try_fire(T const& value) const override
+	{
+		if (!async)
+		{
+			assert_threading();
+		}
+
+		if (async && !is_bound()) return false;
+
+		const bool sent = get_wire()->try_send(rdid, [this, &value](Buffer& buffer) {
+			RD_LOG_TRACE(logSend, "SEND{}", logmsg(value));
+			S::write(get_serialization_context(), buffer, value);
+		});
+		signal.fire(value);
+		return sent;
+	}
+
 	using ISource<T>::advise;
 
 	void advise(Lifetime lifetime, std::function<void(T const&)> handler) const override
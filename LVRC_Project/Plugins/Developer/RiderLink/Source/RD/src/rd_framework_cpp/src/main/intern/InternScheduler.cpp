@@ -25,4 +25,9 @@ bool InternScheduler::is_active() const
 {
 	return active_counts > 0;
 }
+
+bool InternScheduler::is_inline() const
+{
+	return true;
+}
 }	 // namespace rd
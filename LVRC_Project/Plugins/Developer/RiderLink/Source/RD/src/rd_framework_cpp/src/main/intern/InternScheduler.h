@@ -25,6 +25,8 @@ public:
 	void flush() override;
 
 	bool is_active() const override;
+
+	bool is_inline() const override;
 };
 }	 // namespace rd
 
@@ -2,8 +2,10 @@
 
 #include "protocol/Buffer.h"
 
+#include <stdexcept>
 #include <string>
 #include <algorithm>
+#include <cstring>
 
 namespace rd
 {
@@ -57,9 +59,46 @@ void Buffer::write(const word_t* src, size_t size)
 	offset += size;
 }
 
+uint64_t Buffer::read_varint(unsigned bits)
+{
+	uint64_t result = 0;
+	for (unsigned shift = 0; shift < bits; shift += 7)
+	{
+		check_available(1);
+		const word_t byte = data_[offset++];
+		const uint64_t group = byte & 0x7F;
+		// the last group holds only the bits left, the rest would be cut off
+		if (bits - shift < 7 && (group >> (bits - shift)) != 0)
+		{
+			throw std::out_of_range(
+				"Varint in buffer at position " + std::to_string(offset - 1) + " doesn't fit into " + std::to_string(bits) + " bits");
+		}
+		result |= group << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return result;
+		}
+	}
+	throw std::out_of_range(
+		"Varint in buffer at position " + std::to_string(offset) + " is longer than " + std::to_string(bits) + " bits");
+}
+
+void Buffer::write_varint(uint64_t value)
+{
+	// 64 bits take at most 10 groups of 7
+	require_available(10);
+	while (value >= 0x80)
+	{
+		data_[offset++] = static_cast<word_t>(value | 0x80);
+		value >>= 7;
+	}
+	data_[offset++] = static_cast<word_t>(value);
+}
+
 void Buffer::require_available(size_t moreSize)
 {
-	if (offset + moreSize >= size())
+	// size of [data_] is the capacity of the buffer, [offset] is how much of it is used
+	if (offset + moreSize > size())
 	{
 		const size_t new_size = (std::max)(size() * 2, offset + moreSize);
 		data_.resize(new_size);
@@ -71,6 +110,16 @@ void Buffer::rewind()
 	set_position(0);
 }
 
+bool Buffer::is_compact() const
+{
+	return compact;
+}
+
+void Buffer::set_compact(bool value)
+{
+	compact = value;
+}
+
 Buffer::ByteArray Buffer::getArray() const&
 {
 	return data_;
@@ -132,21 +181,23 @@ std::vector<uint8_t> v(value.begin(), value.end());
 writeArray<uint8_t>(v);
 }*/
 
+// units of a string view aren't aligned, they are copied bytewise rather than read through the view
 template <int>
 std::wstring read_wstring_spec(Buffer& buffer)
 {
-	auto v = buffer.read_array<std::vector, uint16_t>();
-	return std::wstring(v.begin(), v.end());
+	const auto v = buffer.read_string_view();
+	std::vector<uint16_t> units(v.size());
+	std::memcpy(units.data(), v.data(), sizeof(uint16_t) * v.size());
+	return std::wstring(units.begin(), units.end());
 }
 
 template <>
 std::wstring read_wstring_spec<2>(Buffer& buffer)
 {
-	const int32_t len = buffer.read_integral<int32_t>();
-	RD_ASSERT_MSG(len >= 0, "read null string(length =" + std::to_string(len) + ")");
+	const auto v = buffer.read_string_view();
 	std::wstring result;
-	result.resize(len);
-	buffer.read(reinterpret_cast<Buffer::word_t*>(&result[0]), sizeof(wchar_t) * len);
+	result.resize(v.size());
+	std::memcpy(&result[0], v.data(), sizeof(wchar_t) * v.size());
 	return result;
 }
 
@@ -165,7 +216,7 @@ void write_wstring_spec(Buffer& buffer, wstring_view value)
 template <>
 void write_wstring_spec<2>(Buffer& buffer, wstring_view value)
 {
-	buffer.write_integral<int32_t>(static_cast<int32_t>(value.size()));
+	buffer.write_compact<int32_t>(static_cast<int32_t>(value.size()));
 	buffer.write(reinterpret_cast<Buffer::word_t const*>(value.data()), sizeof(wchar_t) * value.size());
 }
 
@@ -176,20 +227,24 @@ void Buffer::write_wstring(std::wstring const& value)
 
 void Buffer::write_char16_string(const uint16_t* data, size_t len)
 {
-	write_integral<int32_t>(static_cast<int32_t>(len));
+	write_compact<int32_t>(static_cast<int32_t>(len));
 	write(reinterpret_cast<word_t const*>(data), 2 * len);
 }
 
 uint16_t* Buffer::read_char16_string()
 {	
-	const int32_t len = read_integral<int32_t>();
-	RD_ASSERT_MSG(len >= 0, "read null string(length =" + std::to_string(len) + ")");
-	uint16_t * result = new uint16_t[len+1];
-	read(reinterpret_cast<Buffer::word_t*>(&result[0]), sizeof(uint16_t) * len);
-	result[len] = 0;
+	const auto v = read_string_view();
+	uint16_t * result = new uint16_t[v.size() + 1];
+	std::memcpy(result, v.data(), sizeof(uint16_t) * v.size());
+	result[v.size()] = 0;
 	return result;
 }
 
+Buffer::View<uint16_t> Buffer::read_string_view()
+{
+	return read_array_view<uint16_t>();
+}
+
 void Buffer::write_wstring(wstring_view value)
 {
 	write_wstring_spec<sizeof(wchar_t)>(*this, value);
@@ -240,7 +295,7 @@ void Buffer::write_char(wchar_t value)
 
 void Buffer::read_byte_array(ByteArray& array)
 {
-	const int32_t length = read_integral<int32_t>();
+	const int32_t length = read_compact<int32_t>();
 	array.resize(length);
 	read_byte_array_raw(array);
 }
@@ -16,6 +16,8 @@
 #include <type_traits>
 #include <functional>
 #include <memory>
+#include <cassert>
+#include <cstring>
 
 #include <rd_framework_export.h>
 
@@ -31,7 +33,8 @@ public:
 
 	using word_t = uint8_t;
 
-	using Allocator = std::allocator<word_t>;
+	// grown storage is written right away, zeroing it first would only cost a memset
+	using Allocator = default_init_allocator<word_t>;
 
 	using ByteArray = std::vector<word_t, Allocator>;
 
@@ -46,15 +49,210 @@ private:
 
 	size_t offset = 0;
 
+	bool compact = false;
+
 	// read
 	void read(word_t* dst, size_t size);
 
+	/**
+	 * \brief Reads a varint of a [bits] wide integer, throws if it's longer or its value is wider than that.
+	 */
+	uint64_t read_varint(unsigned bits);
+
 	// write
 	void write(const word_t* src, size_t size);
 
+	void write_varint(uint64_t value);
+
 	size_t size() const;
 
 public:
+	/**
+	 * \brief Writes a run of fixed-size fields, e.g. of a generated struct, after reserving their total [size] once:
+	 * the fields are then copied without checks of their own. Writing more than [size] is caught in debug builds only.
+	 * The buffer can be used as usual meanwhile, its position moves along with the cursor.
+	 */
+	class WriteCursor
+	{
+	public:
+		// region ctor/dtor
+
+		WriteCursor(Buffer& buffer, size_t size) : buffer(buffer), end(buffer.offset + size)
+		{
+			buffer.require_available(size);
+		}
+
+		WriteCursor(WriteCursor const&) = delete;
+
+		WriteCursor& operator=(WriteCursor const&) = delete;
+		// endregion
+
+		template <typename T, typename = typename std::enable_if_t<std::is_integral<T>::value>>
+		void write_integral(T const& value)
+		{
+			put(&value, sizeof(T));
+		}
+
+		template <typename T, typename = typename std::enable_if_t<std::is_floating_point<T>::value>>
+		void write_floating_point(T const& value)
+		{
+			put(&value, sizeof(T));
+		}
+
+		void write_bool(bool value)
+		{
+			write_integral<word_t>(value ? 1 : 0);
+		}
+
+		template <typename T, typename = typename std::enable_if_t<util::is_enum_v<T>>>
+		void write_enum(T const& x)
+		{
+			write_integral<int32_t>(static_cast<int32_t>(x));
+		}
+
+		/**
+		 * \return bytes of the reserved size which are left.
+		 */
+		size_t remaining() const
+		{
+			return end - buffer.offset;
+		}
+
+	private:
+		Buffer& buffer;
+		const size_t end;
+
+		void put(void const* src, size_t size)
+		{
+			assert(buffer.offset + size <= end);
+			std::memcpy(buffer.data_.data() + buffer.offset, src, size);
+			buffer.offset += size;
+		}
+	};
+
+	/**
+	 * \brief Reads a run of fixed-size fields written by [WriteCursor] after checking once that their total [size] is
+	 * available, throws [std::out_of_range] otherwise.
+	 */
+	class ReadCursor
+	{
+	public:
+		// region ctor/dtor
+
+		ReadCursor(Buffer& buffer, size_t size) : buffer(buffer), end(buffer.offset + size)
+		{
+			buffer.check_available(size);
+		}
+
+		ReadCursor(ReadCursor const&) = delete;
+
+		ReadCursor& operator=(ReadCursor const&) = delete;
+		// endregion
+
+		template <typename T, typename = typename std::enable_if_t<std::is_integral<T>::value, T>>
+		T read_integral()
+		{
+			T result;
+			take(&result, sizeof(T));
+			return result;
+		}
+
+		template <typename T, typename = typename std::enable_if_t<std::is_floating_point<T>::value, T>>
+		T read_floating_point()
+		{
+			T result;
+			take(&result, sizeof(T));
+			return result;
+		}
+
+		bool read_bool()
+		{
+			const auto res = read_integral<word_t>();
+			RD_ASSERT_MSG(res == 0 || res == 1, "get byte:" + std::to_string(res) + " instead of 0 or 1")
+			return res == 1;
+		}
+
+		template <typename T, typename = typename std::enable_if_t<util::is_enum_v<T>>>
+		T read_enum()
+		{
+			return static_cast<T>(read_integral<int32_t>());
+		}
+
+		/**
+		 * \return bytes of the reserved size which are left.
+		 */
+		size_t remaining() const
+		{
+			return end - buffer.offset;
+		}
+
+	private:
+		Buffer& buffer;
+		const size_t end;
+
+		void take(void* dst, size_t size)
+		{
+			assert(buffer.offset + size <= end);
+			std::memcpy(dst, buffer.data_.data() + buffer.offset, size);
+			buffer.offset += size;
+		}
+	};
+
+	/**
+	 * \brief Elements of an array which are left in the memory of the buffer, see [read_array_view]. It's valid as long as
+	 * the buffer isn't written, moved or destroyed, so the data is either inspected right away or copied once into its
+	 * final container. Like the rest of the buffer, the elements aren't necessarily aligned: wider than a byte, they are
+	 * copied out with memcpy rather than read through [data] or the iterators.
+	 */
+	template <typename T>
+	class View
+	{
+	public:
+		// region ctor/dtor
+
+		View() = default;
+
+		View(T const* pointer, size_t length) : pointer(pointer), length(length)
+		{
+		}
+		// endregion
+
+		T const* data() const
+		{
+			return pointer;
+		}
+
+		size_t size() const
+		{
+			return length;
+		}
+
+		bool empty() const
+		{
+			return length == 0;
+		}
+
+		T const* begin() const
+		{
+			return pointer;
+		}
+
+		T const* end() const
+		{
+			return pointer + length;
+		}
+
+		T const& operator[](size_t index) const
+		{
+			assert(index < length);
+			return pointer[index];
+		}
+
+	private:
+		T const* pointer = nullptr;
+		size_t length = 0;
+	};
+
 	// region ctor/dtor
 
 	Buffer();
@@ -83,39 +281,79 @@ public:
 
 	void rewind();
 
+	/**
+	 * \brief Whether integrals written with [write_compact], lengths and enums take only as many bytes as their value
+	 * needs: LEB128 with zigzag for signed types, as opposed to their full width. Both sides of a message must agree on it,
+	 * so it's chosen by the wire for the whole message and may be changed only before the payload is written.
+	 */
+	bool is_compact() const;
+
+	void set_compact(bool value);
+
+	template <typename T, typename = typename std::enable_if_t<std::is_integral<T>::value, T>>
+	T read_compact()
+	{
+		if (!compact || sizeof(T) == 1)
+		{
+			return read_integral<T>();
+		}
+		const uint64_t encoded = read_varint(8 * sizeof(T));
+		if (std::is_signed<T>::value)
+		{
+			return static_cast<T>(static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1));
+		}
+		return static_cast<T>(encoded);
+	}
+
+	template <typename T, typename = typename std::enable_if_t<std::is_integral<T>::value>>
+	void write_compact(T const& value)
+	{
+		if (!compact || sizeof(T) == 1)
+		{
+			write_integral<T>(value);
+			return;
+		}
+		if (std::is_signed<T>::value)
+		{
+			const auto extended = static_cast<int64_t>(value);
+			write_varint((static_cast<uint64_t>(extended) << 1) ^ static_cast<uint64_t>(extended >> 63));
+			return;
+		}
+		write_varint(static_cast<uint64_t>(value));
+	}
+
+	// fixed-size fields, e.g. of generated structs, go through a cursor of their own size: one check and a memcpy
+	// of a constant size instead of the generic [read]/[write]
+
 	template <typename T, typename = typename std::enable_if_t<std::is_integral<T>::value, T>>
 	T read_integral()
 	{
-		T result;
-		read(reinterpret_cast<word_t*>(&result), sizeof(T));
-		return result;
+		return ReadCursor(*this, sizeof(T)).read_integral<T>();
 	}
 
 	template <typename T, typename = typename std::enable_if_t<std::is_integral<T>::value>>
 	void write_integral(T const& value)
 	{
-		write(reinterpret_cast<word_t const*>(&value), sizeof(T));
+		WriteCursor(*this, sizeof(T)).write_integral<T>(value);
 	}
 
 	template <typename T, typename = typename std::enable_if_t<std::is_floating_point<T>::value, T>>
 	T read_floating_point()
 	{
-		T result;
-		read(reinterpret_cast<word_t*>(&result), sizeof(T));
-		return result;
+		return ReadCursor(*this, sizeof(T)).read_floating_point<T>();
 	}
 
 	template <typename T, typename = typename std::enable_if_t<std::is_floating_point<T>::value>>
 	void write_floating_point(T const& value)
 	{
-		write(reinterpret_cast<word_t const*>(&value), sizeof(T));
+		WriteCursor(*this, sizeof(T)).write_floating_point<T>(value);
 	}
 
 	template <template <class, class> class C, typename T, typename A = allocator<T>,
 		typename = typename std::enable_if_t<util::is_pod_v<T>>>
 	C<T, A> read_array()
 	{
-		int32_t len = read_integral<int32_t>();
+		int32_t len = read_compact<int32_t>();
 		RD_ASSERT_MSG(len >= 0, "read null array(length = " + std::to_string(len) + ")");
 		C<T, A> result;
 		using rd::resize;
@@ -127,10 +365,25 @@ public:
 		return result;
 	}
 
+	/**
+	 * \brief Reads an array written by [write_array] without copying it, see [View].
+	 */
+	template <typename T, typename = typename std::enable_if_t<util::is_pod_v<T>>>
+	View<T> read_array_view()
+	{
+		const int32_t len = read_compact<int32_t>();
+		RD_ASSERT_MSG(len >= 0, "read null array(length = " + std::to_string(len) + ")");
+		const size_t bytes = sizeof(T) * static_cast<size_t>(len);
+		check_available(bytes);
+		View<T> result(reinterpret_cast<T const*>(current_pointer()), static_cast<size_t>(len));
+		offset += bytes;
+		return result;
+	}
+
 	template <template <class, class> class C, typename T, typename A = allocator<value_or_wrapper<T>>>
 	C<value_or_wrapper<T>, A> read_array(std::function<value_or_wrapper<T>()> reader)
 	{
-		int32_t len = read_integral<int32_t>();
+		int32_t len = read_compact<int32_t>();
 		C<value_or_wrapper<T>, A> result;
 		using rd::resize;
 		resize(result, len);
@@ -147,7 +400,7 @@ public:
 	{
 		using rd::size;
 		const int32_t& len = rd::size(container);
-		write_integral<int32_t>(static_cast<int32_t>(len));
+		write_compact<int32_t>(static_cast<int32_t>(len));
 		if (len > 0)
 		{
 			write(reinterpret_cast<word_t const*>(&container[0]), sizeof(T) * len);
@@ -159,7 +412,7 @@ public:
 	void write_array(C<T, A> const& container, std::function<void(T const&)> writer)
 	{
 		using rd::size;
-		write_integral<int32_t>(size(container));
+		write_compact<int32_t>(static_cast<int32_t>(size(container)));
 		for (auto const& e : container)
 		{
 			writer(e);
@@ -170,7 +423,7 @@ public:
 	void write_array(C<Wrapper<T>, A> const& container, std::function<void(T const&)> writer)
 	{
 		using rd::size;
-		write_integral<int32_t>(size(container));
+		write_compact<int32_t>(static_cast<int32_t>(size(container)));
 		for (auto const& e : container)
 		{
 			writer(*e);
@@ -199,6 +452,12 @@ public:
 
 	uint16_t * read_char16_string();
 
+	/**
+	 * \brief Reads UTF-16 code units of a string written by [write_wstring] or [write_char16_string] without copying them,
+	 * see [View].
+	 */
+	View<uint16_t> read_string_view();
+
 	std::wstring read_wstring();
 
 	void write_wstring(std::wstring const& value);
@@ -214,27 +473,27 @@ public:
 	template <typename T, typename = typename std::enable_if_t<util::is_enum_v<T>>>
 	T read_enum()
 	{
-		int32_t x = read_integral<int32_t>();
+		int32_t x = read_compact<int32_t>();
 		return static_cast<T>(x);
 	}
 
 	template <typename T, typename = typename std::enable_if_t<util::is_enum_v<T>>>
 	void write_enum(T const& x)
 	{
-		write_integral<int32_t>(static_cast<int32_t>(x));
+		write_compact<int32_t>(static_cast<int32_t>(x));
 	}
 
 	template <typename T, typename = typename std::enable_if_t<util::is_enum_v<T>>>
 	T read_enum_set()
 	{
-		int32_t x = read_integral<int32_t>();
+		int32_t x = read_compact<int32_t>();
 		return static_cast<T>(x);
 	}
 
 	template <typename T, typename = typename std::enable_if_t<util::is_enum_v<T>>>
 	void write_enum_set(T const& x)
 	{
-		write_integral<int32_t>(static_cast<int32_t>(x));
+		write_compact<int32_t>(static_cast<int32_t>(x));
 	}
 
 	template <typename T, typename F, typename = typename std::enable_if_t<util::is_same_v<typename std::result_of_t<F()>, T>>>
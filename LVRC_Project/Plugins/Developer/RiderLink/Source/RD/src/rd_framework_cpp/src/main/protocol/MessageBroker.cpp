@@ -1,11 +1,81 @@
 #include "protocol/MessageBroker.h"
 
-#include "spdlog/sinks/stdout_color_sinks.h"
+#include "scheduler/base/SchedulerMetrics.h"
+#include "task/ResponseBatch.h"
+#include "util/core_log.h"
+
+#include <algorithm>
+#include <iterator>
 
 namespace rd
 {
 std::shared_ptr<spdlog::logger> MessageBroker::logger =
-	spdlog::stderr_color_mt<spdlog::synchronous_factory>("logger", spdlog::color_mode::automatic);
+	util::create_logger("logger");
+
+constexpr size_t SubscriptionTable::SHARDS;
+
+namespace
+{
+// described only for the long-task reports of schedulers with metrics
+std::string origin_of(IScheduler const* scheduler, IRdReactive const* that)
+{
+	return scheduler->get_metrics() == nullptr ? std::string() : to_string(that->location);
+}
+
+std::string origin_of(IScheduler const* scheduler, RdId const& mailbox)
+{
+	return scheduler->get_metrics() == nullptr ? std::string() : "mailbox of " + to_string(mailbox);
+}
+}	 // namespace
+
+IRdReactive const* SubscriptionTable::find(RdId const& id) const
+{
+	const auto map = std::atomic_load(&shard_of(id).map);
+	if (map == nullptr)
+	{
+		return nullptr;
+	}
+	const auto it = map->find(id);
+	return it == map->end() ? nullptr : it->second;
+}
+
+void SubscriptionTable::add(RdId const& id, IRdReactive const* entity)
+{
+	Shard& shard = shard_of(id);
+	std::lock_guard<decltype(shard.write_lock)> guard(shard.write_lock);
+	auto map = shard.map == nullptr ? std::make_shared<map_t>() : std::make_shared<map_t>(*shard.map);
+	(*map)[id] = entity;
+	std::atomic_store(&shard.map, std::shared_ptr<map_t const>(std::move(map)));
+}
+
+void SubscriptionTable::remove(RdId const& id, IRdReactive const* entity)
+{
+	Shard& shard = shard_of(id);
+	std::lock_guard<decltype(shard.write_lock)> guard(shard.write_lock);
+	if (shard.map == nullptr)
+	{
+		return;
+	}
+	const auto it = shard.map->find(id);
+	if (it == shard.map->end() || it->second != entity)
+	{
+		return;
+	}
+	auto map = std::make_shared<map_t>(*shard.map);
+	map->erase(id);
+	std::atomic_store(&shard.map, std::shared_ptr<map_t const>(std::move(map)));
+}
+
+SubscriptionTable::Shard& SubscriptionTable::shard_of(RdId const& id)
+{
+	// ids are hashes already
+	return shards[static_cast<size_t>(id.get_hash()) % SHARDS];
+}
+
+SubscriptionTable::Shard const& SubscriptionTable::shard_of(RdId const& id) const
+{
+	return shards[static_cast<size_t>(id.get_hash()) % SHARDS];
+}
 
 static void execute(const IRdReactive* that, Buffer msg)
 {
@@ -19,28 +89,236 @@ void MessageBroker::invoke(const IRdReactive* that, Buffer msg, bool sync) const
 	{
 		execute(that, std::move(msg));
 	}
+	else if (that->get_wire_scheduler()->out_of_order_execution)
+	{
+		// a batch would run on a single thread, instead messages of one entity keep their order among themselves only
+		IScheduler* scheduler = that->get_wire_scheduler();
+		QueueOrigin origin(origin_of(scheduler, that));
+		auto action = [this, that, message = std::move(msg)]() mutable { deliver(that, std::move(message)); };
+		std::function<void()> function = util::make_shared_function(std::move(action));
+		scheduler->queue_ordered(that->rdid.get_hash(), std::move(function));
+	}
+	else if (is_batching() && !that->get_wire_scheduler()->is_inline())
+	{
+		// handlers of inline schedulers, e.g. interning, must still run before the messages which follow
+		add_to_batch(that->get_wire_scheduler(), that->get_lane(), PendingMessage{that, that->rdid, std::move(msg)});
+	}
 	else
 	{
-		auto action = [this, that, message = std::move(msg)]() mutable {
-			bool exists_id = false;
+		IScheduler* scheduler = that->get_wire_scheduler();
+		QueueOrigin origin(origin_of(scheduler, that));
+		auto action = [this, that, message = std::move(msg)]() mutable { deliver(that, std::move(message)); };
+		std::function<void()> function = util::make_shared_function(std::move(action));
+		scheduler->queue_in_lane(that->get_lane(), std::move(function));
+	}
+}
+
+void MessageBroker::deliver(const IRdReactive* that, Buffer msg) const
+{
+	if (subscriptions.find(that->rdid) == that)
+	{
+		execute(that, std::move(msg));
+	}
+	else
+	{
+		RD_LOG_TRACE(logger, "Disappeared Handler for Reactive entities with id: {}", to_string(that->rdid));
+	}
+}
+
+bool MessageBroker::admit(RdId const& id, Mq& mq) const
+{
+	const auto expired_before = Mq::clock_t::now() - mailbox_limits.ttl;
+	auto& waiting = mq.default_scheduler_messages;
+	while (!waiting.empty() && waiting.front().received < expired_before)
+	{
+		waiting.pop_front();
+		--mailbox_stats.waiting;
+		++mailbox_stats.dropped_expired;
+	}
+
+	if (waiting.size() < mailbox_limits.per_id && mailbox_stats.waiting < mailbox_limits.total)
+	{
+		return true;
+	}
+	++mailbox_stats.dropped_overflow;
+	if (mq.dropped++ == 0)
+	{
+		RD_LOG_WARN(logger, "Mailbox for id: {} is full, {} messages wait for it and {} in total", to_string(id), waiting.size(),
+			mailbox_stats.waiting);
+	}
+	return false;
+}
+
+void MessageBroker::replay(RdId id) const
+{
+	IRdReactive const* subscription = subscriptions.find(id);
+
+	std::vector<Buffer> messages;
+	size_t replayed = 0;
+	size_t unhandled = 0;
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		auto it = broker.find(id);
+		if (it == broker.end())
+		{
+			return;
+		}
+		auto& current = it->second;
+		const bool custom_scheduler = subscription != nullptr && !is_replayed_with(subscription);
+		const auto expired_before = Mq::clock_t::now() - mailbox_limits.ttl;
+		mailbox_stats.waiting -= current.default_scheduler_messages.size();
+		for (auto& waiting : current.default_scheduler_messages)
+		{
+			if (waiting.received < expired_before)
+			{
+				++mailbox_stats.dropped_expired;
+			}
+			else if (subscription == nullptr)
 			{
-				std::lock_guard<decltype(lock)> guard(lock);
-				exists_id = subscriptions.count(that->rdid) > 0;
+				++unhandled;
 			}
-			if (exists_id)
+			else if (custom_scheduler)
 			{
-				execute(that, std::move(message));
+				// under the lock: messages dispatched meanwhile go to [custom_scheduler_messages] after these
+				invoke(subscription, std::move(waiting.buffer));
+				++replayed;
 			}
 			else
 			{
-				logger->trace("Disappeared Handler for Reactive entities with id: {}", to_string(that->rdid));
+				messages.push_back(std::move(waiting.buffer));
+				++replayed;
 			}
-		};
-		std::function<void()> function = util::make_shared_function(std::move(action));
-		that->get_wire_scheduler()->queue(std::move(function));
+		}
+
+		for (auto& custom : current.custom_scheduler_messages)
+		{
+			RD_ASSERT_MSG(custom_scheduler, "require equals of wire and default schedulers")
+			invoke(subscription, std::move(custom));
+		}
+		mailbox_stats.replayed += replayed;
+		mailbox_stats.dropped_unhandled += unhandled;
+		broker.erase(it);
+		mailbox_stats.mailboxes = broker.size();
+	}
+
+	if (unhandled > 0)
+	{
+		RD_LOG_TRACE(logger, "No handler for id: {}, {} messages dropped", to_string(id), unhandled);
+	}
+	for (auto& message : messages)
+	{
+		// one failed handler mustn't lose the rest of the mailbox
+		try
+		{
+			invoke(subscription, std::move(message), true);
+		}
+		catch (std::exception const& e)
+		{
+			RD_LOG_ERROR(logger, "Handler for id: {} failed | {}", to_string(id), e.what());
+		}
 	}
 }
 
+void MessageBroker::deliver_all(pending_messages_t& messages) const
+{
+	// endpoints answer the requests of the group in one package once it's delivered
+	ResponseBatch responses;
+	for (auto& pending : messages)
+	{
+		// a failed handler mustn't lose the rest of the batch
+		try
+		{
+			if (pending.that == nullptr)
+			{
+				replay(pending.id);
+			}
+			else
+			{
+				deliver(pending.that, std::move(pending.message));
+			}
+		}
+		catch (std::exception const& e)
+		{
+			RD_LOG_ERROR(logger, "Handler for id: {} failed | {}", to_string(pending.id), e.what());
+		}
+	}
+}
+
+bool MessageBroker::is_batching() const
+{
+	return batching_thread.load() == std::this_thread::get_id();
+}
+
+bool MessageBroker::is_replayed_with(IRdReactive const* subscription) const
+{
+	return subscription->get_wire_scheduler() == default_scheduler && subscription->get_lane() == SchedulerLane::Interactive;
+}
+
+void MessageBroker::add_to_batch(IScheduler* scheduler, SchedulerLane lane, PendingMessage message) const
+{
+	auto it = std::find_if(batch.begin(), batch.end(),
+		[scheduler, lane](PendingGroup const& group) { return group.scheduler == scheduler && group.lane == lane; });
+	if (it == batch.end())
+	{
+		batch.push_back(PendingGroup{scheduler, lane, pending_messages_t{}});
+		it = std::prev(batch.end());
+	}
+	it->messages.push_back(std::move(message));
+}
+
+void MessageBroker::flush_batch() const
+{
+	if (!is_batching())
+	{
+		return;
+	}
+	// a synchronous scheduler delivers right away and may add to the batch again
+	while (!batch.empty())
+	{
+		auto groups = std::move(batch);
+		batch.clear();
+		for (auto& group : groups)
+		{
+			// a batch is reported by its first message
+			auto const& first = group.messages.front();
+			QueueOrigin origin(
+				first.that == nullptr ? origin_of(group.scheduler, first.id) : origin_of(group.scheduler, first.that));
+			auto action = [this, messages = std::move(group.messages)]() mutable { deliver_all(messages); };
+			std::function<void()> function = util::make_shared_function(std::move(action));
+			group.scheduler->queue_in_lane(group.lane, std::move(function));
+		}
+	}
+}
+
+MessageBroker::BatchScope::BatchScope(MessageBroker const& broker) : broker(broker)
+{
+	const auto current = std::this_thread::get_id();
+	std::thread::id none;
+	if (broker.batching_thread.load() == current || broker.batching_thread.compare_exchange_strong(none, current))
+	{
+		owner = true;
+		++broker.batch_depth;
+	}
+}
+
+MessageBroker::BatchScope::~BatchScope()
+{
+	if (!owner || --broker.batch_depth > 0)
+	{
+		return;
+	}
+	try
+	{
+		broker.flush_batch();
+	}
+	catch (std::exception const& e)
+	{
+		RD_LOG_ERROR(logger, "Failed to queue batch of messages | {}", e.what());
+	}
+	broker.batch.clear();
+	broker.batching_thread = std::thread::id();
+}
+
 MessageBroker::MessageBroker(IScheduler* defaultScheduler) : default_scheduler(defaultScheduler)
 {
 }
@@ -49,82 +327,68 @@ void MessageBroker::dispatch(RdId id, Buffer message) const
 {
 	RD_ASSERT_MSG(!id.isNull(), "id mustn't be null")
 
+	IRdReactive const* s = subscriptions.find(id);
+	if (s != nullptr && (is_replayed_with(s) || s->get_wire_scheduler()->out_of_order_execution))
+	{
+		// queued after the messages which wait in [broker] for the default scheduler, if any
+		invoke(s, std::move(message));
+		return;
+	}
+
 	{	 // synchronized recursively
 		std::lock_guard<decltype(lock)> guard(lock);
-		IRdReactive const* s = subscriptions[id];
 		if (s == nullptr)
 		{
 			auto it = broker.find(id);
 			if (it == broker.end())
 			{
 				it = broker.emplace(id, Mq{}).first;
+				mailbox_stats.mailboxes = broker.size();
 			}
 
-			broker[id].default_scheduler_messages.emplace(std::move(message));
-
-			auto action = [this, it, id]() mutable {
-				auto& current = it->second;
-				IRdReactive const* subscription = subscriptions[id];
-
-				optional<Buffer> message;
-				{
-					std::lock_guard<decltype(lock)> guard(lock);
-					if (!current.default_scheduler_messages.empty())
-					{
-						message = make_optional<Buffer>(std::move(current.default_scheduler_messages.front()));
-						current.default_scheduler_messages.pop();
-					}
-				}
-				if (subscription != nullptr)
-				{
-					if (message)
-					{
-						invoke(subscription, *std::move(message), subscription->get_wire_scheduler() == default_scheduler);
-					}
-				}
-				else
+			Mq& mq = it->second;
+			if (!admit(id, mq))
+			{
+				if (!mq.replay_queued && mq.default_scheduler_messages.empty())
 				{
-					logger->trace("No handler for id: {}", to_string(id));
+					broker.erase(it);
+					mailbox_stats.mailboxes = broker.size();
 				}
+				return;
+			}
+			mq.default_scheduler_messages.push_back(Mq::Message{std::move(message), Mq::clock_t::now()});
+			++mailbox_stats.waiting;
 
-				if (current.default_scheduler_messages.empty())
-				{
-					auto t = std::move(broker[id]);
-					broker.erase(id);
-					for (auto& it : t.custom_scheduler_messages)
-					{
-						RD_ASSERT_MSG(subscription->get_wire_scheduler() != default_scheduler,
-							"require equals of wire and default schedulers")
-						invoke(subscription, std::move(it));
-					}
-				}
-			};
+			// one replay for the whole mailbox
+			if (mq.replay_queued)
+			{
+				return;
+			}
+			mq.replay_queued = true;
+			if (is_batching() && !default_scheduler->is_inline())
+			{
+				add_to_batch(default_scheduler, SchedulerLane::Interactive, PendingMessage{nullptr, id, Buffer()});
+				return;
+			}
+			QueueOrigin origin(origin_of(default_scheduler, id));
+			auto action = [this, id]() mutable { replay(id); };
 			std::function<void()> function = util::make_shared_function(std::move(action));
 			default_scheduler->queue(std::move(function));
 		}
 		else
 		{
-			if (s->get_wire_scheduler() == default_scheduler || s->get_wire_scheduler()->out_of_order_execution)
+			auto it = broker.find(id);
+			if (it == broker.end())
 			{
 				invoke(s, std::move(message));
 			}
 			else
 			{
-				auto it = broker.find(id);
-				if (it == broker.end())
-				{
-					invoke(s, std::move(message));
-				}
-				else
-				{
-					Mq& mq = it->second;
-					mq.custom_scheduler_messages.push_back(std::move(message));
-				}
+				Mq& mq = it->second;
+				mq.custom_scheduler_messages.push_back(std::move(message));
 			}
 		}
 	}
-
-	//        }
 }
 
 void MessageBroker::advise_on(Lifetime lifetime, IRdReactive const* entity) const
@@ -138,9 +402,20 @@ void MessageBroker::advise_on(Lifetime lifetime, IRdReactive const* entity) cons
 	if (!lifetime->is_terminated())
 	{
 		auto key = entity->rdid;
-		IRdReactive const* value = entity;
-		subscriptions[key] = value;
-		lifetime->add_action([this, key]() { subscriptions.erase(key); });
+		subscriptions.add(key, entity);
+		lifetime->add_action([this, key, entity]() { subscriptions.remove(key, entity); });
 	}
 }
+
+void MessageBroker::set_mailbox_limits(MailboxLimits limits)
+{
+	std::lock_guard<decltype(lock)> guard(lock);
+	mailbox_limits = limits;
+}
+
+MessageBroker::MailboxStats MessageBroker::get_mailbox_stats() const
+{
+	std::lock_guard<decltype(lock)> guard(lock);
+	return mailbox_stats;
+}
 }	 // namespace rd
@@ -12,15 +12,34 @@
 
 #include "spdlog/spdlog.h"
 
-#include <queue>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <rd_framework_export.h>
 
 namespace rd
 {
+/**
+ * \brief Mailbox of an id: messages which arrived before an entity subscribed to it.
+ */
 class RD_FRAMEWORK_API Mq
 {
 public:
+	using clock_t = std::chrono::steady_clock;
+
+	struct Message
+	{
+		Buffer buffer;
+		clock_t::time_point received;
+	};
+
 	// region ctor/dtor
 
 	Mq() = default;
@@ -34,24 +53,156 @@ public:
 	Mq& operator=(Mq&&) = default;
 	// endregion
 
-	mutable std::queue<Buffer> default_scheduler_messages;
+	std::deque<Message> default_scheduler_messages;
+	// messages for a subscriber with another scheduler or lane, which arrived before the replay
 	std::vector<Buffer> custom_scheduler_messages;
+	// the replay of the mailbox is queued on the default scheduler
+	bool replay_queued = false;
+	// messages rejected because of a limit
+	uint64_t dropped = 0;
+};
+
+/**
+ * \brief Subscriptions of a [MessageBroker], looked up by the wire and scheduler threads for every message and changed
+ * only when entities are bound or unbound. Each shard is an immutable map which a writer replaces as a whole, so a
+ * lookup never waits for a writer or another reader. Writers of a shard are serialized by its lock.
+ */
+class RD_FRAMEWORK_API SubscriptionTable
+{
+public:
+	IRdReactive const* find(RdId const& id) const;
+
+	void add(RdId const& id, IRdReactive const* entity);
+
+	/**
+	 * \brief Removes the subscription of [id] unless another [entity] has subscribed to it since.
+	 */
+	void remove(RdId const& id, IRdReactive const* entity);
+
+private:
+	using map_t = rd::unordered_map<RdId, IRdReactive const*>;
+
+	static constexpr size_t SHARDS = 16;
+
+	struct Shard
+	{
+		std::mutex write_lock;
+		std::shared_ptr<map_t const> map;
+	};
+	std::array<Shard, SHARDS> shards;
+
+	Shard& shard_of(RdId const& id);
+
+	Shard const& shard_of(RdId const& id) const;
 };
 
 class RD_FRAMEWORK_API MessageBroker final
 {
+public:
+	/**
+	 * \brief Bounds of the mailboxes of ids nobody has subscribed to yet. A message over a limit is dropped rather than
+	 * kept, the ones already waiting stay in order.
+	 */
+	struct MailboxLimits
+	{
+		// messages waiting for one id
+		size_t per_id = 4096;
+		// messages waiting for all ids together
+		size_t total = 64 * 1024;
+		// a message waiting longer is dropped instead of replayed
+		std::chrono::milliseconds ttl{std::chrono::seconds(60)};
+	};
+
+	struct MailboxStats
+	{
+		size_t mailboxes = 0;
+		size_t waiting = 0;
+		uint64_t replayed = 0;
+		uint64_t dropped_overflow = 0;
+		uint64_t dropped_expired = 0;
+		// nobody has subscribed until the replay
+		uint64_t dropped_unhandled = 0;
+	};
+
 private:
 	IScheduler* default_scheduler = nullptr;
-	mutable rd::unordered_map<RdId, IRdReactive const*> subscriptions;
+	mutable SubscriptionTable subscriptions;
+	// messages which arrived before their entity subscribed, guarded by [lock]
 	mutable rd::unordered_map<RdId, Mq> broker;
+	MailboxLimits mailbox_limits;
+	mutable MailboxStats mailbox_stats;
 
 	mutable std::recursive_mutex lock;
 
+	struct PendingMessage
+	{
+		// null for a turn of the messages of [id] waiting in [broker]
+		IRdReactive const* that;
+		RdId id;
+		Buffer message;
+	};
+	using pending_messages_t = std::vector<PendingMessage>;
+
+	struct PendingGroup
+	{
+		IScheduler* scheduler;
+		SchedulerLane lane;
+		pending_messages_t messages;
+	};
+
+	// the batch is filled and flushed only by [batching_thread]
+	mutable std::atomic<std::thread::id> batching_thread{};
+	mutable int32_t batch_depth = 0;
+	mutable std::vector<PendingGroup> batch;
+
 	static std::shared_ptr<spdlog::logger> logger;
 
 	void invoke(const IRdReactive* that, Buffer msg, bool sync = false) const;
 
+	void deliver(const IRdReactive* that, Buffer msg) const;
+
+	bool admit(RdId const& id, Mq& mq) const;
+
+	void replay(RdId id) const;
+
+	/**
+	 * \brief Whether messages of [subscription] are queued just like the replay of a mailbox, so they can't overtake it.
+	 */
+	bool is_replayed_with(IRdReactive const* subscription) const;
+
+	void deliver_all(pending_messages_t& messages) const;
+
+	bool is_batching() const;
+
+	void add_to_batch(IScheduler* scheduler, SchedulerLane lane, PendingMessage message) const;
+
 public:
+	/**
+	 * \brief Makes the messages dispatched by the current thread while it's alive wait in the broker, then queues them
+	 * with one action per scheduler instead of one action per message. Messages keep their order: those of one
+	 * scheduler are delivered one after another by its action. Scopes nest, only the outermost one flushes.
+	 *
+	 * A broker collects messages of one thread at a time, a scope opened by another thread meanwhile has no effect.
+	 */
+	class RD_FRAMEWORK_API BatchScope
+	{
+	public:
+		// region ctor/dtor
+
+		explicit BatchScope(MessageBroker const& broker);
+
+		BatchScope(BatchScope const&) = delete;
+
+		BatchScope& operator=(BatchScope const&) = delete;
+
+		~BatchScope();
+		// endregion
+
+	private:
+		MessageBroker const& broker;
+		bool owner = false;
+	};
+
 	// region ctor/dtor
 
 	explicit MessageBroker(IScheduler* defaultScheduler);
@@ -59,7 +210,17 @@ public:
 
 	void dispatch(RdId id, Buffer message) const;
 
+	/**
+	 * \brief Queues the messages collected so far by the [BatchScope] of the current thread, e.g. before waiting for
+	 * more input. Does nothing outside of a batch.
+	 */
+	void flush_batch() const;
+
 	void advise_on(Lifetime lifetime, IRdReactive const* entity) const;
+
+	void set_mailbox_limits(MailboxLimits limits);
+
+	MailboxStats get_mailbox_stats() const;
 };
 }	 // namespace rd
 #if defined(_MSC_VER)
@@ -3,14 +3,14 @@
 #include "serialization/SerializationCtx.h"
 #include "intern/InternRoot.h"
 
-#include "spdlog/sinks/stdout_color_sinks.h"
+#include "util/core_log.h"
 
 #include <utility>
 
 namespace rd
 {
 std::shared_ptr<spdlog::logger> Protocol::initializationLogger =
-	spdlog::stderr_color_mt<spdlog::synchronous_factory>("initializationLogger", spdlog::color_mode::automatic);
+	util::create_logger("initializationLogger");
 
 constexpr string_view Protocol::InternRootName;
 
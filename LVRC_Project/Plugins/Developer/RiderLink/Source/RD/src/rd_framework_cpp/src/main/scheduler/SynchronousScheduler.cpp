@@ -1,6 +1,7 @@
 #include "SynchronousScheduler.h"
 
 #include "guards.h"
+#include "scheduler/base/SchedulerMetrics.h"
 
 namespace rd
 {
@@ -9,6 +10,11 @@ static thread_local int32_t SynchronousScheduler_active_count = 0;
 void SynchronousScheduler::queue(std::function<void()> action)
 {
 	util::increment_guard<int32_t> guard(SynchronousScheduler_active_count);
+	if (metrics)
+	{
+		metrics->wrap(std::move(action))();
+		return;
+	}
 	action();
 }
 
@@ -20,4 +26,9 @@ bool SynchronousScheduler::is_active() const
 {
 	return SynchronousScheduler_active_count > 0;
 }
+
+bool SynchronousScheduler::is_inline() const
+{
+	return true;
+}
 }	 // namespace rd
\ No newline at end of file
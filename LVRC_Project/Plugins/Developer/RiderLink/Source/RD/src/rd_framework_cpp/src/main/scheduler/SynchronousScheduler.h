@@ -29,6 +29,8 @@ public:
 
 	bool is_active() const override;
 
+	bool is_inline() const override;
+
 	/**
 	 * \brief global synchronous scheduler for whole application.
 	 */
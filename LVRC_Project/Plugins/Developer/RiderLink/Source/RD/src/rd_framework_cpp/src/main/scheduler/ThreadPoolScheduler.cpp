@@ -0,0 +1,373 @@
+#include "ThreadPoolScheduler.h"
+
+#include "scheduler/base/IdleTracker.h"
+#include "scheduler/base/SchedulerMetrics.h"
+#include "std/unordered_map.h"
+
+#include "util/core_util.h"
+#include "util/thread_util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace rd
+{
+namespace
+{
+// pool of the current thread, its class is private to the scheduler
+thread_local void const* current_pool = nullptr;
+}	 // namespace
+
+class ThreadPoolScheduler::Pool : public std::enable_shared_from_this<Pool>
+{
+public:
+	struct Worker
+	{
+		std::mutex lock;
+		std::deque<std::function<void()>> tasks;
+		std::thread thread;
+	};
+
+	std::shared_ptr<spdlog::logger> log;
+	std::string name;
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::atomic<size_t> next_worker{0};
+	// queued and not taken by any thread yet
+	std::atomic<int32_t> available{0};
+	std::atomic<int32_t> parked{0};
+	std::atomic<bool> stopping{false};
+	std::mutex park_lock;
+	std::condition_variable unparked;
+	IdleTracker idle_tracker;
+
+	// actions of a key wait here while one of them runs, the key is present while its runner is queued or running
+	std::mutex keys_lock;
+	rd::unordered_map<int64_t, std::deque<std::function<void()>>> keys;
+
+	// kept alive for the wrapped actions still queued when the scheduler is destroyed by one of its own actions
+	std::shared_ptr<SchedulerMetrics> metrics;
+
+	Pool(std::shared_ptr<spdlog::logger> log, std::string name) : log(std::move(log)), name(std::move(name)), idle_tracker(this->log)
+	{
+	}
+
+	void start(size_t threads_count);
+
+	void push(std::function<void()> action, bool first = false);
+
+	void queue_ordered(int64_t key, std::function<void()> action);
+
+	void run(size_t index);
+
+	bool request_stop();
+
+private:
+	bool take(size_t index, std::function<void()>& action);
+
+	void run_next_of(int64_t key);
+};
+
+void ThreadPoolScheduler::Pool::start(size_t threads_count)
+{
+	for (size_t i = 0; i < threads_count; ++i)
+	{
+		workers.push_back(std::make_unique<Worker>());
+	}
+	// queues of all workers exist before any of them starts stealing
+	for (size_t i = 0; i < threads_count; ++i)
+	{
+		workers[i]->thread = std::thread([self = shared_from_this(), i] { self->run(i); });
+	}
+}
+
+void ThreadPoolScheduler::Pool::queue_ordered(int64_t key, std::function<void()> action)
+{
+	idle_tracker.on_queued();
+	{
+		std::lock_guard<decltype(keys_lock)> guard(keys_lock);
+		auto it = keys.find(key);
+		if (it != keys.end())
+		{
+			it->second.push_back(std::move(action));
+			return;
+		}
+		keys[key].push_back(std::move(action));
+	}
+	idle_tracker.on_queued();
+	push([this, key] { run_next_of(key); });
+}
+
+void ThreadPoolScheduler::Pool::run_next_of(int64_t key)
+{
+	std::function<void()> action;
+	{
+		std::lock_guard<decltype(keys_lock)> guard(keys_lock);
+		auto& actions = keys[key];
+		action = std::move(actions.front());
+		actions.pop_front();
+	}
+	try
+	{
+		action();
+	}
+	catch (std::exception const& e)
+	{
+		log->error("Background task failed, scheduler={} | {}", name, e.what());
+	}
+	action = nullptr;
+	idle_tracker.on_executed();
+
+	{
+		std::lock_guard<decltype(keys_lock)> guard(keys_lock);
+		auto it = keys.find(key);
+		if (it->second.empty())
+		{
+			keys.erase(it);
+			return;
+		}
+	}
+	// requeued rather than looped, so that one busy key doesn't occupy a thread
+	idle_tracker.on_queued();
+	push([this, key] { run_next_of(key); });
+}
+
+void ThreadPoolScheduler::Pool::push(std::function<void()> action, bool first)
+{
+	size_t index = 0;
+	if (current_pool == this)
+	{
+		const auto it = std::find_if(workers.begin(), workers.end(),
+			[](std::unique_ptr<Worker> const& worker) { return worker->thread.get_id() == std::this_thread::get_id(); });
+		index = static_cast<size_t>(it - workers.begin());
+	}
+	else
+	{
+		index = next_worker++ % workers.size();
+	}
+	{
+		Worker& worker = *workers[index];
+		std::lock_guard<decltype(worker.lock)> guard(worker.lock);
+		if (first)
+		{
+			worker.tasks.push_front(std::move(action));
+		}
+		else
+		{
+			worker.tasks.push_back(std::move(action));
+		}
+	}
+	++available;
+	if (parked > 0)
+	{
+		std::lock_guard<decltype(park_lock)> guard(park_lock);
+		unparked.notify_one();
+	}
+}
+
+bool ThreadPoolScheduler::Pool::take(size_t index, std::function<void()>& action)
+{
+	// own queue from the front, the others' from the back
+	for (size_t i = 0; i < workers.size(); ++i)
+	{
+		Worker& worker = *workers[(index + i) % workers.size()];
+		std::lock_guard<decltype(worker.lock)> guard(worker.lock);
+		if (worker.tasks.empty())
+		{
+			continue;
+		}
+		if (i == 0)
+		{
+			action = std::move(worker.tasks.front());
+			worker.tasks.pop_front();
+		}
+		else
+		{
+			action = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+		}
+		--available;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPoolScheduler::Pool::run(size_t index)
+{
+	rd::util::set_thread_name((name + "-" + std::to_string(index)).c_str());
+	current_pool = this;
+
+	std::function<void()> action;
+	while (true)
+	{
+		if (take(index, action))
+		{
+			try
+			{
+				action();
+			}
+			catch (std::exception const& e)
+			{
+				log->error("Background task failed, scheduler={} | {}", name, e.what());
+			}
+			action = nullptr;
+			idle_tracker.on_executed();
+			continue;
+		}
+
+		// announce parking before the last look, a producer checks it after publishing the action
+		++parked;
+		{
+			std::unique_lock<decltype(park_lock)> guard(park_lock);
+			unparked.wait(guard, [this] { return available > 0 || stopping; });
+		}
+		--parked;
+		if (stopping && available == 0)
+		{
+			break;
+		}
+	}
+	current_pool = nullptr;
+}
+
+bool ThreadPoolScheduler::Pool::request_stop()
+{
+	std::lock_guard<decltype(park_lock)> guard(park_lock);
+	if (stopping)
+	{
+		return false;
+	}
+	stopping = true;
+	unparked.notify_all();
+	return true;
+}
+
+ThreadPoolScheduler::ThreadPoolScheduler(Lifetime lifetime, std::string name, size_t threads_count, bool ordered_by_key)
+	: lifetime(lifetime)
+	, log(util::create_logger(name))
+	, name(std::move(name))
+	, ordered_by_key(ordered_by_key)
+	, pool(std::make_shared<Pool>(log, this->name))
+{
+	out_of_order_execution = true;
+	if (threads_count == 0)
+	{
+		threads_count = (std::max)(1u, std::thread::hardware_concurrency());
+	}
+	pool->start(threads_count);
+
+	lifetime->add_action([this] {
+		try
+		{
+			stop();
+		}
+		catch (std::exception const& e)
+		{
+			log->error("Failed to terminate {} | {}", this->name, e.what());
+		}
+	});
+}
+
+ThreadPoolScheduler::~ThreadPoolScheduler()
+{
+	stop();
+	// a thread stopped from its own action is detached and may still run the queued actions
+	pool->metrics = metrics;
+}
+
+void ThreadPoolScheduler::queue(std::function<void()> action)
+{
+	queue_in_lane(SchedulerLane::Interactive, std::move(action));
+}
+
+void ThreadPoolScheduler::queue_in_lane(SchedulerLane lane, std::function<void()> action)
+{
+	if (pool->stopping)
+	{
+		log->debug("Task dropped, scheduler={} is stopped", name);
+		return;
+	}
+	if (metrics)
+	{
+		action = metrics->wrap(std::move(action));
+	}
+	pool->idle_tracker.on_queued();
+	pool->push(std::move(action), lane == SchedulerLane::Control);
+}
+
+void ThreadPoolScheduler::queue_ordered(int64_t key, std::function<void()> action)
+{
+	if (!ordered_by_key)
+	{
+		queue(std::move(action));
+		return;
+	}
+	if (pool->stopping)
+	{
+		log->debug("Task dropped, scheduler={} is stopped", name);
+		return;
+	}
+	if (metrics)
+	{
+		action = metrics->wrap(std::move(action));
+	}
+	pool->queue_ordered(key, std::move(action));
+}
+
+void ThreadPoolScheduler::flush()
+{
+	RD_ASSERT_MSG(!is_active(), "Can't flush this scheduler in a reentrant way: we are inside queued item's execution");
+
+	pool->idle_tracker.wait();
+}
+
+bool ThreadPoolScheduler::flush_for(std::chrono::milliseconds timeout)
+{
+	RD_ASSERT_MSG(!is_active(), "Can't flush this scheduler in a reentrant way: we are inside queued item's execution");
+
+	return pool->idle_tracker.wait_for(timeout);
+}
+
+void ThreadPoolScheduler::when_idle(std::function<void()> action)
+{
+	pool->idle_tracker.when_idle(std::move(action));
+}
+
+bool ThreadPoolScheduler::is_active() const
+{
+	return current_pool == pool.get();
+}
+
+size_t ThreadPoolScheduler::get_threads_count() const
+{
+	return pool->workers.size();
+}
+
+void ThreadPoolScheduler::stop()
+{
+	if (!pool->request_stop())
+	{
+		return;
+	}
+	for (auto const& worker : pool->workers)
+	{
+		if (!worker->thread.joinable())
+		{
+			continue;
+		}
+		// stopped from its own action: the thread can't join itself, it owns [pool] too and exits after the queue
+		if (worker->thread.get_id() == std::this_thread::get_id())
+		{
+			worker->thread.detach();
+			continue;
+		}
+		worker->thread.join();
+	}
+}
+}	 // namespace rd
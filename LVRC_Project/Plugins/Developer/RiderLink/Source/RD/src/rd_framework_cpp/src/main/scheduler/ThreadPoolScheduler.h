@@ -0,0 +1,90 @@
+#ifndef RD_CPP_THREADPOOLSCHEDULER_H
+#define RD_CPP_THREADPOOLSCHEDULER_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include "scheduler/base/IScheduler.h"
+#include "lifetime/Lifetime.h"
+
+#include "spdlog/spdlog.h"
+
+#include <memory>
+#include <string>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Runs actions on several threads with [out_of_order_execution], for thread-safe handlers such as CPU-heavy
+ * endpoint computations. Every thread has a queue of its own: an action queued from a pool thread stays on it, the
+ * others are spread round-robin, and an idle thread steals from the busy ones before it parks.
+ *
+ * Actions queued with [queue_ordered] run one at a time and in order for each key, on whichever thread is free.
+ * The message broker queues messages of an entity with its id as the key, so handlers of one entity are serialized
+ * unless [ordered_by_key] is off.
+ *
+ * Of the lanes only [SchedulerLane::Control] is told apart: such an action is taken next by the thread it's queued to.
+ */
+class RD_FRAMEWORK_API ThreadPoolScheduler : public IScheduler
+{
+public:
+	Lifetime lifetime;
+
+	// region ctor/dtor
+
+	/**
+	 * \param threads_count number of threads, all hardware threads if 0.
+	 */
+	ThreadPoolScheduler(Lifetime lifetime, std::string name, size_t threads_count = 0, bool ordered_by_key = true);
+
+	ThreadPoolScheduler(ThreadPoolScheduler const&) = delete;
+
+	ThreadPoolScheduler& operator=(ThreadPoolScheduler const&) = delete;
+
+	virtual ~ThreadPoolScheduler();
+	// endregion
+
+	void queue(std::function<void()> action) override;
+
+	void queue_in_lane(SchedulerLane lane, std::function<void()> action) override;
+
+	void queue_ordered(int64_t key, std::function<void()> action) override;
+
+	void flush() override;
+
+	bool flush_for(std::chrono::milliseconds timeout) override;
+
+	void when_idle(std::function<void()> action) override;
+
+	/**
+	 * \brief Whether the current thread is one of the pool's.
+	 */
+	bool is_active() const override;
+
+	size_t get_threads_count() const;
+
+private:
+	/**
+	 * \brief Queues and state of the threads. The threads share their ownership, so when the scheduler is stopped or
+	 * destroyed by one of its own actions that thread finishes the queues and exits without touching the scheduler.
+	 */
+	class Pool;
+
+	std::shared_ptr<spdlog::logger> log;
+	std::string name;
+	bool ordered_by_key;
+
+	std::shared_ptr<Pool> pool;
+
+	void stop();
+};
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_THREADPOOLSCHEDULER_H
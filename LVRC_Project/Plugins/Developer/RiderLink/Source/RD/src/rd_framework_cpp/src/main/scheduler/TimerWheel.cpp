@@ -0,0 +1,422 @@
+#include "TimerWheel.h"
+
+#include "util/core_util.h"
+#include "util/thread_util.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace rd
+{
+static std::shared_ptr<spdlog::logger> logger = util::create_logger("timerWheelLog");
+
+constexpr unsigned TimerWheel::ROOT_BITS;
+constexpr unsigned TimerWheel::LEVEL_BITS;
+constexpr size_t TimerWheel::LEVELS;
+constexpr size_t TimerWheel::ROOT_SLOTS;
+constexpr size_t TimerWheel::LEVEL_SLOTS;
+constexpr TimerWheel::tick_t TimerWheel::MAX_SPAN;
+constexpr TimerWheel::tick_t TimerWheel::NO_EVENT;
+
+struct TimerWheel::Entry
+{
+	Entry(Lifetime lifetime, std::function<void()> action, tick_t period)
+		: lifetime(std::move(lifetime)), action(std::move(action)), period(period)
+	{
+	}
+
+	Lifetime lifetime;
+	std::function<void()> action;
+	tick_t expires = 0;
+	tick_t period;
+	LifetimeImpl::counter_t cancellation_id = -1;
+	bool cancelled = false;
+
+	// intrusive list of the slot, which owns the entry through [self] while it's linked
+	Entry* prev = nullptr;
+	Entry* next = nullptr;
+	size_t slot = 0;
+	std::shared_ptr<Entry> self;
+};
+
+TimerWheel::TimerWheel() = default;
+
+TimerWheel::~TimerWheel()
+{
+	stop();
+}
+
+TimerWheel& TimerWheel::Instance()
+{
+	static TimerWheel globalTimerWheel;
+	return globalTimerWheel;
+}
+
+void TimerWheel::schedule(Lifetime lifetime, duration delay, std::function<void()> action)
+{
+	add(std::move(lifetime), delay, duration::zero(), std::move(action));
+}
+
+void TimerWheel::schedule_periodic(Lifetime lifetime, duration period, std::function<void()> action)
+{
+	RD_ASSERT_MSG(period > duration::zero(), "period of a timer must be positive")
+	add(std::move(lifetime), period, period, std::move(action));
+}
+
+void TimerWheel::add(Lifetime lifetime, duration delay, duration period, std::function<void()> action)
+{
+	const auto due = clock::now() + delay;
+	if (lifetime->is_terminated())
+	{
+		return;
+	}
+
+	auto entry = std::make_shared<Entry>(lifetime, std::move(action), static_cast<tick_t>(period.count()));
+	std::weak_ptr<Entry> weak_entry = entry;
+	try
+	{
+		entry->cancellation_id = lifetime->add_action([this, weak_entry] {
+			if (auto cancelled_entry = weak_entry.lock())
+			{
+				cancel(cancelled_entry);
+			}
+		});
+	}
+	catch (std::invalid_argument const&)
+	{
+		return;	   // terminated concurrently
+	}
+
+	// an action scheduling a timer must not wait for stop() which joins the action's thread
+	std::unique_lock<std::mutex> start_guard(start_lock, std::defer_lock);
+	if (std::this_thread::get_id() != thread_id)
+	{
+		start_guard.lock();
+	}
+
+	std::lock_guard<decltype(lock)> guard(lock);
+	if (entry->cancelled)
+	{
+		return;
+	}
+	if (stopped)
+	{
+		RD_LOG_DEBUG(logger, "Timer dropped, the timer wheel is stopped");
+		return;
+	}
+	if (!thread.joinable())
+	{
+		thread = std::thread([this] { run(); });
+	}
+
+	const tick_t now = now_tick();
+	skip_idle(now);
+	const tick_t previous_event = next_event();
+
+	entry->expires = static_cast<tick_t>(std::chrono::ceil<duration>(due - epoch).count());
+	link(std::move(entry), current_tick + 1);
+	++stats.scheduled;
+
+	if (next_event() < previous_event)
+	{
+		wakeup.notify_one();
+	}
+}
+
+void TimerWheel::cancel(std::shared_ptr<Entry> const& entry)
+{
+	std::unique_lock<decltype(lock)> guard(lock);
+	entry->cancelled = true;
+	if (entry->self != nullptr)
+	{
+		unlink(entry.get());
+		++stats.cancelled;
+	}
+	if (std::this_thread::get_id() != thread_id)
+	{
+		action_finished.wait(guard, [this, &entry] { return running != entry.get(); });
+	}
+}
+
+void TimerWheel::link(std::shared_ptr<Entry> entry, tick_t earliest)
+{
+	tick_t at = (std::max)(entry->expires, earliest);
+	const tick_t delta = at - current_tick;
+
+	size_t level = 0;
+	while (level + 1 < LEVELS && delta >= (tick_t{1} << shift_of(level + 1)))
+	{
+		++level;
+	}
+	if (delta >= MAX_SPAN)
+	{
+		// moves down when its top level slot comes due and is placed again from there
+		at = current_tick + MAX_SPAN - 1;
+	}
+
+	Entry* e = entry.get();
+	e->slot = base_of(level) + static_cast<size_t>((at >> shift_of(level)) & mask_of(level));
+	e->prev = nullptr;
+	e->next = slots[e->slot];
+	if (e->next != nullptr)
+	{
+		e->next->prev = e;
+	}
+	slots[e->slot] = e;
+	e->self = std::move(entry);
+	++size;
+}
+
+std::shared_ptr<TimerWheel::Entry> TimerWheel::unlink(Entry* entry)
+{
+	if (entry->prev != nullptr)
+	{
+		entry->prev->next = entry->next;
+	}
+	else
+	{
+		slots[entry->slot] = entry->next;
+	}
+	if (entry->next != nullptr)
+	{
+		entry->next->prev = entry->prev;
+	}
+	entry->prev = entry->next = nullptr;
+	--size;
+	return std::move(entry->self);
+}
+
+void TimerWheel::cascade(size_t level, size_t index)
+{
+	Entry* e = slots[base_of(level) + index];
+	slots[base_of(level) + index] = nullptr;
+	while (e != nullptr)
+	{
+		Entry* next = e->next;
+		e->prev = e->next = nullptr;
+		--size;
+		// due at this very tick goes to the root slot which is about to be fired
+		link(std::move(e->self), current_tick);
+		e = next;
+	}
+}
+
+TimerWheel::tick_t TimerWheel::next_event() const
+{
+	if (size == 0)
+	{
+		return NO_EVENT;
+	}
+
+	tick_t res = NO_EVENT;
+	for (tick_t distance = 1; distance < ROOT_SLOTS; ++distance)
+	{
+		if (slots[static_cast<size_t>((current_tick + distance) & mask_of(0))] != nullptr)
+		{
+			res = current_tick + distance;
+			break;
+		}
+	}
+	// an upper level slot needs attention when the levels below wrap around to it
+	for (size_t level = 1; level < LEVELS; ++level)
+	{
+		const tick_t position = current_tick >> shift_of(level);
+		// the slot which has just been cascaded may be reused for the full span ahead
+		for (tick_t distance = 1; distance <= LEVEL_SLOTS; ++distance)
+		{
+			if (slots[base_of(level) + static_cast<size_t>((position + distance) & mask_of(level))] != nullptr)
+			{
+				res = (std::min)(res, (position + distance) << shift_of(level));
+				break;
+			}
+		}
+	}
+	return res;
+}
+
+void TimerWheel::skip_idle(tick_t now)
+{
+	// nothing is linked to the slots in between, so there is nothing to fire or cascade
+	const tick_t next = next_event();
+	const tick_t target = next == NO_EVENT ? now : (std::min)(now, next - 1);
+	if (target > current_tick)
+	{
+		current_tick = target;
+	}
+}
+
+void TimerWheel::advance(tick_t now, std::unique_lock<std::mutex>& guard)
+{
+	std::vector<std::shared_ptr<Entry>> due;
+	while (!stopping && current_tick < now)
+	{
+		skip_idle(now);
+		if (current_tick >= now)
+		{
+			break;
+		}
+
+		const tick_t tick = ++current_tick;
+		for (size_t level = LEVELS - 1; level > 0; --level)
+		{
+			if ((tick & ((tick_t{1} << shift_of(level)) - 1)) == 0)
+			{
+				cascade(level, static_cast<size_t>((tick >> shift_of(level)) & mask_of(level)));
+			}
+		}
+
+		Entry* e = slots[static_cast<size_t>(tick & mask_of(0))];
+		slots[static_cast<size_t>(tick & mask_of(0))] = nullptr;
+		while (e != nullptr)
+		{
+			Entry* next = e->next;
+			e->prev = e->next = nullptr;
+			--size;
+			due.push_back(std::move(e->self));
+			e = next;
+		}
+
+		for (auto const& entry : due)
+		{
+			fire(entry, guard);
+		}
+		due.clear();
+	}
+}
+
+void TimerWheel::fire(std::shared_ptr<Entry> const& entry, std::unique_lock<std::mutex>& guard)
+{
+	if (entry->cancelled || stopping)
+	{
+		return;
+	}
+
+	const auto lateness = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - time_of(entry->expires));
+	++stats.fired;
+	stats.total_lateness += lateness;
+	stats.max_lateness = (std::max)(stats.max_lateness, lateness);
+
+	running = entry.get();
+	guard.unlock();
+	try
+	{
+		entry->action();
+	}
+	catch (std::exception const& e)
+	{
+		RD_LOG_ERROR(logger, "Timer action failed | {}", e.what());
+	}
+	guard.lock();
+	running = nullptr;
+	action_finished.notify_all();
+
+	if (entry->cancelled || stopping)
+	{
+		return;
+	}
+	if (entry->period > 0)
+	{
+		entry->expires += entry->period;
+		const tick_t now = now_tick();
+		if (entry->expires <= now)
+		{
+			entry->expires = now + entry->period;
+		}
+		link(entry, current_tick + 1);
+	}
+	else
+	{
+		// one-shot timer is done, don't keep the cancellation in the lifetime until it ends
+		entry->cancelled = true;
+		if (entry->cancellation_id >= 0)
+		{
+			guard.unlock();
+			entry->lifetime->remove_action(entry->cancellation_id);
+			guard.lock();
+		}
+	}
+}
+
+void TimerWheel::run()
+{
+	rd::util::set_thread_name("rd::TimerWheel");
+
+	std::unique_lock<decltype(lock)> guard(lock);
+	thread_id = std::this_thread::get_id();
+	while (!stopping)
+	{
+		advance(now_tick(), guard);
+		if (stopping)
+		{
+			break;
+		}
+
+		const tick_t next = next_event();
+		if (next == NO_EVENT)
+		{
+			wakeup.wait(guard);
+		}
+		else
+		{
+			wakeup.wait_until(guard, time_of(next));
+		}
+		++stats.wakeups;
+	}
+	thread_id = std::thread::id();
+}
+
+TimerWheel::Stats TimerWheel::get_stats() const
+{
+	std::lock_guard<decltype(lock)> guard(lock);
+	return stats;
+}
+
+void TimerWheel::start()
+{
+	std::lock_guard<decltype(start_lock)> start_guard(start_lock);
+	std::lock_guard<decltype(lock)> guard(lock);
+	stopped = false;
+}
+
+void TimerWheel::stop()
+{
+	std::lock_guard<decltype(start_lock)> start_guard(start_lock);
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		stopped = true;
+		if (!thread.joinable())
+		{
+			return;
+		}
+		stopping = true;
+	}
+	wakeup.notify_all();
+	thread.join();
+
+	std::vector<std::shared_ptr<Entry>> dropped;
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		for (Entry* head : slots)
+		{
+			for (Entry* e = head; e != nullptr; e = e->next)
+			{
+				dropped.push_back(std::move(e->self));
+			}
+		}
+		slots.fill(nullptr);
+		size = 0;
+		stopping = false;
+	}
+	// actions are destroyed outside of the lock, they may own timers' lifetimes
+}
+
+TimerWheel::tick_t TimerWheel::now_tick() const
+{
+	return static_cast<tick_t>(std::chrono::duration_cast<duration>(clock::now() - epoch).count());
+}
+
+TimerWheel::clock::time_point TimerWheel::time_of(tick_t tick) const
+{
+	return epoch + duration(tick);
+}
+}	 // namespace rd
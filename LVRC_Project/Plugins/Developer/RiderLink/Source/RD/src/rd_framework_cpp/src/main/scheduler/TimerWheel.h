@@ -0,0 +1,172 @@
+#ifndef RD_CPP_TIMERWHEEL_H
+#define RD_CPP_TIMERWHEEL_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include "lifetime/Lifetime.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Hierarchical timer wheel served by a single thread: heartbeats, reconnect delays and call timeouts of all
+ * wires share it instead of sleeping on threads of their own.
+ *
+ * Resolution is one tick (1ms). Level 0 holds the next 256 ticks, each of the 3 upper levels 64 times the span of
+ * the level below (up to ~18 hours); timers move down a level when their slot comes due. The thread sleeps until the
+ * nearest expiry or cascade, so an idle wheel doesn't wake up at all.
+ *
+ * Actions run on the timer thread and must not block. Every timer is bound to a Lifetime: once it's terminated
+ * the action won't run again, and the termination waits for an action which is running at that moment
+ * (unless it's terminated from the action itself).
+ */
+class RD_FRAMEWORK_API TimerWheel
+{
+public:
+	using clock = std::chrono::steady_clock;
+	using duration = std::chrono::milliseconds;
+
+	struct Stats
+	{
+		uint64_t scheduled = 0;
+		uint64_t fired = 0;
+		uint64_t cancelled = 0;
+		uint64_t wakeups = 0;
+		/**
+		 * \brief How late actions ran relative to their due time, e.g. jitter of heartbeats.
+		 */
+		std::chrono::microseconds max_lateness{0};
+		std::chrono::microseconds total_lateness{0};
+	};
+
+	// region ctor/dtor
+
+	TimerWheel();
+
+	TimerWheel(TimerWheel const&) = delete;
+
+	TimerWheel& operator=(TimerWheel const&) = delete;
+
+	virtual ~TimerWheel();
+	// endregion
+
+	/**
+	 * \brief global timer wheel for whole application.
+	 */
+	static TimerWheel& Instance();
+
+	/**
+	 * \brief Runs [action] once after [delay] unless [lifetime] is terminated before.
+	 */
+	void schedule(Lifetime lifetime, duration delay, std::function<void()> action);
+
+	/**
+	 * \brief Runs [action] every [period], first time after [period], until [lifetime] is terminated.
+	 * Periods missed because the thread was late are skipped rather than run in a burst.
+	 */
+	void schedule_periodic(Lifetime lifetime, duration period, std::function<void()> action);
+
+	Stats get_stats() const;
+
+	/**
+	 * \brief Allows scheduling again after [stop], the thread starts with the next timer.
+	 */
+	void start();
+
+	/**
+	 * \brief Joins the timer thread and drops pending timers, later ones are dropped until [start] is called.
+	 * Must be called before unloading the module on platforms which can't join threads from static destructors.
+	 */
+	void stop();
+
+private:
+	using tick_t = uint64_t;
+
+	struct Entry;
+
+	static constexpr unsigned ROOT_BITS = 8;
+	static constexpr unsigned LEVEL_BITS = 6;
+	static constexpr size_t LEVELS = 4;
+	static constexpr size_t ROOT_SLOTS = size_t{1} << ROOT_BITS;
+	static constexpr size_t LEVEL_SLOTS = size_t{1} << LEVEL_BITS;
+	static constexpr tick_t MAX_SPAN = tick_t{1} << (ROOT_BITS + (LEVELS - 1) * LEVEL_BITS);
+	static constexpr tick_t NO_EVENT = ~tick_t{0};
+
+	static constexpr unsigned shift_of(size_t level)
+	{
+		return level == 0 ? 0 : static_cast<unsigned>(ROOT_BITS + (level - 1) * LEVEL_BITS);
+	}
+
+	static constexpr tick_t mask_of(size_t level)
+	{
+		return (tick_t{1} << (level == 0 ? ROOT_BITS : LEVEL_BITS)) - 1;
+	}
+
+	static constexpr size_t base_of(size_t level)
+	{
+		return level == 0 ? 0 : ROOT_SLOTS + (level - 1) * LEVEL_SLOTS;
+	}
+
+	// serializes starting the thread with stop(), [lock] guards everything else
+	std::mutex start_lock;
+	mutable std::mutex lock;
+	std::condition_variable wakeup;
+	std::condition_variable action_finished;
+	std::thread thread;
+	std::atomic<std::thread::id> thread_id{};
+	// asks the thread to exit
+	bool stopping = false;
+	// set by stop() and cleared only by start(), timers scheduled meanwhile are dropped
+	bool stopped = false;
+
+	const clock::time_point epoch = clock::now();
+	tick_t current_tick = 0;
+	size_t size = 0;
+	std::array<Entry*, ROOT_SLOTS + (LEVELS - 1) * LEVEL_SLOTS> slots{};
+	Entry const* running = nullptr;
+	Stats stats;
+
+	void add(Lifetime lifetime, duration delay, duration period, std::function<void()> action);
+
+	void cancel(std::shared_ptr<Entry> const& entry);
+
+	void link(std::shared_ptr<Entry> entry, tick_t earliest);
+
+	std::shared_ptr<Entry> unlink(Entry* entry);
+
+	void cascade(size_t level, size_t index);
+
+	tick_t next_event() const;
+
+	void skip_idle(tick_t now);
+
+	void advance(tick_t now, std::unique_lock<std::mutex>& guard);
+
+	void fire(std::shared_ptr<Entry> const& entry, std::unique_lock<std::mutex>& guard);
+
+	void run();
+
+	tick_t now_tick() const;
+
+	clock::time_point time_of(tick_t tick) const;
+};
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_TIMERWHEEL_H
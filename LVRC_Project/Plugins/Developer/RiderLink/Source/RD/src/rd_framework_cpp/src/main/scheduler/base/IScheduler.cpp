@@ -1,9 +1,12 @@
 #include "IScheduler.h"
 
+#include "SchedulerMetrics.h"
+
 #include "spdlog/spdlog.h"
 
 #include <functional>
 #include <sstream>
+#include <utility>
 
 namespace rd
 {
@@ -28,4 +31,40 @@ void IScheduler::invoke_or_queue(std::function<void()> action)
 		queue(action);
 	}
 }
+
+void IScheduler::queue_in_lane(SchedulerLane /*lane*/, std::function<void()> action)
+{
+	queue(std::move(action));
+}
+
+void IScheduler::queue_ordered(int64_t /*key*/, std::function<void()> action)
+{
+	queue(std::move(action));
+}
+
+bool IScheduler::flush_for(std::chrono::milliseconds /*timeout*/)
+{
+	flush();
+	return true;
+}
+
+void IScheduler::when_idle(std::function<void()> action)
+{
+	action();
+}
+
+bool IScheduler::is_inline() const
+{
+	return false;
+}
+
+void IScheduler::set_metrics(std::shared_ptr<SchedulerMetrics> metrics)
+{
+	this->metrics = std::move(metrics);
+}
+
+SchedulerMetrics* IScheduler::get_metrics() const
+{
+	return metrics.get();
+}
 }	 // namespace rd
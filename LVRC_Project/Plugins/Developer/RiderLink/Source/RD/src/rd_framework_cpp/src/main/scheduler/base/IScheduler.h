@@ -6,13 +6,32 @@
 #pragma warning(disable:4251)
 #endif
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <thread>
 
 #include <rd_framework_export.h>
 
 namespace rd
 {
+// region predeclared
+
+class SchedulerMetrics;
+// endregion
+
+/**
+ * \brief Priority class of queued actions. A scheduler with lanes runs [Control] actions before any other and prefers
+ * [Interactive] ones to [Bulk], so that e.g. a flood of log events doesn't hold up the requests of the IDE.
+ */
+enum class SchedulerLane : uint8_t
+{
+	Control,
+	Interactive,
+	Bulk
+};
+
 /**
  * \brief Allows to queue the execution of actions on a different thread.
  */
@@ -21,6 +40,11 @@ class RD_FRAMEWORK_API IScheduler
 protected:
 	std::thread::id thread_id;
 
+	/**
+	 * \brief Null unless turned on, schedulers pass every queued action through [SchedulerMetrics::wrap] otherwise.
+	 */
+	std::shared_ptr<SchedulerMetrics> metrics;
+
 public:
 	// region ctor/dtor
 
@@ -36,7 +60,22 @@ public:
 	 */
 	virtual void queue(std::function<void()> action) = 0;
 
-	// todo
+	/**
+	 * \brief Queues [action] in the given priority [lane], [queue] is the same as [SchedulerLane::Interactive].
+	 * Actions of one lane run in order, an action may overtake the ones queued before it in lower lanes.
+	 * Schedulers without lanes just [queue] it.
+	 */
+	virtual void queue_in_lane(SchedulerLane lane, std::function<void()> action);
+
+	/**
+	 * \brief Queues [action] to run after the actions queued earlier with the same [key], e.g. messages of one entity.
+	 * Matters only for schedulers with [out_of_order_execution], the others run everything in order anyway.
+	 */
+	virtual void queue_ordered(int64_t key, std::function<void()> action);
+
+	/**
+	 * \brief Actions may run concurrently and in any order, unless queued with [queue_ordered].
+	 */
 	bool out_of_order_execution = false;
 
 	virtual void assert_thread() const;
@@ -49,12 +88,40 @@ public:
 
 	virtual void flush() = 0;
 
+	/**
+	 * \brief [flush] which gives up after [timeout]. Schedulers with a thread of their own block without spinning.
+	 * \return whether the scheduler has become idle.
+	 */
+	virtual bool flush_for(std::chrono::milliseconds timeout);
+
+	/**
+	 * \brief Calls [action] once nothing is queued or executing, right away if that's already the case.
+	 * Together with [WaitableEvent] it's an idle event to wait for; [action] may run on the scheduler's thread.
+	 */
+	virtual void when_idle(std::function<void()> action);
+
 	virtual bool is_active() const = 0;
 
+	/**
+	 * \brief Whether [queue] runs the action right away on the calling thread.
+	 */
+	virtual bool is_inline() const;
+
 	std::thread::id get_thread_id() const
 	{
 		return thread_id;
 	}
+
+	/**
+	 * \brief Turns on timings of the queued actions, e.g. in development builds. Must be called before the scheduler
+	 * is used, actions queued earlier aren't counted.
+	 */
+	void set_metrics(std::shared_ptr<SchedulerMetrics> metrics);
+
+	/**
+	 * \return metrics if turned on, null otherwise.
+	 */
+	SchedulerMetrics* get_metrics() const;
 };
 }	 // namespace rd
 #if defined(_MSC_VER)
@@ -0,0 +1,88 @@
+#include "IdleTracker.h"
+
+#include <utility>
+
+namespace rd
+{
+IdleTracker::IdleTracker(std::shared_ptr<spdlog::logger> log) : log(std::move(log))
+{
+}
+
+void IdleTracker::on_queued()
+{
+	++executing;
+}
+
+void IdleTracker::on_executed(uint32_t count)
+{
+	if ((executing -= count) == 0 && waiters > 0)
+	{
+		notify();
+	}
+}
+
+bool IdleTracker::is_idle() const
+{
+	return executing == 0;
+}
+
+void IdleTracker::wait()
+{
+	++waiters;
+	{
+		std::unique_lock<decltype(lock)> guard(lock);
+		idle.wait(guard, [this] { return executing == 0; });
+	}
+	--waiters;
+}
+
+bool IdleTracker::wait_for(std::chrono::milliseconds timeout)
+{
+	++waiters;
+	bool became_idle = false;
+	{
+		std::unique_lock<decltype(lock)> guard(lock);
+		became_idle = idle.wait_for(guard, timeout, [this] { return executing == 0; });
+	}
+	--waiters;
+	return became_idle;
+}
+
+void IdleTracker::when_idle(std::function<void()> action)
+{
+	++waiters;
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		if (executing != 0)
+		{
+			idle_actions.push_back(std::move(action));
+			return;
+		}
+	}
+	--waiters;
+	action();
+}
+
+void IdleTracker::notify()
+{
+	std::vector<std::function<void()>> actions;
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		actions = std::move(idle_actions);
+		idle_actions.clear();
+		waiters -= static_cast<int32_t>(actions.size());
+		idle.notify_all();
+	}
+	for (auto const& action : actions)
+	{
+		try
+		{
+			action();
+		}
+		catch (std::exception const& e)
+		{
+			log->error("Idle action failed | {}", e.what());
+		}
+	}
+}
+}	 // namespace rd
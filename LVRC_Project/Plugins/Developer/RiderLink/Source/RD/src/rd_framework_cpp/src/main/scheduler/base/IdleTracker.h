@@ -0,0 +1,73 @@
+#ifndef RD_CPP_IDLETRACKER_H
+#define RD_CPP_IDLETRACKER_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include "spdlog/spdlog.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Counts actions of a scheduler which are queued or executing and wakes up those waiting for the count to
+ * drop to zero, see [IScheduler::flush_for] and [IScheduler::when_idle]. Executing threads take the lock only when
+ * somebody waits.
+ */
+class RD_FRAMEWORK_API IdleTracker
+{
+public:
+	// region ctor/dtor
+
+	explicit IdleTracker(std::shared_ptr<spdlog::logger> log);
+
+	IdleTracker(IdleTracker const&) = delete;
+
+	IdleTracker& operator=(IdleTracker const&) = delete;
+	// endregion
+
+	void on_queued();
+
+	/**
+	 * \brief Runs the [when_idle] actions on the calling thread if the scheduler has become idle.
+	 */
+	void on_executed(uint32_t count = 1);
+
+	bool is_idle() const;
+
+	void wait();
+
+	bool wait_for(std::chrono::milliseconds timeout);
+
+	void when_idle(std::function<void()> action);
+
+private:
+	std::shared_ptr<spdlog::logger> log;
+	std::atomic<uint32_t> executing{0};
+
+	// a waiter registers before checking [executing], so either it sees zero or on_executed sees the waiter
+	std::atomic<int32_t> waiters{0};
+	std::mutex lock;
+	std::condition_variable idle;
+	std::vector<std::function<void()>> idle_actions;
+
+	void notify();
+};
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_IDLETRACKER_H
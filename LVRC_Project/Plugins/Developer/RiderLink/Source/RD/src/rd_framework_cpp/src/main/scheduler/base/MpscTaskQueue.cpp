@@ -0,0 +1,120 @@
+#include "MpscTaskQueue.h"
+
+#include <utility>
+
+namespace rd
+{
+constexpr uint32_t MpscTaskQueue::POOL_SIZE;
+constexpr uint32_t MpscTaskQueue::NOT_POOLED;
+
+namespace
+{
+constexpr uint64_t VERSION = uint64_t(1) << 32;
+constexpr uint64_t INDEX_MASK = VERSION - 1;
+}	 // namespace
+
+MpscTaskQueue::MpscTaskQueue(uint32_t pool_size) : head(&stub), tail(&stub), pool(new Node[pool_size])
+{
+	for (uint32_t i = 0; i < pool_size; ++i)
+	{
+		pool[i].index = i;
+		pool[i].next_free.store(i + 1 < pool_size ? i + 2 : 0, std::memory_order_relaxed);
+	}
+	free_top.store(pool_size > 0 ? 1 : 0, std::memory_order_relaxed);
+}
+
+MpscTaskQueue::~MpscTaskQueue()
+{
+	// actions pushed after the consumer has stopped
+	action_t action;
+	while (pop(action))
+	{
+	}
+}
+
+void MpscTaskQueue::push(action_t action)
+{
+	Node* node = acquire_node();
+	node->action = std::move(action);
+	link(node);
+}
+
+bool MpscTaskQueue::pop(action_t& action)
+{
+	Node* first = head;
+	Node* next = first->next.load(std::memory_order_acquire);
+	if (first == &stub)
+	{
+		if (next == nullptr)
+		{
+			return false;
+		}
+		head = next;
+		first = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+	if (next == nullptr)
+	{
+		if (first != tail.load(std::memory_order_acquire))
+		{
+			return false;	 // a producer is between swapping the tail and linking
+		}
+		// [first] is the last one, the stub takes its place to keep the queue non-empty
+		link(&stub);
+		next = first->next.load(std::memory_order_acquire);
+		if (next == nullptr)
+		{
+			return false;
+		}
+	}
+	head = next;
+	action = std::move(first->action);
+	first->action = nullptr;
+	release_node(first);
+	return true;
+}
+
+bool MpscTaskQueue::empty() const
+{
+	return head == &stub && tail.load() == &stub;
+}
+
+void MpscTaskQueue::link(Node* node)
+{
+	node->next.store(nullptr, std::memory_order_relaxed);
+	Node* previous = tail.exchange(node);
+	previous->next.store(node, std::memory_order_release);
+}
+
+MpscTaskQueue::Node* MpscTaskQueue::acquire_node()
+{
+	uint64_t top = free_top.load(std::memory_order_acquire);
+	while ((top & INDEX_MASK) != 0)
+	{
+		Node* node = &pool[(top & INDEX_MASK) - 1];
+		// the node may be taken meanwhile, then the version has changed and the value is discarded
+		const uint64_t next = ((top & ~INDEX_MASK) + VERSION) | node->next_free.load(std::memory_order_relaxed);
+		if (free_top.compare_exchange_weak(top, next, std::memory_order_acquire, std::memory_order_acquire))
+		{
+			return node;
+		}
+	}
+	return new Node();
+}
+
+void MpscTaskQueue::release_node(Node* node)
+{
+	if (node->index == NOT_POOLED)
+	{
+		delete node;
+		return;
+	}
+	uint64_t top = free_top.load(std::memory_order_relaxed);
+	uint64_t next = 0;
+	do
+	{
+		node->next_free.store(static_cast<uint32_t>(top & INDEX_MASK), std::memory_order_relaxed);
+		next = ((top & ~INDEX_MASK) + VERSION) | (node->index + 1);
+	} while (!free_top.compare_exchange_weak(top, next, std::memory_order_release, std::memory_order_relaxed));
+}
+}	 // namespace rd
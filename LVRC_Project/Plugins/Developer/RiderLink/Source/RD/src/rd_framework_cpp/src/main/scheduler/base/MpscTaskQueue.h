@@ -0,0 +1,93 @@
+#ifndef RD_CPP_MPSCTASKQUEUE_H
+#define RD_CPP_MPSCTASKQUEUE_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Queue of actions with many producers and a single consumer. Pushing is wait-free apart from taking a node:
+ * nodes come from a preallocated pool which the consumer refills, a node is allocated only while more than
+ * [pool_size] actions are queued. Actions are kept in the nodes, so a [std::function] small enough for its own
+ * buffer is queued without allocations at all.
+ *
+ * Intrusive queue by Dmitry Vyukov: a producer swaps the tail and then links the previous tail to its node,
+ * between these two steps the consumer sees the queue as not yet [empty] but can't take the node.
+ */
+class RD_FRAMEWORK_API MpscTaskQueue
+{
+public:
+	using action_t = std::function<void()>;
+
+	static constexpr uint32_t POOL_SIZE = 1024;
+
+	// region ctor/dtor
+
+	explicit MpscTaskQueue(uint32_t pool_size = POOL_SIZE);
+
+	MpscTaskQueue(MpscTaskQueue const&) = delete;
+
+	MpscTaskQueue& operator=(MpscTaskQueue const&) = delete;
+
+	~MpscTaskQueue();
+	// endregion
+
+	/**
+	 * \brief Any thread.
+	 */
+	void push(action_t action);
+
+	/**
+	 * \brief Consumer only: takes the oldest action.
+	 * \return false if there is none or the producer of the oldest one hasn't finished pushing yet.
+	 */
+	bool pop(action_t& action);
+
+	/**
+	 * \brief Consumer only.
+	 */
+	bool empty() const;
+
+private:
+	static constexpr uint32_t NOT_POOLED = UINT32_MAX;
+
+	struct Node
+	{
+		std::atomic<Node*> next{nullptr};
+		action_t action;
+		// index + 1 of the next free node in [pool]
+		std::atomic<uint32_t> next_free{0};
+		uint32_t index = NOT_POOLED;
+	};
+
+	// consumer side
+	Node* head;
+	std::atomic<Node*> tail;
+	Node stub;
+
+	std::unique_ptr<Node[]> pool;
+	// index + 1 of the top free node, 0 if none, and a version in the high half against ABA among producers
+	std::atomic<uint64_t> free_top{0};
+
+	void link(Node* node);
+
+	Node* acquire_node();
+
+	void release_node(Node* node);
+};
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_MPSCTASKQUEUE_H
@@ -0,0 +1,263 @@
+#include "SchedulerMetrics.h"
+
+#include "scheduler/TimerWheel.h"
+#include "util/core_log.h"
+#include "util/core_util.h"
+
+#include "spdlog/fmt/fmt.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace rd
+{
+static std::shared_ptr<spdlog::logger> logger = util::create_logger("schedulerMetricsLog");
+
+namespace
+{
+int64_t now_in_microseconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t bucket_of(int64_t microseconds)
+{
+	size_t bucket = 0;
+	while (microseconds > 0 && bucket + 1 < SchedulerMetrics::BUCKETS)
+	{
+		microseconds >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+std::chrono::microseconds percentile_of(std::array<uint64_t, SchedulerMetrics::BUCKETS> const& histogram, double percentile)
+{
+	uint64_t total = 0;
+	for (auto count : histogram)
+	{
+		total += count;
+	}
+	if (total == 0)
+	{
+		return std::chrono::microseconds::zero();
+	}
+	const auto rank = static_cast<uint64_t>(static_cast<double>(total) * percentile / 100.0);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < histogram.size(); ++i)
+	{
+		seen += histogram[i];
+		if (seen > rank || seen == total)
+		{
+			return std::chrono::microseconds(int64_t{1} << i);
+		}
+	}
+	return std::chrono::microseconds(int64_t{1} << (SchedulerMetrics::BUCKETS - 1));
+}
+
+std::string const& describe(std::string const& origin)
+{
+	static const std::string unknown = "<<unknown origin>>";
+	return origin.empty() ? unknown : origin;
+}
+
+thread_local QueueOrigin const* current_origin = nullptr;
+}	 // namespace
+
+constexpr size_t SchedulerMetrics::BUCKETS;
+constexpr std::chrono::milliseconds SchedulerMetrics::DEFAULT_LONG_TASK_THRESHOLD;
+
+/**
+ * \brief Records one run of a wrapped action, also when it throws.
+ */
+class SchedulerMetrics::RunScope
+{
+public:
+	RunScope(SchedulerMetrics& metrics, int64_t queued_at, std::string const& origin)
+		: metrics(metrics), origin(origin), started_at(now_in_microseconds())
+	{
+		metrics.queue_depth.fetch_sub(1, std::memory_order_relaxed);
+		metrics.latency_histogram[bucket_of(started_at - queued_at)].fetch_add(1, std::memory_order_relaxed);
+		if (metrics.watched.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<decltype(metrics.running_lock)> guard(metrics.running_lock);
+			task = ++metrics.next_task;
+			metrics.running.push_back(Running{task, started_at, &origin, false});
+		}
+	}
+
+	RunScope(RunScope const&) = delete;
+
+	RunScope& operator=(RunScope const&) = delete;
+
+	~RunScope()
+	{
+		const int64_t run_time = now_in_microseconds() - started_at;
+		metrics.run_time_histogram[bucket_of(run_time)].fetch_add(1, std::memory_order_relaxed);
+		metrics.executed.fetch_add(1, std::memory_order_relaxed);
+
+		bool reported = false;
+		if (task != 0)
+		{
+			std::lock_guard<decltype(metrics.running_lock)> guard(metrics.running_lock);
+			auto& running = metrics.running;
+			auto it = std::find_if(running.begin(), running.end(), [this](Running const& r) { return r.task == task; });
+			if (it != running.end())
+			{
+				reported = it->reported;
+				*it = running.back();
+				running.pop_back();
+			}
+		}
+
+		const auto run_time_ms = run_time / 1000;
+		if (run_time_ms < metrics.long_task_threshold.count())
+		{
+			return;
+		}
+		metrics.long_tasks.fetch_add(1, std::memory_order_relaxed);
+		if (reported)
+		{
+			RD_LOG_WARN(logger, "Task queued by {} finished after {} ms, scheduler={}", describe(origin), run_time_ms,
+				metrics.scheduler_name);
+		}
+		else
+		{
+			RD_LOG_WARN(logger, "Task queued by {} took {} ms, scheduler={}", describe(origin), run_time_ms, metrics.scheduler_name);
+		}
+	}
+
+private:
+	SchedulerMetrics& metrics;
+	std::string const& origin;
+	const int64_t started_at;
+	uint64_t task = 0;
+};
+
+std::chrono::microseconds SchedulerMetrics::Snapshot::latency_percentile(double percentile) const
+{
+	return percentile_of(latency_histogram, percentile);
+}
+
+std::chrono::microseconds SchedulerMetrics::Snapshot::run_time_percentile(double percentile) const
+{
+	return percentile_of(run_time_histogram, percentile);
+}
+
+SchedulerMetrics::SchedulerMetrics(std::string scheduler_name, std::chrono::milliseconds long_task_threshold)
+	: scheduler_name(std::move(scheduler_name)), long_task_threshold(long_task_threshold)
+{
+}
+
+std::function<void()> SchedulerMetrics::wrap(std::function<void()> action)
+{
+	queued.fetch_add(1, std::memory_order_relaxed);
+	const int64_t depth = queue_depth.fetch_add(1, std::memory_order_relaxed) + 1;
+	int64_t max_depth = max_queue_depth.load(std::memory_order_relaxed);
+	while (depth > max_depth && !max_queue_depth.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed))
+	{
+	}
+
+	return [this, action = std::move(action), queued_at = now_in_microseconds(), origin = QueueOrigin::current()] {
+		RunScope scope(*this, queued_at, origin);
+		action();
+	};
+}
+
+void SchedulerMetrics::start_watchdog(Lifetime lifetime)
+{
+	watched = true;
+	lifetime->add_action([this] { watched = false; });
+	const auto period = (std::max)(long_task_threshold / 2, std::chrono::milliseconds(10));
+	TimerWheel::Instance().schedule_periodic(lifetime, period, [this] { check_running(); });
+}
+
+void SchedulerMetrics::check_running()
+{
+	const int64_t now = now_in_microseconds();
+	const int64_t threshold = std::chrono::duration_cast<std::chrono::microseconds>(long_task_threshold).count();
+	std::lock_guard<decltype(running_lock)> guard(running_lock);
+	for (auto& r : running)
+	{
+		if (r.reported || now - r.started_at < threshold)
+		{
+			continue;
+		}
+		r.reported = true;
+		RD_LOG_WARN(logger, "Task queued by {} has been running for {} ms, scheduler={}", describe(*r.origin),
+			(now - r.started_at) / 1000, scheduler_name);
+	}
+}
+
+SchedulerMetrics::Snapshot SchedulerMetrics::snapshot() const
+{
+	Snapshot res;
+	res.queued = queued.load(std::memory_order_relaxed);
+	res.executed = executed.load(std::memory_order_relaxed);
+	res.queue_depth = static_cast<uint64_t>((std::max)(queue_depth.load(std::memory_order_relaxed), int64_t{0}));
+	res.max_queue_depth = static_cast<uint64_t>(max_queue_depth.load(std::memory_order_relaxed));
+	res.long_tasks = long_tasks.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < BUCKETS; ++i)
+	{
+		res.latency_histogram[i] = latency_histogram[i].load(std::memory_order_relaxed);
+		res.run_time_histogram[i] = run_time_histogram[i].load(std::memory_order_relaxed);
+	}
+	return res;
+}
+
+void SchedulerMetrics::reset()
+{
+	queued = 0;
+	executed = 0;
+	max_queue_depth = queue_depth.load();
+	long_tasks = 0;
+	for (size_t i = 0; i < BUCKETS; ++i)
+	{
+		latency_histogram[i] = 0;
+		run_time_histogram[i] = 0;
+	}
+}
+
+std::string const& SchedulerMetrics::get_scheduler_name() const
+{
+	return scheduler_name;
+}
+
+std::chrono::milliseconds SchedulerMetrics::get_long_task_threshold() const
+{
+	return long_task_threshold;
+}
+
+QueueOrigin::QueueOrigin(std::string origin) : origin(std::move(origin)), previous(current_origin)
+{
+	current_origin = this;
+}
+
+QueueOrigin::~QueueOrigin()
+{
+	current_origin = previous;
+}
+
+std::string const& QueueOrigin::current()
+{
+	static const std::string none;
+	for (auto scope = current_origin; scope != nullptr; scope = scope->previous)
+	{
+		if (!scope->origin.empty())
+		{
+			return scope->origin;
+		}
+	}
+	return none;
+}
+
+std::string to_string(SchedulerMetrics::Snapshot const& snapshot)
+{
+	return fmt::format(
+		"queued: {}, executed: {}, queue depth: {} (max {}), long tasks: {}, "
+		"latency p50 <= {} us, p99 <= {} us, run time p50 <= {} us, p99 <= {} us",
+		snapshot.queued, snapshot.executed, snapshot.queue_depth, snapshot.max_queue_depth, snapshot.long_tasks,
+		snapshot.latency_percentile(50).count(), snapshot.latency_percentile(99).count(), snapshot.run_time_percentile(50).count(),
+		snapshot.run_time_percentile(99).count());
+}
+}	 // namespace rd
@@ -0,0 +1,163 @@
+#ifndef RD_CPP_SCHEDULERMETRICS_H
+#define RD_CPP_SCHEDULERMETRICS_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include "lifetime/Lifetime.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Timings of the actions queued to one scheduler, turned on with [IScheduler::set_metrics]. Counters are updated
+ * by the queuing and executing threads and readable from any thread without locks.
+ *
+ * An action taking longer than [long_task_threshold] is logged with the origin it was queued from, see [QueueOrigin]:
+ * when it finishes, or while it's still running if the watchdog is started.
+ */
+class RD_FRAMEWORK_API SchedulerMetrics
+{
+public:
+	/**
+	 * \brief Bucket i counts actions which took [2^(i-1), 2^i) microseconds, the last bucket is open-ended.
+	 */
+	static constexpr size_t BUCKETS = 24;
+
+	static constexpr std::chrono::milliseconds DEFAULT_LONG_TASK_THRESHOLD{100};
+
+	struct RD_FRAMEWORK_API Snapshot
+	{
+		uint64_t queued = 0;
+		uint64_t executed = 0;
+		/**
+		 * \brief Actions queued and not started yet, and the most there have been since the last reset.
+		 */
+		uint64_t queue_depth = 0;
+		uint64_t max_queue_depth = 0;
+		uint64_t long_tasks = 0;
+		/**
+		 * \brief From queuing an action to its start.
+		 */
+		std::array<uint64_t, BUCKETS> latency_histogram{};
+		std::array<uint64_t, BUCKETS> run_time_histogram{};
+
+		/**
+		 * \return upper bound of the bucket holding the [percentile] (0..100) of latencies.
+		 */
+		std::chrono::microseconds latency_percentile(double percentile) const;
+
+		std::chrono::microseconds run_time_percentile(double percentile) const;
+	};
+
+	// region ctor/dtor
+
+	explicit SchedulerMetrics(std::string scheduler_name, std::chrono::milliseconds long_task_threshold = DEFAULT_LONG_TASK_THRESHOLD);
+
+	SchedulerMetrics(SchedulerMetrics const&) = delete;
+
+	SchedulerMetrics& operator=(SchedulerMetrics const&) = delete;
+	// endregion
+
+	/**
+	 * \brief Called by the scheduler when [action] is queued.
+	 * \return action to queue instead, which records the timings of [action] when run.
+	 */
+	std::function<void()> wrap(std::function<void()> action);
+
+	/**
+	 * \brief Checks actions which are running on the shared [TimerWheel] until [lifetime] is terminated, so a stuck one
+	 * is reported before it finishes.
+	 */
+	void start_watchdog(Lifetime lifetime);
+
+	Snapshot snapshot() const;
+
+	/**
+	 * \brief Zeroes counters and histograms, the depth of the queue stays.
+	 */
+	void reset();
+
+	std::string const& get_scheduler_name() const;
+
+	std::chrono::milliseconds get_long_task_threshold() const;
+
+private:
+	struct Running
+	{
+		uint64_t task;
+		int64_t started_at;
+		std::string const* origin;
+		bool reported;
+	};
+
+	class RunScope;
+
+	std::string scheduler_name;
+	std::chrono::milliseconds long_task_threshold;
+
+	std::atomic<uint64_t> queued{0};
+	std::atomic<uint64_t> executed{0};
+	std::atomic<int64_t> queue_depth{0};
+	std::atomic<int64_t> max_queue_depth{0};
+	std::atomic<uint64_t> long_tasks{0};
+	std::array<std::atomic<uint64_t>, BUCKETS> latency_histogram{};
+	std::array<std::atomic<uint64_t>, BUCKETS> run_time_histogram{};
+
+	// actions which are running, tracked only for the watchdog
+	std::atomic<bool> watched{false};
+	std::mutex running_lock;
+	std::vector<Running> running;
+	uint64_t next_task = 0;
+
+	void check_running();
+};
+
+/**
+ * \brief Names the source of the actions which the current thread queues while it's alive, e.g. the location of
+ * the entity whose message is queued, for the long-task reports of [SchedulerMetrics]. Scopes nest.
+ * An empty origin costs nothing, so callers describe the source only if the scheduler has metrics.
+ */
+class RD_FRAMEWORK_API QueueOrigin
+{
+public:
+	// region ctor/dtor
+
+	explicit QueueOrigin(std::string origin);
+
+	QueueOrigin(QueueOrigin const&) = delete;
+
+	QueueOrigin& operator=(QueueOrigin const&) = delete;
+
+	~QueueOrigin();
+	// endregion
+
+	/**
+	 * \return origin of the innermost scope of the current thread, empty if none.
+	 */
+	static std::string const& current();
+
+private:
+	std::string origin;
+	QueueOrigin const* previous;
+};
+
+std::string RD_FRAMEWORK_API to_string(SchedulerMetrics::Snapshot const& snapshot);
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_SCHEDULERMETRICS_H
@@ -1,55 +1,208 @@
 #include "SingleThreadSchedulerBase.h"
 
+#include "IdleTracker.h"
+#include "MpscTaskQueue.h"
+#include "SchedulerMetrics.h"
+
 #include "util/core_util.h"
+#include "util/thread_util.h"
 
-#include "ctpl_stl.h"
-#include "spdlog/include/spdlog/sinks/stdout_color_sinks.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace rd
 {
-SingleThreadSchedulerBase::PoolTask::PoolTask(std::function<void()> f, SingleThreadSchedulerBase* scheduler)
-	: f(std::move(f)), scheduler(scheduler)
+class SingleThreadSchedulerBase::Worker
+{
+public:
+	// actions executed before the counter of executing ones is updated
+	static constexpr uint32_t MAX_BATCH = 256;
+	static constexpr uint32_t INTERACTIVE_WEIGHT = 8;
+	// control actions are few, their queue needs a smaller pool of nodes
+	static constexpr uint32_t CONTROL_POOL_SIZE = 64;
+
+	std::shared_ptr<spdlog::logger> log;
+	std::string name;
+	IdleTracker idle_tracker;
+
+	MpscTaskQueue control_tasks{CONTROL_POOL_SIZE};
+	MpscTaskQueue interactive_tasks;
+	MpscTaskQueue bulk_tasks;
+	std::atomic<bool> parked{false};
+	std::atomic<bool> stopping{false};
+	std::mutex park_lock;
+	std::condition_variable unparked;
+	// kept alive for the wrapped actions still queued when the scheduler is destroyed on its own thread
+	std::shared_ptr<SchedulerMetrics> metrics;
+
+	Worker(std::shared_ptr<spdlog::logger> log, std::string name)
+		: log(std::move(log)), name(std::move(name)), idle_tracker(this->log)
+	{
+	}
+
+	void run();
+
+	void push(SchedulerLane lane, std::function<void()> action);
+
+	void request_stop();
+
+private:
+	// consumer only
+	uint32_t interactive_in_row = 0;
+
+	bool take(MpscTaskQueue::action_t& action);
+
+	bool empty() const;
+};
+
+constexpr uint32_t SingleThreadSchedulerBase::Worker::MAX_BATCH;
+constexpr uint32_t SingleThreadSchedulerBase::Worker::INTERACTIVE_WEIGHT;
+constexpr uint32_t SingleThreadSchedulerBase::Worker::CONTROL_POOL_SIZE;
+
+void SingleThreadSchedulerBase::Worker::run()
+{
+	rd::util::set_thread_name(name.c_str());
+
+	MpscTaskQueue::action_t action;
+	while (true)
+	{
+		uint32_t executed = 0;
+		while (executed < MAX_BATCH && take(action))
+		{
+			try
+			{
+				action();
+			}
+			catch (std::exception const& e)
+			{
+				log->error("Background task failed, scheduler={} | {}", name, e.what());
+			}
+			action = nullptr;
+			++executed;
+		}
+		if (executed > 0)
+		{
+			idle_tracker.on_executed(executed);
+			continue;
+		}
+
+		// announce parking before the last look at the queue, a producer checks it after pushing
+		parked = true;
+		if (empty())
+		{
+			if (stopping)
+			{
+				break;
+			}
+			std::unique_lock<decltype(park_lock)> guard(park_lock);
+			unparked.wait(guard, [this] { return !empty() || stopping; });
+		}
+		parked = false;
+	}
+}
+
+bool SingleThreadSchedulerBase::Worker::take(MpscTaskQueue::action_t& action)
+{
+	if (control_tasks.pop(action))
+	{
+		return true;
+	}
+	if (interactive_in_row < INTERACTIVE_WEIGHT && interactive_tasks.pop(action))
+	{
+		++interactive_in_row;
+		return true;
+	}
+	interactive_in_row = 0;
+	if (bulk_tasks.pop(action))
+	{
+		return true;
+	}
+	if (interactive_tasks.pop(action))
+	{
+		interactive_in_row = 1;
+		return true;
+	}
+	return false;
+}
+
+bool SingleThreadSchedulerBase::Worker::empty() const
 {
+	return control_tasks.empty() && interactive_tasks.empty() && bulk_tasks.empty();
 }
 
-void SingleThreadSchedulerBase::PoolTask::operator()(int id) const
+void SingleThreadSchedulerBase::Worker::push(SchedulerLane lane, std::function<void()> action)
 {
-	try
+	idle_tracker.on_queued();
+	switch (lane)
 	{
-		f();
-		--scheduler->tasks_executing;
+		case SchedulerLane::Control:
+			control_tasks.push(std::move(action));
+			break;
+		case SchedulerLane::Bulk:
+			bulk_tasks.push(std::move(action));
+			break;
+		default:
+			interactive_tasks.push(std::move(action));
+			break;
 	}
-	catch (std::exception const& e)
+	if (parked)
 	{
-		scheduler->log->error("Background task failed, scheduler={}, thread_id={} | {}", scheduler->name, id, e.what());
-		--scheduler->tasks_executing;
+		std::lock_guard<decltype(park_lock)> guard(park_lock);
+		unparked.notify_one();
 	}
 }
 
+void SingleThreadSchedulerBase::Worker::request_stop()
+{
+	std::lock_guard<decltype(park_lock)> guard(park_lock);
+	stopping = true;
+	unparked.notify_one();
+}
+
 SingleThreadSchedulerBase::SingleThreadSchedulerBase(std::string name)
-	: log(spdlog::stderr_color_mt<spdlog::synchronous_factory>(name, spdlog::color_mode::automatic))
-	, name(std::move(name))
-	, pool(std::make_unique<ctpl::thread_pool>(1))
+	: log(util::create_logger(name)), name(std::move(name)), worker(std::make_shared<Worker>(log, this->name))
 {
-	RD_ASSERT_THROW_MSG(pool->size() == 1, "Thread pool wasn't properly initalized");
-	thread_id = pool->get_thread(0).get_id();
+	thread = std::thread([worker = worker] { worker->run(); });
+	thread_id = thread.get_id();
 }
 
 void SingleThreadSchedulerBase::flush()
 {
 	RD_ASSERT_MSG(!is_active(), "Can't flush this scheduler in a reentrant way: we are inside queued item's execution");
 
-	while (tasks_executing != 0)
-	{
-		std::this_thread::yield();
-	}
+	worker->idle_tracker.wait();
+}
+
+bool SingleThreadSchedulerBase::flush_for(std::chrono::milliseconds timeout)
+{
+	RD_ASSERT_MSG(!is_active(), "Can't flush this scheduler in a reentrant way: we are inside queued item's execution");
+
+	return worker->idle_tracker.wait_for(timeout);
+}
+
+void SingleThreadSchedulerBase::when_idle(std::function<void()> action)
+{
+	worker->idle_tracker.when_idle(std::move(action));
 }
 
 void SingleThreadSchedulerBase::queue(std::function<void()> action)
 {
-	++tasks_executing;
-	PoolTask task(action, this);
-	pool->push(std::move(task));
+	queue_in_lane(SchedulerLane::Interactive, std::move(action));
+}
+
+void SingleThreadSchedulerBase::queue_in_lane(SchedulerLane lane, std::function<void()> action)
+{
+	if (worker->stopping)
+	{
+		log->debug("Task dropped, scheduler={} is stopped", name);
+		return;
+	}
+	if (metrics)
+	{
+		action = metrics->wrap(std::move(action));
+	}
+	worker->push(lane, std::move(action));
 }
 
 bool SingleThreadSchedulerBase::is_active() const
@@ -57,5 +210,24 @@ bool SingleThreadSchedulerBase::is_active() const
 	return thread_id == std::this_thread::get_id();
 }
 
-SingleThreadSchedulerBase::~SingleThreadSchedulerBase() = default;
-}	 // namespace rd
\ No newline at end of file
+void SingleThreadSchedulerBase::stop()
+{
+	worker->request_stop();
+	if (!thread.joinable() || is_active())
+	{
+		return;	   // stopped from its own action, the thread finishes the queue and exits by itself
+	}
+	thread.join();
+}
+
+SingleThreadSchedulerBase::~SingleThreadSchedulerBase()
+{
+	stop();
+	if (thread.joinable())
+	{
+		// destroyed by one of its own actions, the thread can't be joined from itself and owns [worker] from now on
+		worker->metrics = metrics;
+		thread.detach();
+	}
+}
+}	 // namespace rd
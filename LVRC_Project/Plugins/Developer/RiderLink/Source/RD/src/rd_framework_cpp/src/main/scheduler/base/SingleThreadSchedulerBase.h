@@ -10,37 +10,41 @@
 #include "lifetime/Lifetime.h"
 #include "spdlog/spdlog.h"
 
+#include <memory>
+#include <thread>
 #include <utility>
 
 #include <rd_framework_export.h>
 
-namespace ctpl
-{
-class thread_pool;
-}
-
 namespace rd
 {
+/**
+ * \brief Executes queued actions one by one on its own thread. The thread drains the queue in batches and parks on
+ * a condition variable once it's empty, producers take the lock only to wake it up.
+ *
+ * Each [SchedulerLane] has a queue of its own. [SchedulerLane::Control] has strict priority, [SchedulerLane::Bulk]
+ * gets one turn after every eight interactive actions while both are waiting, so neither starves.
+ */
 class RD_FRAMEWORK_API SingleThreadSchedulerBase : public IScheduler
 {
 protected:
 	std::shared_ptr<spdlog::logger> log;
 	std::string name;
 
-	std::atomic_uint32_t tasks_executing{0};
-	std::atomic_uint32_t active{0};
-	std::unique_ptr<ctpl::thread_pool> pool;
-
-	class PoolTask
-	{
-		std::function<void()> f;
-		SingleThreadSchedulerBase* scheduler;
+	/**
+	 * \brief Executes the actions queued so far and joins the thread, later actions are dropped.
+	 */
+	void stop();
 
-	public:
-		explicit PoolTask(std::function<void()> f, SingleThreadSchedulerBase* scheduler);
+private:
+	/**
+	 * \brief Queues and state of the thread. The thread shares their ownership, so when the scheduler is destroyed by
+	 * one of its own actions the thread finishes the queue and exits without touching the scheduler.
+	 */
+	class Worker;
 
-		void operator()(int id) const;
-	};
+	std::shared_ptr<Worker> worker;
+	std::thread thread;
 
 public:
 	// region ctor/dtor
@@ -51,8 +55,14 @@ public:
 
 	void flush() override;
 
+	bool flush_for(std::chrono::milliseconds timeout) override;
+
+	void when_idle(std::function<void()> action) override;
+
 	void queue(std::function<void()> action) override;
 
+	void queue_in_lane(SchedulerLane lane, std::function<void()> action) override;
+
 	bool is_active() const override;
 };
 }	 // namespace rd
@@ -0,0 +1,35 @@
+#include "WaitableEvent.h"
+
+namespace rd
+{
+void WaitableEvent::set()
+{
+	std::lock_guard<decltype(lock)> guard(lock);
+	signaled = true;
+	var.notify_all();
+}
+
+void WaitableEvent::reset()
+{
+	std::lock_guard<decltype(lock)> guard(lock);
+	signaled = false;
+}
+
+bool WaitableEvent::is_set() const
+{
+	std::lock_guard<decltype(lock)> guard(lock);
+	return signaled;
+}
+
+void WaitableEvent::wait() const
+{
+	std::unique_lock<decltype(lock)> guard(lock);
+	var.wait(guard, [this] { return signaled; });
+}
+
+bool WaitableEvent::wait_for(std::chrono::milliseconds timeout) const
+{
+	std::unique_lock<decltype(lock)> guard(lock);
+	return var.wait_for(guard, timeout, [this] { return signaled; });
+}
+}	 // namespace rd
@@ -0,0 +1,59 @@
+#ifndef RD_CPP_WAITABLEEVENT_H
+#define RD_CPP_WAITABLEEVENT_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Flag which threads can block on until it's set, e.g. by [IScheduler::when_idle] or a task completion.
+ * Waiting threads sleep instead of spinning. Usually shared, because the setter may outlive the waiter.
+ */
+class RD_FRAMEWORK_API WaitableEvent
+{
+public:
+	// region ctor/dtor
+
+	WaitableEvent() = default;
+
+	WaitableEvent(WaitableEvent const&) = delete;
+
+	WaitableEvent& operator=(WaitableEvent const&) = delete;
+	// endregion
+
+	/**
+	 * \brief Wakes up all waiting threads, later waits return immediately until [reset].
+	 */
+	void set();
+
+	void reset();
+
+	bool is_set() const;
+
+	void wait() const;
+
+	/**
+	 * \return whether the event has been set before [timeout] passed.
+	 */
+	bool wait_for(std::chrono::milliseconds timeout) const;
+
+private:
+	mutable std::mutex lock;
+	mutable std::condition_variable var;
+	bool signaled = false;
+};
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_WAITABLEEVENT_H
@@ -45,12 +45,12 @@ class Polymorphic<T, typename std::enable_if_t<std::is_integral<T>::value>>
 public:
 	inline static T read(SerializationCtx& /*ctx*/, Buffer& buffer)
 	{
-		return buffer.read_integral<T>();
+		return buffer.read_compact<T>();
 	}
 
 	inline static void write(SerializationCtx& /*ctx*/, Buffer& buffer, T const& value)
 	{
-		buffer.write_integral<T>(value);
+		buffer.write_compact<T>(value);
 	}
 };
 
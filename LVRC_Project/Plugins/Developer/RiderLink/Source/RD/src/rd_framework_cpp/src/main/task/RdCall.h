@@ -4,10 +4,13 @@
 #include "serialization/Polymorphic.h"
 #include "RdTask.h"
 #include "RdTaskResult.h"
+#include "ResponseBatch.h"
 #include "scheduler/SynchronousScheduler.h"
+#include "scheduler/base/WaitableEvent.h"
 #include "WiredRdTask.h"
 
-#include <thread>
+#include <memory>
+#include <vector>
 
 #if defined(_MSC_VER)
 #pragma warning(push)
@@ -71,14 +74,15 @@ public:
 	 */
 	WiredRdTask<TRes, ResSer> sync(TReq const& request, std::chrono::milliseconds timeout = 200ms) const
 	{
-		auto task = start_internal(request, true, &SynchronousScheduler::Instance());
 		auto time_at_start = std::chrono::system_clock::now();
-		while (!task.has_value() && !(*bind_lifetime)->is_terminated() &&
-			   ((std::chrono::system_clock::now() - time_at_start) < timeout))
-		{
-			std::this_thread::yield();
-		}
-		spdlog::debug("Time elapsed: {}, has_value={}", to_string(std::chrono::system_clock::now() - time_at_start),
+		// the peer may need a response held on this thread to answer
+		ResponseBatch::flush();
+		// set by the response or by unbinding the call, shared with the notifying thread which may outlive this call
+		auto completed = std::make_shared<WaitableEvent>();
+		auto task = start_internal(request, true, &SynchronousScheduler::Instance(),
+			[&completed](WiredRdTask<TRes, ResSer> const& started) { started.on_completed([completed] { completed->set(); }); });
+		completed->wait_for(timeout);
+		RD_LOG_DEBUG(logSend, "Time elapsed: {}, has_value={}", to_string(std::chrono::system_clock::now() - time_at_start),
 			to_string(task.has_value()));
 		task.value_or_throw().unwrap();	   // check for existing value
 		sync_task_id = nullopt;
@@ -102,13 +106,46 @@ public:
 		return start_internal(request, false, responseScheduler ? responseScheduler : get_default_scheduler());
 	}
 
+	/**
+	 * \brief Same as [start], cancelled when [lifetime] is terminated before the result arrives: the task is completed
+	 * as cancelled and the endpoint is told to terminate the lifetime of the handler, see [RdEndpoint::set_executor].
+	 */
+	WiredRdTask<TRes, ResSer> start(Lifetime lifetime, TReq const& request, IScheduler* responseScheduler = nullptr) const
+	{
+		auto task = start_internal(request, false, responseScheduler ? responseScheduler : get_default_scheduler());
+		task.cancel_with(std::move(lifetime));
+		return task;
+	}
+
+	/**
+	 * \brief Asynchronously invokes the API once per request, pipelined: the requests leave in a single package
+	 * instead of one package and acknowledgement each.
+	 *
+	 * \param requests values of requests
+	 * \param responseScheduler to assign values
+	 * \return tasks which will have the result values, in the order of [requests].
+	 */
+	std::vector<WiredRdTask<TRes, ResSer>> start_batch(std::vector<TReq> const& requests, IScheduler* responseScheduler = nullptr) const
+	{
+		auto scheduler = responseScheduler ? responseScheduler : get_default_scheduler();
+		std::vector<WiredRdTask<TRes, ResSer>> tasks;
+		tasks.reserve(requests.size());
+		IWire::SendBatch batch(*get_wire());
+		for (auto const& request : requests)
+		{
+			tasks.push_back(start_internal(request, false, scheduler));
+		}
+		return tasks;
+	}
+
 	void on_wire_received(Buffer buffer) const override
 	{
 		RD_ASSERT_MSG(false, "RdCall.on_wire_received called")
 	}
 
 private:
-	WiredRdTask<TRes, ResSer> start_internal(TReq const& request, bool sync, IScheduler* scheduler) const
+	WiredRdTask<TRes, ResSer> start_internal(TReq const& request, bool sync, IScheduler* scheduler,
+		std::function<void(WiredRdTask<TRes, ResSer> const&)> const& before_send = {}) const
 	{
 		assert_bound();
 		if (!async)
@@ -128,9 +165,13 @@ private:
 			}
 			sync_task_id = task_id;
 		}
+		if (before_send)
+		{
+			before_send(task);
+		}
 
 		get_wire()->send(rdid, [&](Buffer& buffer) {
-			spdlog::get("logSend")->trace("call {}::{} send {} request {} : {}", to_string(location), to_string(rdid), (sync ? "SYNC" : "ASYNC"),
+			RD_LOG_TRACE(logSend, "call {}::{} send {} request {} : {}", to_string(location), to_string(rdid), (sync ? "SYNC" : "ASYNC"),
 				to_string(task_id), to_string(request));
 			task_id.write(buffer);
 			ReqSer::write(get_serialization_context(), buffer, request);
@@ -3,6 +3,13 @@
 
 #include "serialization/Polymorphic.h"
 #include "RdTask.h"
+#include "ResponseBatch.h"
+#include "lifetime/LifetimeDefinition.h"
+#include "scheduler/SynchronousScheduler.h"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
 
 #if defined(_MSC_VER)
 #pragma warning(push)
@@ -11,6 +18,73 @@
 
 namespace rd
 {
+namespace detail
+{
+/**
+ * \brief Counters of an endpoint, shared with its requests which may finish after it's gone.
+ */
+struct EndpointCounters
+{
+	std::atomic<uint64_t> in_flight{0};
+	std::atomic<uint64_t> rejected{0};
+	std::atomic<uint64_t> cancelled{0};
+	std::atomic<uint64_t> completed{0};
+};
+
+/**
+ * \brief A request which an endpoint runs on its executor. Owns the lifetime given to the handler and terminates it
+ * when the caller cancels the call: the cancellation is an empty message to the task's id.
+ */
+class EndpointRequest final : public RdReactiveBase
+{
+	std::shared_ptr<EndpointCounters> counters;
+	std::atomic<bool> finished{false};
+
+public:
+	// terminated by the cancellation, by unbinding the endpoint or once the response is sent
+	mutable LifetimeDefinition definition;
+
+	// region ctor/dtor
+
+	EndpointRequest(Lifetime parent, RdId task_id, std::shared_ptr<EndpointCounters> counters)
+		: counters(std::move(counters)), definition(parent)
+	{
+		rdid = std::move(task_id);
+		definition.lifetime->add_action([this] {
+			if (finish())
+			{
+				this->counters->cancelled.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+	}
+	// endregion
+
+	/**
+	 * \return whether the request has just finished, i.e. it has been neither completed nor cancelled before.
+	 */
+	bool finish()
+	{
+		if (finished.exchange(true))
+		{
+			return false;
+		}
+		counters->in_flight.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	void on_wire_received(Buffer /*buffer*/) const override
+	{
+		RD_LOG_TRACE(logReceived, "endpoint request {} received cancellation", to_string(rdid));
+		definition.terminate();
+	}
+
+	IScheduler* get_wire_scheduler() const override
+	{
+		return &SynchronousScheduler::Instance();
+	}
+};
+}	 // namespace detail
+
 /**
  * \brief An API that is exposed to the remote process and can be invoked over the protocol.
  *
@@ -28,8 +102,21 @@ class RdEndpoint : public virtual RdReactiveBase, public ISerializable
 	using handler_t = std::function<RdTask<TRes, ResSer>(Lifetime, TReq const&)>;
 	mutable handler_t local_handler;
 
-	mutable tsl::ordered_map<RdId, RdTask<TRes, ResSer>, rd::hash<RdId>> awaiting_tasks;	// todo get rid of it
+	mutable IScheduler* executor = nullptr;
+	mutable size_t max_concurrency = 0;
+	mutable std::shared_ptr<detail::EndpointCounters> counters = std::make_shared<detail::EndpointCounters>();
+
 public:
+	struct Stats
+	{
+		uint64_t in_flight = 0;
+		// answered with a fault because [max_concurrency] requests were running
+		uint64_t rejected = 0;
+		// by the caller or by unbinding the endpoint before the handler has completed
+		uint64_t cancelled = 0;
+		uint64_t completed = 0;
+	};
+
 	// region ctor/dtor
 
 	RdEndpoint() = default;
@@ -87,6 +174,31 @@ public:
 		};
 	}
 
+	/**
+	 * \brief Runs the handler on [executor], e.g. a [ThreadPoolScheduler], instead of the wire scheduler of the endpoint,
+	 * so a slow request doesn't hold up the ones behind it. At most [max_concurrency] requests run at once, 0 for no
+	 * limit: a request over the limit is answered with a fault right away. The handler gets a lifetime of its own, which
+	 * is terminated when the caller cancels the call, see [RdCall::start]. Must be called before binding.
+	 */
+	void set_executor(IScheduler* executor, size_t max_concurrency = 0) const
+	{
+		this->executor = executor;
+		this->max_concurrency = max_concurrency;
+	}
+
+	/**
+	 * \brief Requests run on the executor so far, see [set_executor].
+	 */
+	Stats get_stats() const
+	{
+		Stats res;
+		res.in_flight = counters->in_flight.load(std::memory_order_relaxed);
+		res.rejected = counters->rejected.load(std::memory_order_relaxed);
+		res.cancelled = counters->cancelled.load(std::memory_order_relaxed);
+		res.completed = counters->completed.load(std::memory_order_relaxed);
+		return res;
+	}
+
 	void init(Lifetime lifetime) const override
 	{
 		RdReactiveBase::init(lifetime);
@@ -98,12 +210,17 @@ public:
 	{
 		auto task_id = RdId::read(buffer);
 		auto value = ReqSer::read(get_serialization_context(), buffer);
-		spdlog::get("logReceived")->trace("endpoint {}::{} request = {}", to_string(location), to_string(rdid), to_string(value));
+		RD_LOG_TRACE(logReceived, "endpoint {}::{} request = {}", to_string(location), to_string(rdid), to_string(value));
 		if (!local_handler)
 		{
 			throw std::invalid_argument("handler is empty for RdEndPoint");
 		}
-		auto task = awaiting_tasks[task_id] = {};
+		if (executor != nullptr)
+		{
+			run_on_executor(std::move(task_id), std::move(value));
+			return;
+		}
+		RdTask<TRes, ResSer> task;
 		try
 		{
 			task = local_handler(*bind_lifetime, wrapper::get<TReq>(value));
@@ -112,13 +229,75 @@ public:
 		{
 			task.fault(e);
 		}
-		task.advise(*bind_lifetime, [this, task_id, &task](RdTaskResult<TRes, ResSer> const& task_result) {
-			spdlog::get("logSend")->trace("endpoint {}::{} response = {}", to_string(location), to_string(rdid), to_string(*task.result));
-			get_wire()->send(task_id, [&](Buffer& inner_buffer) { task_result.write(get_serialization_context(), inner_buffer); });
-			// todo remove from awaiting_tasks
+		// the handler may complete the task later, e.g. a coroutine, after [task] has gone out of scope
+		task.advise(*bind_lifetime,
+			[this, task_id](RdTaskResult<TRes, ResSer> const& task_result) { send_response(task_id, task_result); });
+	}
+
+private:
+	void run_on_executor(RdId task_id, WTReq value) const
+	{
+		const uint64_t running = counters->in_flight.fetch_add(1, std::memory_order_relaxed);
+		if (max_concurrency != 0 && running >= max_concurrency)
+		{
+			counters->in_flight.fetch_sub(1, std::memory_order_relaxed);
+			counters->rejected.fetch_add(1, std::memory_order_relaxed);
+			send_response(task_id, typename RdTaskResult<TRes, ResSer>::Fault(std::runtime_error(
+									   "Too many requests to endpoint " + to_string(location) + ", limit is " +
+									   std::to_string(max_concurrency))));
+			return;
+		}
+
+		auto request = std::make_shared<detail::EndpointRequest>(*bind_lifetime, std::move(task_id), counters);
+		// a cancellation which has arrived meanwhile waits in the broker and is delivered right away
+		get_wire()->advise(request->definition.lifetime, request.get());
+		// the endpoint may be unbound or destroyed while the handler runs, so the action keeps what it needs instead of [this]
+		executor->queue([request, handler = local_handler, wire = get_protocol()->wire, ctx = &get_serialization_context(),
+							counters = counters, value = std::move(value)]() {
+			if (request->definition.is_terminated())
+			{
+				return;
+			}
+			RdTask<TRes, ResSer> task;
+			try
+			{
+				task = handler(request->definition.lifetime, wrapper::get<TReq>(value));
+			}
+			catch (std::exception const& e)
+			{
+				task.fault(e);
+			}
+			// unbinding the endpoint or a cancellation terminates the request, the caller doesn't wait for its response anymore
+			task.advise(request->definition.lifetime, [request, wire, ctx, counters](RdTaskResult<TRes, ResSer> const& task_result) {
+				if (request->finish())
+				{
+					counters->completed.fetch_add(1, std::memory_order_relaxed);
+					RD_LOG_TRACE(logSend, "endpoint request {} response = {}", to_string(request->rdid), to_string(task_result));
+					send_response(*wire, *ctx, request->rdid, task_result);
+				}
+				request->definition.terminate();
+			});
 		});
 	}
 
+	void send_response(RdId const& task_id, RdTaskResult<TRes, ResSer> const& task_result) const
+	{
+		RD_LOG_TRACE(logSend, "endpoint {}::{} response = {}", to_string(location), to_string(rdid), to_string(task_result));
+		send_response(*get_wire(), get_serialization_context(), task_id, task_result);
+	}
+
+	static void send_response(
+		IWire const& wire, SerializationCtx& ctx, RdId const& task_id, RdTaskResult<TRes, ResSer> const& task_result)
+	{
+		auto writer = [&](Buffer& inner_buffer) { task_result.write(ctx, inner_buffer); };
+		// requests delivered together are answered together, see [MessageBroker::deliver_all]
+		if (!ResponseBatch::add(wire, task_id, writer))
+		{
+			wire.send(task_id, writer);
+		}
+	}
+
+public:
 	friend bool operator==(const RdEndpoint& lhs, const RdEndpoint& rhs)
 	{
 		return &lhs == &rhs;
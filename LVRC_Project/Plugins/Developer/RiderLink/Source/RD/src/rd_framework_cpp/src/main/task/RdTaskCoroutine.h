@@ -0,0 +1,312 @@
+#ifndef RD_CPP_RDTASKCOROUTINE_H
+#define RD_CPP_RDTASKCOROUTINE_H
+
+#if defined(__has_include)
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+#define RD_CPP_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifndef RD_CPP_HAS_COROUTINES
+#define RD_CPP_HAS_COROUTINES 0
+#endif
+
+#if RD_CPP_HAS_COROUTINES
+
+#include "RdTask.h"
+#include "WiredRdTask.h"
+#include "lifetime/LifetimeDefinition.h"
+#include "scheduler/SynchronousScheduler.h"
+#include "scheduler/base/IScheduler.h"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace rd
+{
+/**
+ * \brief Result of `co_await` on an [RdTask], e.g. a call started with [RdCall::start]: suspends the coroutine until the
+ * task has a result and gives it back as [RdTaskResult].
+ *
+ * The coroutine resumes on [scheduler], right where the result is set if that's already its thread, so a call started
+ * with the coroutine's own scheduler as the response scheduler continues without another round trip through the
+ * queue. Without a scheduler it resumes on whichever thread sets the result. Once [lifetime] is terminated the coroutine
+ * resumes with a cancelled result instead, the task itself is left as is.
+ *
+ * Like [RdTask::advise] it must be awaited on the thread which sets the result, e.g. the response scheduler of a call.
+ * A [WiredRdTask] is awaited with [WiredRdTask::on_completed], which allows to drop the task as soon as it's resumed.
+ * Nothing is allocated if the result is already there, otherwise one shared state and a subscription, the same as
+ * a callback which can be cancelled.
+ */
+template <typename TTask>
+class RdTaskAwaiter
+{
+public:
+	using result_type = typename TTask::result_type;
+
+	// region ctor/dtor
+
+	RdTaskAwaiter(TTask task, IScheduler* scheduler, Lifetime lifetime)
+		: task(std::move(task)), scheduler(scheduler), lifetime(std::move(lifetime))
+	{
+	}
+	// endregion
+
+	bool await_ready() const
+	{
+		return (task.has_value() || lifetime->is_terminated()) && is_on_scheduler();
+	}
+
+	bool await_suspend(std::coroutine_handle<> handle)
+	{
+		state = std::make_shared<State>();
+		state->handle = handle;
+		state->scheduler = scheduler;
+
+		Lifetime subscription = Lifetime::Eternal();
+		if (!lifetime->is_eternal())
+		{
+			if (lifetime->is_terminated())
+			{
+				state->cancelled = true;
+				return state->suspend_unless_ready(true);
+			}
+			waiting = std::make_unique<LifetimeDefinition>(lifetime);
+			subscription = waiting->lifetime;
+			subscription->add_action([state = state] {
+				if (!state->completed.exchange(true))
+				{
+					state->cancelled = true;
+					state->on_completed();
+				}
+			});
+		}
+		// called right away if the result has been set meanwhile, then it's taken below instead of resuming
+		subscribe(task, subscription, [state = state] {
+			if (!state->completed.exchange(true))
+			{
+				state->on_completed();
+			}
+		});
+		return state->suspend_unless_ready(false);
+	}
+
+	result_type await_resume()
+	{
+		const bool cancelled = state != nullptr ? state->cancelled : !task.has_value();
+		// ends the subscription, unless it's the termination which has resumed the coroutine
+		waiting.reset();
+		if (cancelled)
+		{
+			return typename result_type::Cancelled();
+		}
+		return task.value_or_throw();
+	}
+
+private:
+	struct State
+	{
+		std::coroutine_handle<> handle;
+		IScheduler* scheduler = nullptr;
+		std::atomic<bool> completed{false};
+		// set by whichever of [await_suspend] and the completion comes second
+		std::atomic<bool> armed{false};
+		bool cancelled = false;
+
+		void on_completed()
+		{
+			if (armed.exchange(true))
+			{
+				resume();
+			}
+		}
+
+		/**
+		 * \return whether the coroutine stays suspended.
+		 */
+		bool suspend_unless_ready(bool ready)
+		{
+			if (!ready && !armed.exchange(true))
+			{
+				return true;	// the completion resumes it
+			}
+			if (scheduler == nullptr || scheduler->is_active())
+			{
+				return false;
+			}
+			resume();
+			return true;
+		}
+
+		void resume()
+		{
+			if (scheduler == nullptr || scheduler->is_active())
+			{
+				handle.resume();
+			}
+			else
+			{
+				scheduler->queue([handle = handle] { handle.resume(); });
+			}
+		}
+	};
+
+	TTask task;
+	IScheduler* scheduler;
+	Lifetime lifetime;
+	std::shared_ptr<State> state;
+	std::unique_ptr<LifetimeDefinition> waiting;
+
+	template <typename T, typename S>
+	static void subscribe(RdTask<T, S> const& task, Lifetime lifetime, std::function<void()> handler)
+	{
+		task.advise(lifetime, [handler = std::move(handler)](result_type const&) { handler(); });
+	}
+
+	// the response may be the last moment the task is needed, which is safe only after its subscribers are notified
+	template <typename T, typename S>
+	static void subscribe(WiredRdTask<T, S> const& task, Lifetime /*lifetime*/, std::function<void()> handler)
+	{
+		if (task.has_value())
+		{
+			handler();
+			return;
+		}
+		task.on_completed(std::move(handler));
+	}
+
+	bool is_on_scheduler() const
+	{
+		return scheduler == nullptr || scheduler->is_active();
+	}
+};
+
+/**
+ * \brief `co_await task` resumes where the result is set, see [RdTaskAwaiter].
+ */
+template <typename T, typename S>
+RdTaskAwaiter<RdTask<T, S>> operator co_await(RdTask<T, S> const& task)
+{
+	return RdTaskAwaiter<RdTask<T, S>>(task, nullptr, Lifetime::Eternal());
+}
+
+template <typename T, typename S>
+RdTaskAwaiter<WiredRdTask<T, S>> operator co_await(WiredRdTask<T, S> const& task)
+{
+	return RdTaskAwaiter<WiredRdTask<T, S>>(task, nullptr, Lifetime::Eternal());
+}
+
+/**
+ * \brief `co_await await_on(task, scheduler, lifetime)` resumes on [scheduler], cancelled with [lifetime].
+ */
+template <typename T, typename S>
+RdTaskAwaiter<RdTask<T, S>> await_on(RdTask<T, S> const& task, IScheduler* scheduler, Lifetime lifetime = Lifetime::Eternal())
+{
+	return RdTaskAwaiter<RdTask<T, S>>(task, scheduler, std::move(lifetime));
+}
+
+template <typename T, typename S>
+RdTaskAwaiter<WiredRdTask<T, S>> await_on(
+	WiredRdTask<T, S> const& task, IScheduler* scheduler, Lifetime lifetime = Lifetime::Eternal())
+{
+	return RdTaskAwaiter<WiredRdTask<T, S>>(task, scheduler, std::move(lifetime));
+}
+
+/**
+ * \brief `co_await resume_on(scheduler)` continues the coroutine on [scheduler], right away if it's already there.
+ */
+class SchedulerAwaiter
+{
+public:
+	explicit SchedulerAwaiter(IScheduler* scheduler) : scheduler(scheduler)
+	{
+	}
+
+	bool await_ready() const
+	{
+		return scheduler->is_active();
+	}
+
+	void await_suspend(std::coroutine_handle<> handle) const
+	{
+		scheduler->queue([handle] { handle.resume(); });
+	}
+
+	void await_resume() const
+	{
+	}
+
+private:
+	IScheduler* scheduler;
+};
+
+inline SchedulerAwaiter resume_on(IScheduler* scheduler)
+{
+	return SchedulerAwaiter(scheduler);
+}
+
+namespace detail
+{
+/**
+ * \brief Makes a coroutine returning [RdTask], e.g. an endpoint handler: it starts right away on the calling thread,
+ * `co_return value` completes the task and an escaped exception faults it.
+ */
+template <typename T, typename S>
+class RdTaskPromise
+{
+public:
+	RdTask<T, S> get_return_object() const
+	{
+		return task;
+	}
+
+	std::suspend_never initial_suspend() const noexcept
+	{
+		return {};
+	}
+
+	std::suspend_never final_suspend() const noexcept
+	{
+		return {};
+	}
+
+	void return_value(value_or_wrapper<T> value) const
+	{
+		task.set(std::move(value));
+	}
+
+	void unhandled_exception() const
+	{
+		try
+		{
+			throw;
+		}
+		catch (std::exception const& e)
+		{
+			task.fault(e);
+		}
+		catch (...)
+		{
+			task.fault(std::runtime_error("Unknown exception in coroutine"));
+		}
+	}
+
+private:
+	RdTask<T, S> task;
+};
+}	 // namespace detail
+}	 // namespace rd
+
+template <typename T, typename S, typename... Args>
+struct std::coroutine_traits<rd::RdTask<T, S>, Args...>
+{
+	using promise_type = rd::detail::RdTaskPromise<T, S>;
+};
+
+#endif	  // RD_CPP_HAS_COROUTINES
+
+#endif	  // RD_CPP_RDTASKCOROUTINE_H
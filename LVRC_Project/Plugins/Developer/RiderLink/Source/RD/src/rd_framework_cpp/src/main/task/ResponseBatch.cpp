@@ -0,0 +1,90 @@
+#include "ResponseBatch.h"
+
+#include "util/core_log.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rd
+{
+namespace
+{
+struct HeldResponse
+{
+	IWire const* wire;
+	RdId task_id;
+	Buffer::ByteArray payload;
+};
+
+struct ThreadBatch
+{
+	int depth = 0;
+	std::vector<HeldResponse> responses;
+};
+
+thread_local ThreadBatch current_batch;
+
+std::shared_ptr<spdlog::logger> logger = util::create_logger("responseBatchLog");
+}	 // namespace
+
+ResponseBatch::ResponseBatch()
+{
+	++current_batch.depth;
+}
+
+ResponseBatch::~ResponseBatch()
+{
+	if (--current_batch.depth > 0)
+	{
+		return;
+	}
+	try
+	{
+		flush();
+	}
+	catch (std::exception const& e)
+	{
+		RD_LOG_ERROR(logger, "Failed to send batched responses | {}", e.what());
+	}
+}
+
+bool ResponseBatch::add(IWire const& wire, RdId const& task_id, std::function<void(Buffer& buffer)> const& writer)
+{
+	if (current_batch.depth == 0)
+	{
+		return false;
+	}
+	// written before the wire has chosen the encoding of the message, so it's sent as written
+	Buffer buffer;
+	writer(buffer);
+	current_batch.responses.push_back(HeldResponse{&wire, task_id, std::move(buffer).getRealArray()});
+	return true;
+}
+
+void ResponseBatch::flush()
+{
+	if (current_batch.responses.empty())
+	{
+		return;
+	}
+	std::vector<HeldResponse> responses;
+	std::swap(responses, current_batch.responses);
+
+	std::unique_ptr<IWire::SendBatch> batch;
+	IWire const* batch_wire = nullptr;
+	for (auto const& response : responses)
+	{
+		if (response.wire != batch_wire)
+		{
+			batch.reset();
+			batch = std::make_unique<IWire::SendBatch>(*response.wire);
+			batch_wire = response.wire;
+		}
+		response.wire->send(response.task_id, [&response](Buffer& buffer) {
+			buffer.set_compact(false);
+			buffer.write_byte_array_raw(response.payload);
+		});
+	}
+}
+}	 // namespace rd
@@ -0,0 +1,57 @@
+#ifndef RD_CPP_RESPONSEBATCH_H
+#define RD_CPP_RESPONSEBATCH_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include "base/IWire.h"
+#include "protocol/Buffer.h"
+#include "protocol/RdId.h"
+
+#include <functional>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Collects the responses which endpoints complete on the current thread while it's alive, e.g. while the message
+ * broker delivers a group of requests which arrived together, and sends them in one package per wire when it ends.
+ *
+ * A response is written right away and only its bytes are held, the handlers of the group run outside of any
+ * [IWire::SendBatch]. Anything which waits for a reply on this thread, e.g. [RdCall::sync], calls [flush] first, so
+ * the peer never waits for a held response. Scopes nest, only the outermost one sends.
+ */
+class RD_FRAMEWORK_API ResponseBatch
+{
+public:
+	// region ctor/dtor
+
+	ResponseBatch();
+
+	ResponseBatch(ResponseBatch const&) = delete;
+
+	ResponseBatch& operator=(ResponseBatch const&) = delete;
+
+	~ResponseBatch();
+	// endregion
+
+	/**
+	 * \brief Writes a response to [task_id] with [writer] and holds it until the scope of the current thread ends.
+	 * \return false if the current thread has no scope open, the response must be sent right away then.
+	 */
+	static bool add(IWire const& wire, RdId const& task_id, std::function<void(Buffer& buffer)> const& writer);
+
+	/**
+	 * \brief Sends the responses held on the current thread so far.
+	 */
+	static void flush();
+};
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_RESPONSEBATCH_H
@@ -32,6 +32,25 @@ public:
 
 	virtual ~WiredRdTask() = default;
 	// endregion
+
+	/**
+	 * \brief [handler] is called after the result has been set and its subscribers notified, on the thread which set it.
+	 * Unlike a subscription it's safe to drop the task from the handler's notification. Must be set before the request is sent
+	 * or on the thread which completes the task, e.g. by [RdTaskAwaiter] running on the response scheduler.
+	 */
+	void on_completed(std::function<void()> handler) const
+	{
+		impl->completion_handler = std::move(handler);
+	}
+
+	/**
+	 * \brief Cancels the call once [lifetime] is terminated, unless it has completed by then: the task is completed as
+	 * cancelled and the endpoint terminates the lifetime it has given to the handler. Call after the request is sent.
+	 */
+	void cancel_with(Lifetime lifetime) const
+	{
+		impl->cancel_with(std::move(lifetime));
+	}
 };
 }	 // namespace rd
 
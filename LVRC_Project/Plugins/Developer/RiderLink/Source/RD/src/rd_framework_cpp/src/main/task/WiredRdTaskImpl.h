@@ -3,6 +3,7 @@
 
 #include "serialization/Polymorphic.h"
 #include "RdTaskResult.h"
+#include "scheduler/SynchronousScheduler.h"
 
 namespace rd
 {
@@ -22,6 +23,22 @@ private:
 
 	LifetimeImpl::counter_t termination_lifetime_id{};
 
+	mutable Lifetime cancellation_lifetime = Lifetime::Eternal();
+	mutable LifetimeImpl::counter_t cancellation_lifetime_id{};
+
+	mutable std::function<void()> completion_handler;
+
+	void complete(RdTaskResult<T, S> value) const
+	{
+		result->set_if_empty(std::move(value));
+		if (completion_handler)
+		{
+			// a copy: whoever waits for the task may destroy it as soon as it's notified
+			auto handler = completion_handler;
+			handler();
+		}
+	}
+
 public:
 	template <typename, typename>
 	friend class ::rd::WiredRdTask;
@@ -33,28 +50,53 @@ public:
 		this->rdid = std::move(rdid);
 		cutpoint.get_wire()->advise(lifetime, this);
 		termination_lifetime_id =
-			lifetime->add_action([this]() { this->result->set_if_empty(typename RdTaskResult<T, S>::Cancelled{}); });
+			lifetime->add_action([this]() { this->complete(typename RdTaskResult<T, S>::Cancelled{}); });
 	}
 
 	virtual ~WiredRdTaskImpl()
 	{
 		lifetime->remove_action(termination_lifetime_id);
+		cancellation_lifetime->remove_action(cancellation_lifetime_id);
+	}
+
+	/**
+	 * \brief Completes the task as cancelled once [request_lifetime] is terminated, unless it has a result by then, and
+	 * sends the cancellation to the endpoint: an empty message to the task's id, the way the counterpart expects it.
+	 */
+	void cancel_with(Lifetime request_lifetime) const
+	{
+		auto cancel = [this] {
+			if (result->has_value())
+			{
+				return;
+			}
+			RD_LOG_TRACE(logSend, "call {} {} send cancellation", to_string(cutpoint->location), to_string(rdid));
+			cutpoint->get_wire()->send(rdid, [](Buffer&) {});
+			this->complete(typename RdTaskResult<T, S>::Cancelled{});
+		};
+		if (request_lifetime->is_terminated())
+		{
+			cancel();
+			return;
+		}
+		cancellation_lifetime = std::move(request_lifetime);
+		cancellation_lifetime_id = cancellation_lifetime->add_action(std::move(cancel));
 	}
 
 	void on_wire_received(Buffer buffer) const override
 	{
 		auto read_result = RdTaskResult<T, S>::read(cutpoint->get_serialization_context(), buffer);
-		spdlog::get("logReceived")->trace("call {} {} received response {} : {}", to_string(cutpoint->location), to_string(rdid), to_string(rdid),
+		RD_LOG_TRACE(logReceived, "call {} {} received response {} : {}", to_string(cutpoint->location), to_string(rdid), to_string(rdid),
 			to_string(read_result));
-		scheduler->queue([&, result = std::move(read_result)]() mutable {
+		scheduler->queue_in_lane(cutpoint->get_lane(), [&, result = std::move(read_result)]() mutable {
 			if (this->result->has_value())
 			{
-				spdlog::get("logReceived")->trace("call {} {} response was dropped, task result is: {}", to_string(location), to_string(rdid),
+				RD_LOG_TRACE(logReceived, "call {} {} response was dropped, task result is: {}", to_string(location), to_string(rdid),
 					to_string(result.unwrap()));
 			}
 			else
 			{
-				this->result->set_if_empty(std::move(result));
+				this->complete(std::move(result));
 			}
 		});
 	}
@@ -3,20 +3,17 @@
 #include "util/guards.h"
 #include <util/thread_util.h>
 
-#include "spdlog/sinks/stdout_color_sinks.h"
+#include "util/core_log.h"
 
 namespace rd
 {
-size_t ByteBufferAsyncProcessor::INITIAL_CAPACITY = 1024 * 1024;
-
 std::shared_ptr<spdlog::logger> ByteBufferAsyncProcessor::logger =
-	spdlog::stderr_color_mt<spdlog::synchronous_factory>("byteBufferLog", spdlog::color_mode::automatic);
+	util::create_logger("byteBufferLog");
 
 ByteBufferAsyncProcessor::ByteBufferAsyncProcessor(
 	std::string id, std::function<bool(Buffer::ByteArray const&, sequence_number_t)> processor)
 	: id(std::move(id)), processor(std::move(processor))
 {
-	data.reserve(INITIAL_CAPACITY);
 }
 
 void ByteBufferAsyncProcessor::cleanup0()
@@ -37,14 +34,14 @@ bool ByteBufferAsyncProcessor::terminate0(time_t timeout, StateKind state_to_set
 		std::lock_guard<decltype(lock)> guard(lock);
 		if (state == StateKind::Initialized)
 		{
-			logger->debug("Can't {} \'{}\', because it hasn't been started yet", std::string(action), id);
+			RD_LOG_DEBUG(logger, "Can't {} \'{}\', because it hasn't been started yet", std::string(action), id);
 			cleanup0();
 			return true;
 		}
 
 		if (state >= state_to_set)
 		{
-			logger->debug("Trying to {} async processor \'{}' but it's in state {}", std::string(action), id, to_string(state));
+			RD_LOG_DEBUG(logger, "Trying to {} async processor \'{}' but it's in state {}", std::string(action), id, to_string(state));
 			return true;
 		}
 
@@ -58,7 +55,7 @@ bool ByteBufferAsyncProcessor::terminate0(time_t timeout, StateKind state_to_set
 
 	if (status == std::future_status::timeout)
 	{
-		logger->error("Couldn't wait async thread during time: {}", to_string(timeout));
+		RD_LOG_ERROR(logger, "Couldn't wait async thread during time: {}", to_string(timeout));
 		success = false;
 	}
 
@@ -67,7 +64,7 @@ bool ByteBufferAsyncProcessor::terminate0(time_t timeout, StateKind state_to_set
 	return success;
 }
 
-void ByteBufferAsyncProcessor::add_data(std::vector<Buffer::ByteArray>&& new_data)
+void ByteBufferAsyncProcessor::add_data(std::deque<Buffer::ByteArray>&& new_data)
 {
 	std::lock_guard<decltype(queue_lock)> guard(queue_lock);
 	std::move(new_data.begin(), new_data.end(), std::back_inserter(queue));
@@ -81,18 +78,14 @@ bool ByteBufferAsyncProcessor::reprocess()
 	{
 		std::lock_guard<decltype(queue_lock)> guard(queue_lock);
 
-		logger->debug("{}: reprocessing started", id);
+		RD_LOG_DEBUG(logger, "{}: reprocessing started", id);
 
 		std::unique_lock<decltype(processing_lock)> ul(processing_lock);
 		processing_cv.wait(ul, [this]() -> bool { return !in_processing; });
 
-		logger->debug("{}: reprocessing waited for main processing", id);
+		RD_LOG_DEBUG(logger, "{}: reprocessing waited for main processing", id);
 
-		while (current_seqn <= acknowledged_seqn)
-		{
-			pending_queue.pop_front();
-			++current_seqn;
-		}
+		prune_acknowledged();
 		for (int i = 0; i < pending_queue.size(); ++i)
 		{
 			auto const& item = pending_queue[i];
@@ -112,20 +105,149 @@ void ByteBufferAsyncProcessor::process()
 		std::unique_lock<decltype(processing_lock)> ul(processing_lock);
 		util::bool_guard bool_guard(in_processing);
 
-		logger->debug("{}: processing started", id);
+		RD_LOG_TRACE(logger, "{}: processing started", id);
 
+		prune_acknowledged();
 		while (!queue.empty() && processor(queue.front(), max_sent_seqn + 1))
 		{
 			++max_sent_seqn;
+			pending_bytes += queue.front().size();
+			++pending_messages;
 			pending_queue.push_back(std::move(queue.front()));
 			queue.pop_front();
 		}
 	}
 	processing_cv.notify_all();
 
+	{
+		// don't let producers blocked in [put] miss the wakeup
+		std::lock_guard<decltype(lock)> guard(lock);
+	}
 	cv.notify_all();
 }
 
+bool ByteBufferAsyncProcessor::fits(size_t size, size_t more_messages) const
+{
+	const size_t messages = window_messages;
+	if (messages == 0)
+	{
+		return true;	// a single oversized message must pass anyway
+	}
+	return (window.max_bytes == 0 || window_bytes + size <= window.max_bytes) &&
+		   (window.max_messages == 0 || messages + more_messages <= window.max_messages);
+}
+
+void ByteBufferAsyncProcessor::occupy(size_t size, size_t more_messages)
+{
+	const size_t bytes = window_bytes += size;
+	const size_t messages = window_messages += more_messages;
+
+	size_t peak = peak_window_bytes;
+	while (bytes > peak && !peak_window_bytes.compare_exchange_weak(peak, bytes))
+	{
+	}
+	peak = peak_window_messages;
+	while (messages > peak && !peak_window_messages.compare_exchange_weak(peak, messages))
+	{
+	}
+}
+
+void ByteBufferAsyncProcessor::release(size_t size)
+{
+	window_bytes -= size;
+	--window_messages;
+}
+
+void ByteBufferAsyncProcessor::pop_pending()
+{
+	const size_t size = pending_queue.front().size();
+	release(size);
+	pending_bytes -= size;
+	--pending_messages;
+	pending_queue.pop_front();
+	++current_seqn;
+}
+
+void ByteBufferAsyncProcessor::prune_acknowledged()
+{
+	while (current_seqn <= acknowledged_seqn && !pending_queue.empty())
+	{
+		pop_pending();
+	}
+}
+
+bool ByteBufferAsyncProcessor::drop_oldest()
+{
+	{
+		std::lock_guard<decltype(queue_lock)> guard(queue_lock);
+		prune_acknowledged();
+		if (!pending_queue.empty())
+		{
+			// the counterpart won't get it after reconnect either
+			pop_pending();
+			++dropped_messages;
+			return true;
+		}
+		if (!queue.empty())
+		{
+			release(queue.front().size());
+			queue.pop_front();
+			++dropped_messages;
+			return true;
+		}
+	}
+	if (!data.empty())
+	{
+		release(data.front().size());
+		data.pop_front();
+		++dropped_messages;
+		return true;
+	}
+	return false;
+}
+
+bool ByteBufferAsyncProcessor::make_room(std::unique_lock<decltype(lock)>& guard, Buffer::ByteArray& new_data)
+{
+	const size_t size = new_data.size();
+	switch (policy)
+	{
+		case BackpressurePolicy::Block:
+			while (!fits(size, 1))
+			{
+				if (state >= StateKind::Stopping)
+				{
+					return false;
+				}
+				cv.wait(guard);
+			}
+			break;
+		case BackpressurePolicy::Coalesce:
+			if (!data.empty() && !fits(size, 1))
+			{
+				while (!fits(size, 0) && drop_oldest())
+				{
+				}
+				if (!data.empty())
+				{
+					auto& tail = data.back();
+					tail.insert(tail.end(), new_data.begin(), new_data.end());
+					occupy(size, 0);
+					++coalesced_messages;
+					return false;
+				}
+			}
+			// fallthrough: nothing left to coalesce with
+		case BackpressurePolicy::DropOldest:
+			while (!fits(size, 1) && drop_oldest())
+			{
+			}
+			break;
+		case BackpressurePolicy::Admit:
+			break;
+	}
+	return true;
+}
+
 void ByteBufferAsyncProcessor::ThreadProc()
 {
 	rd::util::set_thread_name(id.empty() ? "ByteBufferAsyncProcessor Thread" : id.c_str());
@@ -149,7 +271,7 @@ void ByteBufferAsyncProcessor::ThreadProc()
 				}
 				cv.wait(lock);
 
-				logger->debug("{}'s ThreadProc waited for notify", id);
+				RD_LOG_TRACE(logger, "{}'s ThreadProc waited for notify", id);
 
 				if (state >= StateKind::Terminating)
 				{
@@ -166,7 +288,7 @@ void ByteBufferAsyncProcessor::ThreadProc()
 		}
 		catch (std::exception const& e)
 		{
-			logger->error("Exception while processing byte queue | {}", e.what());
+			RD_LOG_ERROR(logger, "Exception while processing byte queue | {}", e.what());
 		}
 	}
 }
@@ -178,7 +300,7 @@ void ByteBufferAsyncProcessor::start()
 
 		if (state != StateKind::Initialized)
 		{
-			logger->debug("Trying to START async processor {} but it's in state {}", id, to_string(state));
+			RD_LOG_DEBUG(logger, "Trying to START async processor {} but it's in state {}", id, to_string(state));
 			return;
 		}
 
@@ -201,15 +323,70 @@ bool ByteBufferAsyncProcessor::terminate(time_t timeout)
 void ByteBufferAsyncProcessor::put(Buffer::ByteArray new_data)
 {
 	{
-		std::lock_guard<decltype(lock)> guard(lock);
+		std::unique_lock<decltype(lock)> guard(lock);
 
 		if (state >= StateKind::Stopping)
 		{
 			return;
 		}
+		if (!make_room(guard, new_data))
+		{
+			return;
+		}
+		occupy(new_data.size(), 1);
+		data.emplace_back(std::move(new_data));
+	}
+	cv.notify_all();
+}
+
+bool ByteBufferAsyncProcessor::try_put(Buffer::ByteArray new_data)
+{
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+
+		if (state >= StateKind::Stopping)
+		{
+			return true;
+		}
+		if (!fits(new_data.size(), 1))
+		{
+			return false;
+		}
+		occupy(new_data.size(), 1);
 		data.emplace_back(std::move(new_data));
 	}
 	cv.notify_all();
+	return true;
+}
+
+bool ByteBufferAsyncProcessor::is_congested() const
+{
+	std::lock_guard<decltype(lock)> guard(lock);
+	return !fits(0, 1);
+}
+
+void ByteBufferAsyncProcessor::set_window(Window new_window, BackpressurePolicy new_policy)
+{
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		window = new_window;
+		policy = new_policy;
+	}
+	cv.notify_all();
+}
+
+ByteBufferAsyncProcessor::WindowOccupancy ByteBufferAsyncProcessor::get_window_occupancy() const
+{
+	WindowOccupancy res;
+	res.bytes = window_bytes;
+	res.messages = window_messages;
+	res.peak_bytes = peak_window_bytes;
+	res.peak_messages = peak_window_messages;
+	res.dropped_messages = dropped_messages;
+	res.coalesced_messages = coalesced_messages;
+	res.pending_bytes = pending_bytes;
+	res.pending_messages = pending_messages;
+	return res;
 }
 
 void ByteBufferAsyncProcessor::pause(const std::string& reason)
@@ -218,15 +395,15 @@ void ByteBufferAsyncProcessor::pause(const std::string& reason)
 
 	++interrupt_balance;
 
-	logger->debug("{} paused with reason={},state={}", id, reason, to_string(state));
+	RD_LOG_DEBUG(logger, "{} paused with reason={},state={}", id, reason, to_string(state));
 
 	auto current_thread_id = std::this_thread::get_id();
 	if (current_thread_id != async_thread_id)
 	{
-		logger->debug(id + "{} paused from another thread : {}", id, to_string(current_thread_id));
+		RD_LOG_DEBUG(logger, "{} paused from another thread : {}", id, to_string(current_thread_id));
 		std::unique_lock<decltype(processing_lock)> ul(processing_lock);
 		processing_cv.wait(ul, [this]() -> bool { return !in_processing; });
-		logger->debug("{}: pausing waited for main processing", id);
+		RD_LOG_DEBUG(logger, "{}: pausing waited for main processing", id);
 	}
 }
 
@@ -239,7 +416,7 @@ void ByteBufferAsyncProcessor::resume()
 
 		--interrupt_balance;
 
-		logger->debug("{} resumed", id);
+		RD_LOG_DEBUG(logger, "{} resumed", id);
 	}
 
 	cv.notify_all();
@@ -251,12 +428,22 @@ void ByteBufferAsyncProcessor::acknowledge(sequence_number_t seqn)
 
 	if (seqn > acknowledged_seqn)
 	{
-		logger->trace("{}: new acknowledged seqn: {}", this->id, seqn);
+		RD_LOG_TRACE(logger, "{}: new acknowledged seqn: {}", this->id, seqn);
 		acknowledged_seqn = seqn;
 	}
 	else
 	{
-		logger->error("Acknowledge {} called, while next seqn MUST BE greater than {}", seqn, acknowledged_seqn);
+		RD_LOG_ERROR(logger, "Acknowledge {} called, while next seqn MUST BE greater than {}", seqn, acknowledged_seqn.load());
+		return;
+	}
+
+	// if processing is in progress it prunes the pending queue itself
+	std::unique_lock<decltype(queue_lock)> queue_guard(queue_lock, std::try_to_lock);
+	if (queue_guard.owns_lock())
+	{
+		prune_acknowledged();
+		queue_guard.unlock();
+		cv.notify_all();
 	}
 }
 
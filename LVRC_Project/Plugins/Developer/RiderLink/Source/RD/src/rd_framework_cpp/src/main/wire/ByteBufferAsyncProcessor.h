@@ -13,8 +13,10 @@
 #include <string>
 #include <mutex>
 #include <condition_variable>
+#include <deque>
 #include <future>
 #include <list>
+#include <atomic>
 
 #include <rd_framework_export.h>
 
@@ -34,12 +36,60 @@ public:
 		Terminated
 	};
 
+	/**
+	 * \brief What [put] does when the window is full.
+	 */
+	enum class BackpressurePolicy
+	{
+		/**
+		 * \brief Waits until acknowledges free enough room in the window.
+		 */
+		Block,
+		/**
+		 * \brief Evicts the oldest messages (unacknowledged first, then unsent) until the new one fits.
+		 */
+		DropOldest,
+		/**
+		 * \brief Appends the new message to the last unsent one instead of taking a new slot,
+		 * evicts the oldest messages if the byte limit is exceeded.
+		 */
+		Coalesce,
+		/**
+		 * \brief Takes the new message anyway, nothing is dropped: the window only makes [try_put] refuse messages which
+		 * may be lost, e.g. logs, while the wire carries a model whose every update must arrive.
+		 */
+		Admit
+	};
+
+	/**
+	 * \brief Bounds bytes and messages held by the processor: unsent (queued while paused) plus sent but not acknowledged.
+	 * Zero means unlimited.
+	 */
+	struct Window
+	{
+		size_t max_bytes = 0;
+		size_t max_messages = 0;
+	};
+
+	struct WindowOccupancy
+	{
+		size_t bytes = 0;
+		size_t messages = 0;
+		size_t peak_bytes = 0;
+		size_t peak_messages = 0;
+		size_t dropped_messages = 0;
+		size_t coalesced_messages = 0;
+		/**
+		 * \brief Part of [bytes] and [messages] which is sent and waits for acknowledgement.
+		 */
+		size_t pending_bytes = 0;
+		size_t pending_messages = 0;
+	};
+
 private:
 	using time_t = std::chrono::milliseconds;
 
-	static size_t INITIAL_CAPACITY;
-
-	std::recursive_mutex lock;
+	mutable std::recursive_mutex lock;
 	std::condition_variable_any cv;
 
 	std::string id;
@@ -52,14 +102,27 @@ private:
 	std::thread::id async_thread_id;
 	std::future<void> async_future;
 
-	std::vector<Buffer::ByteArray> data;
+	// the oldest messages are dropped from the front on overflow, see [drop_oldest]
+	std::deque<Buffer::ByteArray> data;
 	std::mutex queue_lock;
 	std::deque<Buffer::ByteArray> queue{};
 	std::deque<Buffer::ByteArray> pending_queue{};
 
 	sequence_number_t max_sent_seqn = 0;
 	sequence_number_t current_seqn = 1;
-	sequence_number_t acknowledged_seqn = 0;
+	std::atomic<sequence_number_t> acknowledged_seqn{0};
+
+	Window window{};
+	BackpressurePolicy policy = BackpressurePolicy::Block;
+
+	std::atomic<size_t> window_bytes{0};
+	std::atomic<size_t> window_messages{0};
+	std::atomic<size_t> peak_window_bytes{0};
+	std::atomic<size_t> peak_window_messages{0};
+	std::atomic<size_t> dropped_messages{0};
+	std::atomic<size_t> coalesced_messages{0};
+	std::atomic<size_t> pending_bytes{0};
+	std::atomic<size_t> pending_messages{0};
 
 	int32_t interrupt_balance = 0;
 	bool in_processing = false;
@@ -77,7 +140,7 @@ private:
 
 	bool terminate0(time_t timeout, StateKind state_to_set, string_view action);
 
-	void add_data(std::vector<Buffer::ByteArray>&& new_data);
+	void add_data(std::deque<Buffer::ByteArray>&& new_data);
 
 	bool reprocess();
 
@@ -85,6 +148,20 @@ private:
 
 	void ThreadProc();
 
+	bool fits(size_t size, size_t more_messages) const;
+
+	void occupy(size_t size, size_t more_messages);
+
+	void release(size_t size);
+
+	void pop_pending();
+
+	void prune_acknowledged();
+
+	bool drop_oldest();
+
+	bool make_room(std::unique_lock<decltype(lock)>& guard, Buffer::ByteArray& new_data);
+
 public:
 	void start();
 
@@ -94,6 +171,18 @@ public:
 
 	void put(Buffer::ByteArray new_data);
 
+	/**
+	 * \brief Non-blocking [put] which ignores the backpressure policy.
+	 * \return false without queueing [new_data] if it doesn't fit into the window.
+	 */
+	bool try_put(Buffer::ByteArray new_data);
+
+	bool is_congested() const;
+
+	void set_window(Window new_window, BackpressurePolicy new_policy);
+
+	WindowOccupancy get_window_occupancy() const;
+
 	void pause(const std::string& reason);
 
 	void resume();
@@ -0,0 +1,170 @@
+#include "wire/ChunkedMessage.h"
+
+#include "base/IWire.h"
+#include "util/core_log.h"
+#include "util/core_util.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace rd
+{
+static std::shared_ptr<spdlog::logger> logger = util::create_logger("chunkedMessageLog");
+
+constexpr int32_t ChunkedMessageWriter::DEFAULT_CHUNK_SIZE;
+
+ChunkedMessageWriter::ChunkedMessageWriter(IWire const* wire, RdId id, int32_t stream, int64_t total, int32_t chunk_size)
+	: wire(wire), id(std::move(id)), stream(stream), total(total), chunk_size(chunk_size)
+{
+	RD_ASSERT_THROW_MSG(total >= 0, fmt::format("total size of a chunked message must not be negative: {}", total))
+	RD_ASSERT_THROW_MSG(chunk_size > 0, fmt::format("chunk size must be positive: {}", chunk_size))
+	pending.reserve(static_cast<size_t>((std::min)(static_cast<int64_t>(chunk_size), total)));
+}
+
+ChunkedMessageWriter::ChunkedMessageWriter(ChunkedMessageWriter&& other) noexcept
+	: wire(other.wire)
+	, id(other.id)
+	, stream(other.stream)
+	, total(other.total)
+	, chunk_size(other.chunk_size)
+	, sent(other.sent)
+	, finished(other.finished)
+	, pending(std::move(other.pending))
+{
+	other.finished = true;
+}
+
+ChunkedMessageWriter::~ChunkedMessageWriter()
+{
+	if (!finished)
+	{
+		RD_LOG_WARN(logger, "stream {} to {} abandoned after {} of {} bytes", stream, to_string(id),
+			sent + static_cast<int64_t>(pending.size()), total);
+	}
+}
+
+void ChunkedMessageWriter::write(Buffer::word_t const* data, size_t size)
+{
+	RD_ASSERT_THROW_MSG(!finished, fmt::format("stream {} to {} is already finished", stream, to_string(id)))
+	RD_ASSERT_THROW_MSG(sent + static_cast<int64_t>(pending.size() + size) <= total,
+		fmt::format("stream {} to {} exceeds its total size {}", stream, to_string(id), total))
+	while (size > 0)
+	{
+		const size_t n = (std::min)(size, static_cast<size_t>(chunk_size) - pending.size());
+		pending.insert(pending.end(), data, data + n);
+		data += n;
+		size -= n;
+		if (pending.size() == static_cast<size_t>(chunk_size))
+		{
+			send_pending();
+		}
+	}
+}
+
+void ChunkedMessageWriter::finish()
+{
+	if (finished)
+	{
+		return;
+	}
+	RD_ASSERT_THROW_MSG(sent + static_cast<int64_t>(pending.size()) == total,
+		fmt::format("stream {} to {} is finished after {} of {} bytes", stream, to_string(id),
+			sent + static_cast<int64_t>(pending.size()), total))
+	// an empty payload still needs a chunk for the receiver to see it
+	if (!pending.empty() || total == 0)
+	{
+		send_pending();
+	}
+	finished = true;
+}
+
+int64_t ChunkedMessageWriter::get_written() const
+{
+	return sent + static_cast<int64_t>(pending.size());
+}
+
+void ChunkedMessageWriter::send_pending()
+{
+	const int64_t offset = sent;
+	wire->send(id, [this, offset](Buffer& buffer) {
+		buffer.write_integral(stream);
+		buffer.write_integral(total);
+		buffer.write_integral(offset);
+		buffer.write_integral(static_cast<int32_t>(pending.size()));
+		buffer.write_byte_array_raw(pending);
+	});
+	RD_LOG_TRACE(logger, "stream {} to {}: sent {} bytes at {} of {}", stream, to_string(id), pending.size(), offset, total);
+	sent += static_cast<int64_t>(pending.size());
+	pending.clear();
+}
+
+ChunkedMessageReader::ChunkedMessageReader(chunk_handler_t on_chunk, abort_handler_t on_abort)
+	: on_chunk(std::move(on_chunk)), on_abort(std::move(on_abort))
+{
+}
+
+void ChunkedMessageReader::on_wire_received(Buffer& buffer)
+{
+	WireChunk chunk;
+	chunk.stream = buffer.read_integral<int32_t>();
+	chunk.total = buffer.read_integral<int64_t>();
+	chunk.offset = buffer.read_integral<int64_t>();
+	chunk.size = buffer.read_integral<int32_t>();
+	RD_ASSERT_THROW_MSG(chunk.size >= 0 && chunk.offset >= 0 && chunk.offset + chunk.size <= chunk.total,
+		fmt::format("invalid chunk of stream {}: {} bytes at {} of {}", chunk.stream, chunk.size, chunk.offset, chunk.total))
+	buffer.check_available(static_cast<size_t>(chunk.size));
+	chunk.data = buffer.current_pointer();
+	buffer.set_position(buffer.get_position() + static_cast<size_t>(chunk.size));
+
+	if (chunk.is_first())
+	{
+		if (in_stream)
+		{
+			abort();	// the previous one won't be completed
+		}
+		in_stream = true;
+		skipping = false;
+		stream = chunk.stream;
+		total = chunk.total;
+		expected_offset = 0;
+	}
+	else if (!in_stream)
+	{
+		if (!skipping || skipped_stream != chunk.stream)
+		{
+			// the beginning was lost, e.g. evicted by the send window
+			skipping = true;
+			skipped_stream = chunk.stream;
+			if (on_abort)
+			{
+				on_abort(chunk.stream, 0, chunk.total);
+			}
+		}
+		return;
+	}
+	else if (chunk.stream != stream || chunk.offset != expected_offset || chunk.total != total)
+	{
+		abort();
+		return;
+	}
+
+	expected_offset += chunk.size;
+	if (chunk.is_last())
+	{
+		in_stream = false;
+	}
+	on_chunk(chunk);
+}
+
+void ChunkedMessageReader::abort()
+{
+	RD_LOG_WARN(logger, "stream {} aborted after {} of {} bytes", stream, expected_offset, total);
+	in_stream = false;
+	skipping = true;
+	skipped_stream = stream;
+	if (on_abort)
+	{
+		on_abort(stream, expected_offset, total);
+	}
+}
+}	 // namespace rd
@@ -0,0 +1,141 @@
+#ifndef RD_CPP_CHUNKEDMESSAGE_H
+#define RD_CPP_CHUNKEDMESSAGE_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include "protocol/Buffer.h"
+#include "protocol/RdId.h"
+
+#include <cstdint>
+#include <functional>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+// region predeclared
+
+class IWire;
+// endregion
+
+/**
+ * \brief Piece of a payload sent with [ChunkedMessageWriter]. [data] points into the received message and is valid
+ * only while the chunk is being handled.
+ */
+struct RD_FRAMEWORK_API WireChunk
+{
+	int32_t stream = 0;
+	int64_t offset = 0;
+	int64_t total = 0;
+	Buffer::word_t const* data = nullptr;
+	int32_t size = 0;
+
+	bool is_first() const
+	{
+		return offset == 0;
+	}
+
+	bool is_last() const
+	{
+		return offset + size == total;
+	}
+};
+
+/**
+ * \brief Sends a payload of known size as a sequence of messages of at most [chunk_size] bytes each, so neither side
+ * holds the whole payload and the receiver can process its beginning while the rest is being sent.
+ *
+ * Every chunk is a regular message to [id]: stream number, total size, offset and size, followed by the bytes.
+ * Chunks travel in order, a chunk evicted by the send window of the wire is detected by [ChunkedMessageReader].
+ * Chunks queue up in the wire like any other messages: with a send window and [BackpressurePolicy::Block] [write]
+ * waits for the counterpart instead.
+ */
+class RD_FRAMEWORK_API ChunkedMessageWriter
+{
+public:
+	static constexpr int32_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+	// region ctor/dtor
+
+	ChunkedMessageWriter(IWire const* wire, RdId id, int32_t stream, int64_t total, int32_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+	ChunkedMessageWriter(ChunkedMessageWriter const&) = delete;
+
+	ChunkedMessageWriter& operator=(ChunkedMessageWriter const&) = delete;
+
+	ChunkedMessageWriter(ChunkedMessageWriter&& other) noexcept;
+
+	ChunkedMessageWriter& operator=(ChunkedMessageWriter&&) = delete;
+
+	~ChunkedMessageWriter();
+	// endregion
+
+	/**
+	 * \brief Appends [size] bytes of the payload, every completed chunk is sent right away.
+	 */
+	void write(Buffer::word_t const* data, size_t size);
+
+	/**
+	 * \brief Sends the last chunk. Throws if less or more than the announced total has been written.
+	 */
+	void finish();
+
+	int64_t get_written() const;
+
+private:
+	IWire const* wire;
+	RdId id;
+	int32_t stream;
+	int64_t total;
+	int32_t chunk_size;
+	int64_t sent = 0;
+	bool finished = false;
+	Buffer::ByteArray pending;
+
+	void send_pending();
+};
+
+/**
+ * \brief Receiving side of [ChunkedMessageWriter]: parses chunk messages and checks that they continue the current
+ * stream. A chunk out of sequence aborts the stream, the rest of it is skipped until the next stream starts.
+ */
+class RD_FRAMEWORK_API ChunkedMessageReader
+{
+public:
+	using chunk_handler_t = std::function<void(WireChunk const&)>;
+	/**
+	 * \brief Called with stream number, bytes received and total size of the stream which won't be completed.
+	 */
+	using abort_handler_t = std::function<void(int32_t, int64_t, int64_t)>;
+
+	// region ctor/dtor
+
+	ChunkedMessageReader(chunk_handler_t on_chunk, abort_handler_t on_abort);
+	// endregion
+
+	void on_wire_received(Buffer& buffer);
+
+private:
+	chunk_handler_t on_chunk;
+	abort_handler_t on_abort;
+
+	bool in_stream = false;
+	int32_t stream = 0;
+	int64_t expected_offset = 0;
+	int64_t total = 0;
+
+	// stream whose beginning is lost, reported once
+	bool skipping = false;
+	int32_t skipped_stream = 0;
+
+	void abort();
+};
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_CHUNKEDMESSAGE_H
@@ -0,0 +1,185 @@
+#include "wire/LoopbackWire.h"
+
+#include <util/thread_util.h>
+
+#include <ActiveSocket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace rd
+{
+namespace test
+{
+namespace util
+{
+namespace
+{
+constexpr std::chrono::milliseconds STOP_TIMEOUT{500};
+
+/**
+ * \brief Unbounded byte stream in one direction. Flow control is left to the send window of the wire.
+ */
+class Pipe
+{
+	std::mutex lock;
+	std::condition_variable cv;
+	std::vector<uint8_t> data;
+	size_t read_position = 0;
+	bool closed = false;
+
+public:
+	bool write(uint8_t const* buf, size_t size)
+	{
+		{
+			std::lock_guard<decltype(lock)> guard(lock);
+			if (closed)
+			{
+				return false;
+			}
+			data.insert(data.end(), buf, buf + size);
+		}
+		cv.notify_all();
+		return true;
+	}
+
+	/**
+	 * \return number of bytes read, 0 once the pipe is closed and drained.
+	 */
+	size_t read(uint8_t* buf, size_t max_size)
+	{
+		std::unique_lock<decltype(lock)> guard(lock);
+		cv.wait(guard, [this] { return read_position < data.size() || closed; });
+
+		const size_t size = (std::min)(max_size, data.size() - read_position);
+		std::memcpy(buf, data.data() + read_position, size);
+		read_position += size;
+		if (read_position == data.size())
+		{
+			data.clear();
+			read_position = 0;
+		}
+		return size;
+	}
+
+	void close()
+	{
+		{
+			std::lock_guard<decltype(lock)> guard(lock);
+			closed = true;
+		}
+		cv.notify_all();
+	}
+};
+
+class LoopbackSocket : public CActiveSocket
+{
+	std::shared_ptr<Pipe> in;
+	std::shared_ptr<Pipe> out;
+	std::atomic<bool> valid{true};
+
+public:
+	// region ctor/dtor
+
+	LoopbackSocket(std::shared_ptr<Pipe> in, std::shared_ptr<Pipe> out) : in(std::move(in)), out(std::move(out))
+	{
+	}
+	// endregion
+
+	using CActiveSocket::Send;
+
+	int32_t Send(const uint8_t* buf, size_t size) override
+	{
+		if (!valid || !out->write(buf, size))
+		{
+			SetSocketError(SocketConnectionReset);
+			return -1;
+		}
+		SetSocketError(SocketSuccess);
+		return static_cast<int32_t>(size);
+	}
+
+	int32_t Receive(int32_t max_bytes, uint8_t* buf) override
+	{
+		if (buf == nullptr)
+		{
+			SetSocketError(SocketInvalidPointer);
+			return -1;
+		}
+		SetSocketError(SocketSuccess);
+		return static_cast<int32_t>(in->read(buf, static_cast<size_t>(max_bytes)));
+	}
+
+	bool Shutdown(CShutdownMode) override
+	{
+		in->close();
+		out->close();
+		return true;
+	}
+
+	bool Close() override
+	{
+		Shutdown(Both);
+		return valid.exchange(false);
+	}
+
+	bool IsSocketValid() override
+	{
+		return valid;
+	}
+};
+}	 // namespace
+
+LoopbackWire::LoopbackWire(Lifetime parentLifetime, IScheduler* scheduler, std::shared_ptr<CActiveSocket> end, std::string const& id)
+	: Base(id, parentLifetime, scheduler), loopbackLifetimeDefinition(parentLifetime)
+{
+	socket = std::move(end);
+	Lifetime lifetime = loopbackLifetimeDefinition.lifetime;
+
+	thread = std::thread([this] {
+		rd::util::set_thread_name(this->id.empty() ? "LoopbackWire Thread" : this->id.c_str());
+
+		set_socket_provider(socket);
+		RD_LOG_DEBUG(logger, "{}: thread expired", this->id);
+	});
+
+	lifetime->add_action([this] {
+		RD_LOG_INFO(logger, "{}: start terminating lifetime", this->id);
+
+		const bool send_buffer_stopped = async_send_buffer.stop(STOP_TIMEOUT);
+		RD_LOG_DEBUG(logger, "{}: send buffer stopped, success: {}", this->id, send_buffer_stopped);
+
+		{
+			std::lock_guard<decltype(lock)> guard(lock);
+			RD_LOG_DEBUG(logger, "{}: closing socket", this->id);
+			socket->Close();
+		}
+
+		thread.join();
+		RD_LOG_INFO(logger, "{}: termination finished", this->id);
+	});
+}
+
+LoopbackWire::~LoopbackWire()
+{
+	if (!loopbackLifetimeDefinition.is_terminated())
+	{
+		loopbackLifetimeDefinition.terminate();
+	}
+}
+
+LoopbackWire::pair_t LoopbackWire::create_pair(
+	Lifetime lifetime, IScheduler* first_scheduler, IScheduler* second_scheduler, std::string const& id)
+{
+	auto forward = std::make_shared<Pipe>();
+	auto backward = std::make_shared<Pipe>();
+	return {std::make_shared<LoopbackWire>(lifetime, first_scheduler, std::make_shared<LoopbackSocket>(backward, forward), id + "-1"),
+		std::make_shared<LoopbackWire>(lifetime, second_scheduler, std::make_shared<LoopbackSocket>(forward, backward), id + "-2")};
+}
+}	 // namespace util
+}	 // namespace test
+}	 // namespace rd
@@ -0,0 +1,53 @@
+#ifndef RD_CPP_LOOPBACKWIRE_H
+#define RD_CPP_LOOPBACKWIRE_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include "wire/SocketWire.h"
+
+#include <utility>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+namespace test
+{
+namespace util
+{
+/**
+ * \brief One end of an in-process wire pair. Runs the whole [SocketWire] stack (framing, sequence numbers,
+ * acknowledgements, heartbeats, send buffer) over an in-memory byte pipe instead of a socket.
+ */
+class RD_FRAMEWORK_API LoopbackWire : public SocketWire::Base
+{
+public:
+	using pair_t = std::pair<std::shared_ptr<LoopbackWire>, std::shared_ptr<LoopbackWire>>;
+
+	// region ctor/dtor
+
+	LoopbackWire(Lifetime lifetime, IScheduler* scheduler, std::shared_ptr<CActiveSocket> end, std::string const& id);
+
+	virtual ~LoopbackWire() override;
+	// endregion
+
+	/**
+	 * \brief Creates two wires connected to each other. Closing either end disconnects both, as a socket would.
+	 */
+	static pair_t create_pair(Lifetime lifetime, IScheduler* first_scheduler, IScheduler* second_scheduler,
+		std::string const& id = "Loopback");
+
+private:
+	LifetimeDefinition loopbackLifetimeDefinition;
+};
+}	 // namespace util
+}	 // namespace test
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_LOOPBACKWIRE_H
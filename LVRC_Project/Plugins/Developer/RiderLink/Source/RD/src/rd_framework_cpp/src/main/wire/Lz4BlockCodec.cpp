@@ -0,0 +1,217 @@
+#include "Lz4BlockCodec.h"
+
+#include <array>
+#include <cstring>
+
+namespace rd
+{
+namespace
+{
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t LAST_LITERALS = 5;
+constexpr size_t MF_LIMIT = 12;	   // last match must start at least this far from the end
+constexpr size_t MAX_DISTANCE = 65535;
+constexpr int HASH_LOG = 12;
+constexpr uint8_t RUN_MASK = 15;
+
+uint32_t read32(uint8_t const* p)
+{
+	uint32_t res;
+	std::memcpy(&res, p, sizeof(res));
+	return res;
+}
+
+uint32_t hash(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HASH_LOG);
+}
+
+bool write_length(uint8_t*& op, uint8_t const* op_end, size_t len)
+{
+	while (len >= 255)
+	{
+		if (op >= op_end)
+		{
+			return false;
+		}
+		*op++ = 255;
+		len -= 255;
+	}
+	if (op >= op_end)
+	{
+		return false;
+	}
+	*op++ = static_cast<uint8_t>(len);
+	return true;
+}
+
+bool write_sequence(uint8_t*& op, uint8_t const* op_end, uint8_t const* literals, size_t literal_len, size_t offset, size_t match_len)
+{
+	if (op >= op_end)
+	{
+		return false;
+	}
+	uint8_t* token = op++;
+	*token = static_cast<uint8_t>((literal_len >= RUN_MASK ? RUN_MASK : literal_len) << 4);
+	if (literal_len >= RUN_MASK && !write_length(op, op_end, literal_len - RUN_MASK))
+	{
+		return false;
+	}
+	if (static_cast<size_t>(op_end - op) < literal_len)
+	{
+		return false;
+	}
+	std::memcpy(op, literals, literal_len);
+	op += literal_len;
+
+	if (match_len == 0)
+	{
+		return true;	// last sequence has literals only
+	}
+	if (op_end - op < 2)
+	{
+		return false;
+	}
+	*op++ = static_cast<uint8_t>(offset & 0xFF);
+	*op++ = static_cast<uint8_t>(offset >> 8);
+	match_len -= MIN_MATCH;
+	*token |= static_cast<uint8_t>(match_len >= RUN_MASK ? RUN_MASK : match_len);
+	return match_len < RUN_MASK || write_length(op, op_end, match_len - RUN_MASK);
+}
+
+bool read_length(uint8_t const*& ip, uint8_t const* ip_end, size_t& len)
+{
+	uint8_t s;
+	do
+	{
+		if (ip >= ip_end)
+		{
+			return false;
+		}
+		s = *ip++;
+		len += s;
+	} while (s == 255);
+	return true;
+}
+}	 // namespace
+
+size_t Lz4BlockCodec::compress_bound(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+size_t Lz4BlockCodec::decompress_bound(size_t size)
+{
+	// a length byte of 255 extends a match by 255 bytes, nothing expands more
+	return size * 255 + MF_LIMIT;
+}
+
+size_t Lz4BlockCodec::compress(uint8_t const* src, size_t src_size, uint8_t* dst, size_t dst_capacity)
+{
+	std::array<int64_t, 1 << HASH_LOG> table;
+	table.fill(-1);
+
+	uint8_t* op = dst;
+	uint8_t const* const op_end = dst + dst_capacity;
+	size_t anchor = 0;
+	size_t ip = 0;
+
+	if (src_size > MF_LIMIT)
+	{
+		const size_t match_limit = src_size - MF_LIMIT;
+		while (ip < match_limit)
+		{
+			const uint32_t sequence = read32(src + ip);
+			const uint32_t h = hash(sequence);
+			const int64_t ref = table[h];
+			table[h] = static_cast<int64_t>(ip);
+
+			if (ref < 0 || ip - ref > MAX_DISTANCE || read32(src + ref) != sequence)
+			{
+				++ip;
+				continue;
+			}
+
+			size_t match_len = MIN_MATCH;
+			const size_t max_match = src_size - LAST_LITERALS - ip;
+			while (match_len < max_match && src[ip + match_len] == src[ref + match_len])
+			{
+				++match_len;
+			}
+
+			if (!write_sequence(op, op_end, src + anchor, ip - anchor, ip - ref, match_len))
+			{
+				return 0;
+			}
+			ip += match_len;
+			anchor = ip;
+		}
+	}
+
+	if (!write_sequence(op, op_end, src + anchor, src_size - anchor, 0, 0))
+	{
+		return 0;
+	}
+	return static_cast<size_t>(op - dst);
+}
+
+bool Lz4BlockCodec::decompress(uint8_t const* src, size_t src_size, uint8_t* dst, size_t dst_size)
+{
+	uint8_t const* ip = src;
+	uint8_t const* const ip_end = src + src_size;
+	uint8_t* op = dst;
+	uint8_t* const op_end = dst + dst_size;
+
+	while (ip < ip_end)
+	{
+		const uint8_t token = *ip++;
+
+		size_t literal_len = token >> 4;
+		if (literal_len == RUN_MASK && !read_length(ip, ip_end, literal_len))
+		{
+			return false;
+		}
+		if (static_cast<size_t>(ip_end - ip) < literal_len || static_cast<size_t>(op_end - op) < literal_len)
+		{
+			return false;
+		}
+		std::memcpy(op, ip, literal_len);
+		ip += literal_len;
+		op += literal_len;
+
+		if (ip == ip_end)
+		{
+			break;	  // last sequence
+		}
+
+		if (ip_end - ip < 2)
+		{
+			return false;
+		}
+		const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > static_cast<size_t>(op - dst))
+		{
+			return false;
+		}
+
+		size_t match_len = token & RUN_MASK;
+		if (match_len == RUN_MASK && !read_length(ip, ip_end, match_len))
+		{
+			return false;
+		}
+		match_len += MIN_MATCH;
+		if (static_cast<size_t>(op_end - op) < match_len)
+		{
+			return false;
+		}
+		uint8_t const* match = op - offset;
+		for (size_t i = 0; i < match_len; ++i)	  // ranges may overlap
+		{
+			op[i] = match[i];
+		}
+		op += match_len;
+	}
+	return op == op_end;
+}
+}	 // namespace rd
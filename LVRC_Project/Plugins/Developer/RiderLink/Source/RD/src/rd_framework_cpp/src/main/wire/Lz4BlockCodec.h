@@ -0,0 +1,40 @@
+#ifndef RD_CPP_LZ4BLOCKCODEC_H
+#define RD_CPP_LZ4BLOCKCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Self-contained compressor producing the LZ4 block format (no frame, no checksums).
+ * Favours speed over ratio: single probe hash table, no lazy matching.
+ */
+class RD_FRAMEWORK_API Lz4BlockCodec
+{
+public:
+	/**
+	 * \brief Worst case size of compressed [size] bytes.
+	 */
+	static size_t compress_bound(size_t size);
+
+	/**
+	 * \brief Largest size a valid block of [size] bytes can decompress to.
+	 */
+	static size_t decompress_bound(size_t size);
+
+	/**
+	 * \return size of compressed data written to [dst] or 0 if it doesn't fit into [dst_capacity].
+	 */
+	static size_t compress(uint8_t const* src, size_t src_size, uint8_t* dst, size_t dst_capacity);
+
+	/**
+	 * \return true if [src] is a valid block which decompresses to exactly [dst_size] bytes.
+	 */
+	static bool decompress(uint8_t const* src, size_t src_size, uint8_t* dst, size_t dst_size);
+};
+}	 // namespace rd
+
+#endif	  // RD_CPP_LZ4BLOCKCODEC_H
@@ -1,5 +1,6 @@
 #include "wire/PumpScheduler.h"
 
+#include "scheduler/base/SchedulerMetrics.h"
 #include "util/core_util.h"
 
 namespace rd
@@ -22,6 +23,10 @@ void PumpScheduler::flush()
 
 void PumpScheduler::queue(std::function<void()> action)
 {
+	if (metrics)
+	{
+		action = metrics->wrap(std::move(action));
+	}
 	{
 		std::lock_guard<decltype(lock)> guard(lock);
 		messages.push(std::move(action));
@@ -0,0 +1,516 @@
+#include "wire/SharedMemoryWire.h"
+
+#include <ActiveSocket.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <ctime>
+#endif
+
+namespace rd
+{
+namespace
+{
+// Negotiation happens over the freshly connected TCP socket, before any RD package:
+// server sends [int32 name length][name bytes] (length 0 means "no shared memory"),
+// client answers [int32 1] if it mapped the segment or [int32 0] to stay on TCP.
+constexpr int32_t SEGMENT_UNAVAILABLE = 0;
+constexpr int32_t SEGMENT_MAPPED = 1;
+constexpr int32_t MAX_SEGMENT_NAME_LENGTH = 255;
+constexpr int32_t NEGOTIATION_TIMEOUT_SEC = 5;
+
+bool send_exactly(CActiveSocket& socket, uint8_t const* data, int32_t size)
+{
+	int32_t sent = 0;
+	while (sent < size)
+	{
+		const int32_t res = socket.Send(data + sent, static_cast<size_t>(size - sent));
+		if (res <= 0)
+		{
+			return false;
+		}
+		sent += res;
+	}
+	return true;
+}
+
+bool receive_exactly(CActiveSocket& socket, uint8_t* data, int32_t size)
+{
+	int32_t received = 0;
+	while (received < size)
+	{
+		const int32_t res = socket.Receive(size - received, data + received);
+		if (res <= 0)
+		{
+			return false;
+		}
+		received += res;
+	}
+	return true;
+}
+
+bool send_int32(CActiveSocket& socket, int32_t value)
+{
+	uint8_t bytes[sizeof(value)];
+	std::memcpy(bytes, &value, sizeof(value));
+	return send_exactly(socket, bytes, sizeof(bytes));
+}
+
+bool receive_int32(CActiveSocket& socket, int32_t& value)
+{
+	uint8_t bytes[sizeof(value)];
+	if (!receive_exactly(socket, bytes, sizeof(bytes)))
+	{
+		return false;
+	}
+	std::memcpy(&value, bytes, sizeof(value));
+	return true;
+}
+
+#if defined(__linux__)
+constexpr uint64_t SEGMENT_MAGIC = 0x31304D48532D4452;	  // "RD-SHM01"
+constexpr int WAIT_SLICE_MS = 100;
+
+using futex_word_t = std::atomic<uint32_t>;
+static_assert(sizeof(futex_word_t) == sizeof(uint32_t), "futex word must be plain 32 bit");
+
+/**
+ * \brief Control block of one direction. [head] is advanced by the consumer only, [tail] by the producer only;
+ * the sequence words are bumped after every advance and serve as futex words for the sleeping side.
+ */
+struct RingHeader
+{
+	alignas(64) std::atomic<uint64_t> head;
+	alignas(64) std::atomic<uint64_t> tail;
+	alignas(64) futex_word_t data_seq;
+	futex_word_t consumer_waiting;
+	alignas(64) futex_word_t space_seq;
+	futex_word_t producer_waiting;
+};
+
+struct SegmentHeader
+{
+	uint64_t magic;
+	uint64_t capacity;
+	std::atomic<uint32_t> closed;
+	RingHeader rings[2];
+};
+
+void futex_wait(futex_word_t& word, uint32_t expected)
+{
+	timespec timeout{};
+	timeout.tv_nsec = WAIT_SLICE_MS * 1000 * 1000;
+	// not FUTEX_PRIVATE_FLAG: the word lives in a mapping shared between processes
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+void futex_wake(futex_word_t& word)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+size_t round_up_to_power_of_two(size_t value)
+{
+	size_t res = 1;
+	while (res < value)
+	{
+		res <<= 1;
+	}
+	return res;
+}
+
+class Segment
+{
+	std::string name;
+	void* address = MAP_FAILED;
+	size_t size = 0;
+	bool owner = false;
+
+	Segment(std::string name, bool owner) : name(std::move(name)), owner(owner)
+	{
+	}
+
+	void map(int fd)
+	{
+		address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (address == MAP_FAILED)
+		{
+			throw std::runtime_error("mmap failed for " + name + ": " + std::strerror(errno));
+		}
+	}
+
+public:
+	// region ctor/dtor
+
+	Segment(Segment const&) = delete;
+
+	~Segment()
+	{
+		if (address != MAP_FAILED)
+		{
+			munmap(address, size);
+		}
+		unlink();
+	}
+	// endregion
+
+	static std::shared_ptr<Segment> create(std::string name, size_t ring_capacity)
+	{
+		std::shared_ptr<Segment> res(new Segment(std::move(name), true));
+		const size_t capacity = round_up_to_power_of_two(ring_capacity);
+		res->size = sizeof(SegmentHeader) + 2 * capacity;
+
+		const int fd = shm_open(res->name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+		if (fd == -1)
+		{
+			res->owner = false;
+			throw std::runtime_error("shm_open failed for " + res->name + ": " + std::strerror(errno));
+		}
+		if (ftruncate(fd, static_cast<off_t>(res->size)) == -1)
+		{
+			close(fd);
+			throw std::runtime_error("ftruncate failed for " + res->name + ": " + std::strerror(errno));
+		}
+		res->map(fd);
+
+		// fresh mapping is zero-filled, so all positions and flags already start at 0
+		auto header = res->header();
+		header->magic = SEGMENT_MAGIC;
+		header->capacity = capacity;
+		return res;
+	}
+
+	static std::shared_ptr<Segment> open(std::string name)
+	{
+		std::shared_ptr<Segment> res(new Segment(std::move(name), false));
+
+		const int fd = shm_open(res->name.c_str(), O_RDWR, 0);
+		if (fd == -1)
+		{
+			throw std::runtime_error("shm_open failed for " + res->name + ": " + std::strerror(errno));
+		}
+		struct stat st{};
+		if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(SegmentHeader))
+		{
+			close(fd);
+			throw std::runtime_error("invalid shared memory segment " + res->name);
+		}
+		res->size = static_cast<size_t>(st.st_size);
+		res->map(fd);
+
+		auto header = res->header();
+		if (header->magic != SEGMENT_MAGIC || sizeof(SegmentHeader) + 2 * header->capacity != res->size)
+		{
+			throw std::runtime_error("invalid shared memory segment " + res->name);
+		}
+		return res;
+	}
+
+	/**
+	 * \brief Removes the name, the mapping stays valid until both sides unmap it.
+	 */
+	void unlink()
+	{
+		if (owner)
+		{
+			shm_unlink(name.c_str());
+			owner = false;
+		}
+	}
+
+	std::string const& get_name() const
+	{
+		return name;
+	}
+
+	SegmentHeader* header() const
+	{
+		return static_cast<SegmentHeader*>(address);
+	}
+
+	uint8_t* data(int ring) const
+	{
+		return static_cast<uint8_t*>(address) + sizeof(SegmentHeader) + ring * header()->capacity;
+	}
+};
+
+/**
+ * \brief Socket provider which moves bytes through the segment while [control] keeps the TCP connection alive.
+ * [SocketWire] serializes all sends under its socket lock and receives on a single thread, so each ring has exactly
+ * one producer and one consumer.
+ */
+class SharedMemorySocket : public CActiveSocket
+{
+	std::shared_ptr<CActiveSocket> control;
+	std::shared_ptr<Segment> segment;
+
+	SegmentHeader& header;
+	const uint64_t capacity;
+	RingHeader& in;
+	uint8_t* const in_data;
+	RingHeader& out;
+	uint8_t* const out_data;
+
+	bool is_closed() const
+	{
+		return header.closed.load() != 0;
+	}
+
+	bool counterpart_alive()
+	{
+		if (!control->IsSocketValid())
+		{
+			return false;
+		}
+		uint8_t probe;
+		const auto res = recv(control->GetSocketDescriptor(), &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+		return res != 0 && !(res == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+	}
+
+	void close_rings()
+	{
+		header.closed.store(1);
+		for (auto& ring : header.rings)
+		{
+			ring.data_seq.fetch_add(1);
+			futex_wake(ring.data_seq);
+			ring.space_seq.fetch_add(1);
+			futex_wake(ring.space_seq);
+		}
+	}
+
+public:
+	// region ctor/dtor
+
+	SharedMemorySocket(std::shared_ptr<CActiveSocket> control, std::shared_ptr<Segment> segment, int in_ring)
+		: control(std::move(control))
+		, segment(std::move(segment))
+		, header(*this->segment->header())
+		, capacity(header.capacity)
+		, in(header.rings[in_ring])
+		, in_data(this->segment->data(in_ring))
+		, out(header.rings[1 - in_ring])
+		, out_data(this->segment->data(1 - in_ring))
+	{
+	}
+	// endregion
+
+	using CActiveSocket::Send;
+
+	int32_t Send(const uint8_t* buf, size_t size) override
+	{
+		size_t written = 0;
+		while (written < size)
+		{
+			if (is_closed())
+			{
+				SetSocketError(SocketInvalidSocket);
+				return -1;
+			}
+			const uint64_t tail = out.tail.load(std::memory_order_relaxed);
+			const uint64_t free = capacity - (tail - out.head.load(std::memory_order_acquire));
+			if (free == 0)
+			{
+				const uint32_t seq = out.space_seq.load();
+				out.producer_waiting.store(1);
+				if (capacity - (tail - out.head.load()) == 0 && !is_closed())
+				{
+					futex_wait(out.space_seq, seq);
+				}
+				out.producer_waiting.store(0);
+				if (!counterpart_alive())
+				{
+					SetSocketError(SocketConnectionReset);
+					return -1;
+				}
+				continue;
+			}
+
+			const size_t chunk = static_cast<size_t>((std::min)(free, static_cast<uint64_t>(size - written)));
+			const size_t offset = static_cast<size_t>(tail & (capacity - 1));
+			const size_t first = (std::min)(chunk, static_cast<size_t>(capacity) - offset);
+			std::memcpy(out_data + offset, buf + written, first);
+			std::memcpy(out_data, buf + written + first, chunk - first);
+			out.tail.store(tail + chunk, std::memory_order_release);
+			written += chunk;
+
+			out.data_seq.fetch_add(1);
+			if (out.consumer_waiting.load() != 0)
+			{
+				futex_wake(out.data_seq);
+			}
+		}
+		SetSocketError(SocketSuccess);
+		return static_cast<int32_t>(written);
+	}
+
+	int32_t Receive(int32_t max_bytes, uint8_t* buf) override
+	{
+		if (buf == nullptr)
+		{
+			SetSocketError(SocketInvalidPointer);
+			return -1;
+		}
+		while (true)
+		{
+			const uint64_t head = in.head.load(std::memory_order_relaxed);
+			const uint64_t available = in.tail.load(std::memory_order_acquire) - head;
+			if (available > 0)
+			{
+				const size_t chunk = static_cast<size_t>((std::min)(available, static_cast<uint64_t>(max_bytes)));
+				const size_t offset = static_cast<size_t>(head & (capacity - 1));
+				const size_t first = (std::min)(chunk, static_cast<size_t>(capacity) - offset);
+				std::memcpy(buf, in_data + offset, first);
+				std::memcpy(buf + first, in_data, chunk - first);
+				in.head.store(head + chunk, std::memory_order_release);
+
+				in.space_seq.fetch_add(1);
+				if (in.producer_waiting.load() != 0)
+				{
+					futex_wake(in.space_seq);
+				}
+				SetSocketError(SocketSuccess);
+				return static_cast<int32_t>(chunk);
+			}
+
+			// drain everything the counterpart managed to write before closing, like a TCP FIN
+			if (is_closed() || !counterpart_alive())
+			{
+				return 0;
+			}
+
+			const uint32_t seq = in.data_seq.load();
+			in.consumer_waiting.store(1);
+			if (in.tail.load() == head && !is_closed())
+			{
+				futex_wait(in.data_seq, seq);
+			}
+			in.consumer_waiting.store(0);
+		}
+	}
+
+	bool Shutdown(CShutdownMode mode) override
+	{
+		close_rings();
+		return control->Shutdown(mode);
+	}
+
+	bool Close() override
+	{
+		close_rings();
+		return control->Close();
+	}
+
+	bool IsSocketValid() override
+	{
+		return !is_closed() && control->IsSocketValid();
+	}
+};
+
+std::string next_segment_name()
+{
+	static std::atomic<uint32_t> counter{0};
+	return "/rd-shm-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+}
+#endif
+}	 // namespace
+
+SharedMemoryWire::Server::Server(Lifetime lifetime, IScheduler* scheduler, uint16_t port, const std::string& id, size_t ring_capacity)
+	: SocketWire::Server(lifetime, scheduler, port, id,
+		  [id, ring_capacity](std::shared_ptr<CActiveSocket> const& socket) -> std::shared_ptr<CActiveSocket> {
+#if defined(__linux__)
+			  std::shared_ptr<Segment> segment;
+			  try
+			  {
+				  segment = Segment::create(next_segment_name(), ring_capacity);
+			  }
+			  catch (std::exception const& e)
+			  {
+				  RD_LOG_WARN(logger, "{}: shared memory is unavailable, staying on socket | {}", id, e.what());
+			  }
+			  if (segment != nullptr)
+			  {
+				  auto const& name = segment->get_name();
+				  RD_ASSERT_THROW_MSG(send_int32(*socket, static_cast<int32_t>(name.size())) &&
+										  send_exactly(*socket, reinterpret_cast<uint8_t const*>(name.data()),
+											  static_cast<int32_t>(name.size())),
+					  fmt::format("{}: failed to offer shared memory segment, reason: {}", id, socket->DescribeError()));
+
+				  int32_t answer = SEGMENT_UNAVAILABLE;
+				  socket->SetReceiveTimeout(NEGOTIATION_TIMEOUT_SEC);
+				  RD_ASSERT_THROW_MSG(receive_int32(*socket, answer),
+					  fmt::format("{}: no answer to shared memory offer, reason: {}", id, socket->DescribeError()));
+				  socket->SetReceiveTimeout(0);
+				  segment->unlink();
+
+				  if (answer == SEGMENT_MAPPED)
+				  {
+					  RD_LOG_INFO(logger, "{}: switched to shared memory segment {}", id, name);
+					  return std::make_shared<SharedMemorySocket>(socket, segment, 1);
+				  }
+				  RD_LOG_INFO(logger, "{}: counterpart declined shared memory, staying on socket", id);
+				  return socket;
+			  }
+#else
+			  (void) ring_capacity;
+#endif
+			  RD_ASSERT_THROW_MSG(send_int32(*socket, SEGMENT_UNAVAILABLE),
+				  fmt::format("{}: failed to decline shared memory, reason: {}", id, socket->DescribeError()));
+			  return socket;
+		  })
+{
+}
+
+SharedMemoryWire::Client::Client(Lifetime lifetime, IScheduler* scheduler, uint16_t port, const std::string& id)
+	: SocketWire::Client(lifetime, scheduler, port, id,
+		  [id](std::shared_ptr<CActiveSocket> const& socket) -> std::shared_ptr<CActiveSocket> {
+			  int32_t name_length = SEGMENT_UNAVAILABLE;
+			  RD_ASSERT_THROW_MSG(receive_int32(*socket, name_length) && name_length >= 0 && name_length <= MAX_SEGMENT_NAME_LENGTH,
+				  fmt::format("{}: invalid shared memory offer, reason: {}", id, socket->DescribeError()));
+			  if (name_length == SEGMENT_UNAVAILABLE)
+			  {
+				  RD_LOG_INFO(logger, "{}: counterpart has no shared memory, staying on socket", id);
+				  return socket;
+			  }
+			  std::string name(static_cast<size_t>(name_length), '\0');
+			  RD_ASSERT_THROW_MSG(receive_exactly(*socket, reinterpret_cast<uint8_t*>(&name[0]), name_length),
+				  fmt::format("{}: invalid shared memory offer, reason: {}", id, socket->DescribeError()));
+
+#if defined(__linux__)
+			  std::shared_ptr<Segment> segment;
+			  try
+			  {
+				  segment = Segment::open(name);
+			  }
+			  catch (std::exception const& e)
+			  {
+				  RD_LOG_WARN(logger, "{}: failed to map shared memory, staying on socket | {}", id, e.what());
+			  }
+			  if (segment != nullptr)
+			  {
+				  RD_ASSERT_THROW_MSG(send_int32(*socket, SEGMENT_MAPPED),
+					  fmt::format("{}: failed to accept shared memory, reason: {}", id, socket->DescribeError()));
+				  RD_LOG_INFO(logger, "{}: switched to shared memory segment {}", id, name);
+				  return std::make_shared<SharedMemorySocket>(socket, segment, 0);
+			  }
+#endif
+			  RD_ASSERT_THROW_MSG(send_int32(*socket, SEGMENT_UNAVAILABLE),
+				  fmt::format("{}: failed to decline shared memory, reason: {}", id, socket->DescribeError()));
+			  return socket;
+		  })
+{
+}
+}	 // namespace rd
@@ -0,0 +1,60 @@
+#ifndef RD_CPP_SHAREDMEMORYWIRE_H
+#define RD_CPP_SHAREDMEMORYWIRE_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include "SocketWire.h"
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Same-host variant of [SocketWire]: after the TCP connection is accepted, packages travel through a pair of
+ * single-producer/single-consumer ring buffers in a shared memory segment instead of the loopback stack.
+ *
+ * The TCP socket is kept for discovery (port), liveness of the counterpart and as a fallback: if the segment can't be
+ * created or mapped on either side, the wire silently continues over TCP. Framing, sequence numbers, acknowledgements
+ * and heartbeats are those of [SocketWire], so both sides must be [SharedMemoryWire].
+ * The segment is available on Linux only, elsewhere the wire always falls back to TCP.
+ */
+class RD_FRAMEWORK_API SharedMemoryWire
+{
+public:
+	/**
+	 * \brief Size of each direction's ring, rounded up to a power of two.
+	 */
+	static constexpr size_t DEFAULT_RING_CAPACITY = 1u << 22;
+
+	class RD_FRAMEWORK_API Server : public SocketWire::Server
+	{
+	public:
+		// region ctor/dtor
+
+		Server(Lifetime lifetime, IScheduler* scheduler, uint16_t port = 0, const std::string& id = "ServerSharedMemory",
+			size_t ring_capacity = DEFAULT_RING_CAPACITY);
+
+		virtual ~Server() override = default;
+		// endregion
+	};
+
+	class RD_FRAMEWORK_API Client : public SocketWire::Client
+	{
+	public:
+		// region ctor/dtor
+
+		Client(Lifetime lifetime, IScheduler* scheduler, uint16_t port = 0, const std::string& id = "ClientSharedMemory");
+
+		virtual ~Client() override = default;
+		// endregion
+	};
+};
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_SHAREDMEMORYWIRE_H
@@ -0,0 +1,282 @@
+#include "wire/SocketReactor.h"
+
+#include "util/core_util.h"
+#include "util/thread_util.h"
+
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#else
+#include <SimpleSocket.h>
+#endif
+
+namespace rd
+{
+static std::shared_ptr<spdlog::logger> logger = util::create_logger("socketReactorLog");
+
+constexpr int32_t SocketReactor::WOULD_BLOCK;
+
+namespace
+{
+// epoll data of the descriptor which interrupts the wait for stop()
+constexpr uint64_t WAKEUP_ID = 0;
+constexpr int MAX_EVENTS = 64;
+}	 // namespace
+
+SocketReactor::SocketReactor() = default;
+
+SocketReactor::~SocketReactor()
+{
+	stop();
+}
+
+bool SocketReactor::is_supported()
+{
+#if defined(__linux__)
+	return true;
+#else
+	return false;
+#endif
+}
+
+SocketReactor& SocketReactor::Instance()
+{
+	static SocketReactor globalSocketReactor;
+	return globalSocketReactor;
+}
+
+void SocketReactor::add(Lifetime lifetime, int64_t fd, std::function<void()> on_readable)
+{
+	RD_ASSERT_THROW_MSG(is_supported(), "SocketReactor is not supported on this platform")
+	if (lifetime->is_terminated())
+	{
+		return;
+	}
+
+	// a handler registering a socket must not wait for stop() which joins the handler's thread
+	std::unique_lock<std::mutex> start_guard(start_lock, std::defer_lock);
+	if (std::this_thread::get_id() != thread_id)
+	{
+		start_guard.lock();
+	}
+
+	registration_id_t id = 0;
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+#if defined(__linux__)
+		if (!thread.joinable())
+		{
+			epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+			wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			RD_ASSERT_THROW_MSG(epoll_fd != -1 && wakeup_fd != -1, fmt::format("failed to create epoll, errno: {}", errno))
+			epoll_event wakeup_event{};
+			wakeup_event.events = EPOLLIN;
+			wakeup_event.data.u64 = WAKEUP_ID;
+			epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &wakeup_event);
+			thread = std::thread([this] { run(); });
+		}
+
+		id = next_id++;
+		epoll_event event{};
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.u64 = id;
+		RD_ASSERT_THROW_MSG(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, static_cast<int>(fd), &event) == 0,
+			fmt::format("failed to register socket {} in epoll, errno: {}", fd, errno))
+		registrations.emplace(id, std::make_shared<Registration>(Registration{fd, std::move(on_readable)}));
+		stats.registrations = registrations.size();
+#endif
+	}
+
+	try
+	{
+		lifetime->add_action([this, id] { remove(id); });
+	}
+	catch (std::invalid_argument const&)
+	{
+		remove(id);	   // terminated concurrently
+	}
+}
+
+void SocketReactor::remove(registration_id_t id)
+{
+	std::shared_ptr<Registration> registration;
+	std::unique_lock<decltype(lock)> guard(lock);
+	auto it = registrations.find(id);
+	if (it != registrations.end())
+	{
+		registration = std::move(it->second);
+		registrations.erase(it);
+		stats.registrations = registrations.size();
+#if defined(__linux__)
+		// the socket may be already closed, then it has left the epoll set by itself
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, static_cast<int>(registration->fd), nullptr);
+#endif
+	}
+	if (std::this_thread::get_id() != thread_id)
+	{
+		handler_finished.wait(guard, [this, id] { return running != id; });
+	}
+	guard.unlock();
+	// the handler is destroyed outside of the lock
+}
+
+int32_t SocketReactor::receive(int64_t fd, Buffer::word_t* data, size_t size)
+{
+#if defined(__linux__)
+	while (true)
+	{
+		const ssize_t read = ::recv(static_cast<int>(fd), data, size, MSG_DONTWAIT);
+		if (read >= 0)
+		{
+			return static_cast<int32_t>(read);
+		}
+		if (errno == EINTR)
+		{
+			continue;
+		}
+		return errno == EAGAIN || errno == EWOULDBLOCK ? WOULD_BLOCK : -1;
+	}
+#else
+	(void) fd;
+	(void) data;
+	(void) size;
+	return -1;
+#endif
+}
+
+int32_t SocketReactor::send(int64_t fd, Buffer::word_t const* data, size_t size)
+{
+#if defined(__linux__)
+	while (true)
+	{
+		const ssize_t written = ::send(static_cast<int>(fd), data, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (written >= 0)
+		{
+			return static_cast<int32_t>(written);
+		}
+		if (errno == EINTR)
+		{
+			continue;
+		}
+		return errno == EAGAIN || errno == EWOULDBLOCK ? WOULD_BLOCK : -1;
+	}
+#else
+	// no MSG_DONTWAIT: write only if the socket has room, small frames then don't block
+	const auto socket = static_cast<SOCKET>(fd);
+	fd_set write_fds;
+	FD_ZERO(&write_fds);
+	FD_SET(socket, &write_fds);
+	timeval timeout{0, 0};
+	const auto ready = SELECT(socket + 1, nullptr, &write_fds, nullptr, &timeout);
+	if (ready == 0)
+	{
+		return WOULD_BLOCK;
+	}
+	if (ready < 0)
+	{
+		return -1;
+	}
+	const auto written = SEND(socket, data, size, 0);
+	return written < 0 ? -1 : static_cast<int32_t>(written);
+#endif
+}
+
+void SocketReactor::run()
+{
+#if defined(__linux__)
+	rd::util::set_thread_name("rd::SocketReactor");
+	thread_id = std::this_thread::get_id();
+
+	std::vector<epoll_event> events(MAX_EVENTS);
+	while (true)
+	{
+		const int count = epoll_wait(epoll_fd, events.data(), MAX_EVENTS, -1);
+		std::unique_lock<decltype(lock)> guard(lock);
+		if (stopping)
+		{
+			break;
+		}
+		if (count < 0)
+		{
+			if (errno != EINTR)
+			{
+				RD_LOG_ERROR(logger, "epoll_wait failed, errno: {}", errno);
+			}
+			continue;
+		}
+		++stats.wakeups;
+		for (int i = 0; i < count && !stopping; ++i)
+		{
+			const registration_id_t id = events[i].data.u64;
+			// removed earlier in this batch
+			auto it = registrations.find(id);
+			if (id == WAKEUP_ID || it == registrations.end())
+			{
+				continue;
+			}
+			++stats.events;
+			auto registration = it->second;
+			running = id;
+			guard.unlock();
+			try
+			{
+				registration->on_readable();
+			}
+			catch (std::exception const& e)
+			{
+				RD_LOG_ERROR(logger, "Socket handler failed | {}", e.what());
+			}
+			guard.lock();
+			running = 0;
+			handler_finished.notify_all();
+		}
+	}
+	thread_id = std::thread::id();
+#endif
+}
+
+SocketReactor::Stats SocketReactor::get_stats() const
+{
+	std::lock_guard<decltype(lock)> guard(lock);
+	return stats;
+}
+
+void SocketReactor::stop()
+{
+	std::lock_guard<decltype(start_lock)> start_guard(start_lock);
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		if (!thread.joinable())
+		{
+			return;
+		}
+		stopping = true;
+	}
+#if defined(__linux__)
+	const uint64_t one = 1;
+	(void) ::write(wakeup_fd, &one, sizeof(one));
+#endif
+	thread.join();
+
+	decltype(registrations) dropped;
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		dropped = std::move(registrations);
+		registrations.clear();
+		stats.registrations = 0;
+#if defined(__linux__)
+		::close(epoll_fd);
+		::close(wakeup_fd);
+#endif
+		epoll_fd = wakeup_fd = -1;
+		stopping = false;
+	}
+	// handlers are destroyed outside of the lock
+}
+}	 // namespace rd
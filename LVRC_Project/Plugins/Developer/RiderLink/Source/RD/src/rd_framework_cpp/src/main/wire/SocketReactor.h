@@ -0,0 +1,126 @@
+#ifndef RD_CPP_SOCKETREACTOR_H
+#define RD_CPP_SOCKETREACTOR_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include "lifetime/Lifetime.h"
+#include "protocol/Buffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Single epoll thread which waits for readability of all sockets registered by wires in reactor mode
+ * (see [SocketWire::IoMode]): listening sockets to accept and connections to receive without blocking.
+ * Available on Linux only, see [is_supported].
+ *
+ * Handlers run on the reactor thread and must not block. Every registration is bound to a Lifetime: once it's
+ * terminated the handler won't be called again, and the termination waits for a handler which is running at that
+ * moment (unless it's terminated from the handler itself).
+ */
+class RD_FRAMEWORK_API SocketReactor
+{
+public:
+	struct Stats
+	{
+		uint64_t wakeups = 0;
+		uint64_t events = 0;
+		size_t registrations = 0;
+	};
+
+	/**
+	 * \brief Result of [receive] when the socket has no data at the moment.
+	 */
+	static constexpr int32_t WOULD_BLOCK = -2;
+
+	// region ctor/dtor
+
+	SocketReactor();
+
+	SocketReactor(SocketReactor const&) = delete;
+
+	SocketReactor& operator=(SocketReactor const&) = delete;
+
+	virtual ~SocketReactor();
+	// endregion
+
+	static bool is_supported();
+
+	/**
+	 * \brief global reactor for whole application.
+	 */
+	static SocketReactor& Instance();
+
+	/**
+	 * \brief Calls [on_readable] whenever [fd] has data, a pending connection or is closed by the peer,
+	 * until [lifetime] is terminated. Level-triggered: data left unread is reported again.
+	 */
+	void add(Lifetime lifetime, int64_t fd, std::function<void()> on_readable);
+
+	/**
+	 * \brief Non-blocking read of at most [size] bytes.
+	 * \return number of bytes read, 0 if the peer closed the connection, [WOULD_BLOCK] or -1 on error.
+	 */
+	static int32_t receive(int64_t fd, Buffer::word_t* data, size_t size);
+
+	/**
+	 * \brief Non-blocking write of at most [size] bytes, available on every platform. Outside of Linux the socket is
+	 * only checked for room before the write, which is enough for control frames.
+	 * \return number of bytes written, [WOULD_BLOCK] if the socket's send buffer is full or -1 on error.
+	 */
+	static int32_t send(int64_t fd, Buffer::word_t const* data, size_t size);
+
+	Stats get_stats() const;
+
+	/**
+	 * \brief Joins the reactor thread and drops registrations. Registering again restarts the thread.
+	 */
+	void stop();
+
+private:
+	struct Registration
+	{
+		int64_t fd;
+		std::function<void()> on_readable;
+	};
+
+	using registration_id_t = uint64_t;
+
+	// serializes starting the thread with stop(), [lock] guards everything else
+	std::mutex start_lock;
+	mutable std::mutex lock;
+	std::condition_variable handler_finished;
+	std::thread thread;
+	std::atomic<std::thread::id> thread_id{};
+	bool stopping = false;
+
+	int epoll_fd = -1;
+	int wakeup_fd = -1;
+	registration_id_t next_id = 1;
+	std::map<registration_id_t, std::shared_ptr<Registration>> registrations;
+	registration_id_t running = 0;
+	Stats stats;
+
+	void remove(registration_id_t id);
+
+	void run();
+};
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_SOCKETREACTOR_H
@@ -1,8 +1,11 @@
 #include "wire/SocketWire.h"
+#include "wire/Lz4BlockCodec.h"
+#include "wire/SocketReactor.h"
+#include "scheduler/TimerWheel.h"
 
 #include <util/thread_util.h>
 
-#include "spdlog/sinks/stdout_color_sinks.h"
+#include "util/core_log.h"
 
 #include <SimpleSocket.h>
 #include <ActiveSocket.h>
@@ -11,17 +14,23 @@
 #include <utility>
 #include <thread>
 #include <csignal>
+#include <cstring>
 
 namespace rd
 {
 std::shared_ptr<spdlog::logger> SocketWire::Base::logger =
-	spdlog::stderr_color_mt<spdlog::synchronous_factory>("wireLog", spdlog::color_mode::automatic);
+	util::create_logger("wireLog");
 
 std::chrono::milliseconds SocketWire::timeout = std::chrono::milliseconds(500);
 
 constexpr int32_t SocketWire::Base::ACK_MESSAGE_LENGTH;
 constexpr int32_t SocketWire::Base::PING_MESSAGE_LENGTH;
+constexpr int32_t SocketWire::Base::HANDSHAKE_MESSAGE_LENGTH;
 constexpr int32_t SocketWire::Base::PACKAGE_HEADER_LENGTH;
+constexpr int32_t SocketWire::Base::COMPRESSED_PACKAGE_FLAG;
+constexpr int32_t SocketWire::Base::COMPACT_MESSAGE_FLAG;
+constexpr SocketWire::Base::capabilities_t SocketWire::Base::CAPABILITY_COMPRESSION;
+constexpr SocketWire::Base::capabilities_t SocketWire::Base::CAPABILITY_COMPACT_ENCODING;
 
 SocketWire::Base::Base(std::string id, Lifetime parentLifetime, IScheduler* scheduler)
 	: WireBase(scheduler), id(std::move(id)), scheduler(scheduler), local_send_buffer(SEND_BUFFER_SIZE), lifetimeDef(parentLifetime)
@@ -41,27 +50,29 @@ SocketWire::Base::~Base()
 
 void SocketWire::Base::receiverProc() const
 {
+	// flushed whenever the socket is drained, see read_from_socket
+	MessageBroker::BatchScope batch(message_broker);
 	while (!lifetimeDef.lifetime->is_terminated())
 	{
 		try
 		{
 			if (!socket_provider->IsSocketValid())
 			{
-				logger->debug("{}: stop receive messages because socket disconnected", this->id);
+				RD_LOG_DEBUG(logger, "{}: stop receive messages because socket disconnected", this->id);
 				//					async_send_buffer.terminate();
 				break;
 			}
 
 			if (!read_and_dispatch_message())
 			{
-				logger->debug("{}: connection was gracefully shutdown", id);
+				RD_LOG_DEBUG(logger, "{}: connection was gracefully shutdown", id);
 				//					async_send_buffer.terminate();
 				break;
 			}
 		}
 		catch (std::exception const& ex)
 		{
-			logger->error("{} caught processing | {}", this->id, ex.what());
+			RD_LOG_ERROR(logger, "{} caught processing | {}", this->id, ex.what());
 			//				async_send_buffer.terminate();
 			break;
 		}
@@ -72,12 +83,31 @@ bool SocketWire::Base::send0(Buffer::ByteArray const& msg, sequence_number_t seq
 {
 	try
 	{
-		std::lock_guard<decltype(socket_send_lock)> guard(socket_send_lock);
-
+		Buffer::word_t const* body = msg.data();
 		int32_t msglen = static_cast<int32_t>(msg.size());
+		int32_t header_len = msglen;
+
+		if (compression_threshold > 0 && msglen >= compression_threshold &&
+			(counterpart_capabilities & CAPABILITY_COMPRESSION) != 0)
+		{
+			// layout: original length, compressed block
+			send_compression_buffer.resize(sizeof(int32_t) + Lz4BlockCodec::compress_bound(msg.size()));
+			const size_t compressed = Lz4BlockCodec::compress(msg.data(), msg.size(), send_compression_buffer.data() + sizeof(int32_t),
+				send_compression_buffer.size() - sizeof(int32_t));
+			const int32_t compressed_len = static_cast<int32_t>(sizeof(int32_t) + compressed);
+			if (compressed > 0 && compressed_len < msglen)
+			{
+				std::memcpy(send_compression_buffer.data(), &msglen, sizeof(int32_t));
+				body = send_compression_buffer.data();
+				msglen = compressed_len;
+				header_len = compressed_len | COMPRESSED_PACKAGE_FLAG;
+			}
+		}
+
+		std::lock_guard<decltype(socket_send_lock)> guard(socket_send_lock);
 
 		send_package_header.rewind();
-		send_package_header.write_integral(msglen);
+		send_package_header.write_integral(header_len);
 		send_package_header.write_integral(seqn);
 
 		RD_ASSERT_THROW_MSG(
@@ -87,40 +117,205 @@ bool SocketWire::Base::send0(Buffer::ByteArray const& msg, sequence_number_t seq
 				", reason: " +
 				socket_provider->DescribeError())
 
-		RD_ASSERT_THROW_MSG(socket_provider->Send(msg.data(), msglen) == msglen, this->id +
-																					 ": failed to send package over the network"
-																					 ", reason: " +
-																					 socket_provider->DescribeError());
-		logger->info("{}: were sent {} bytes", this->id, msglen);
+		RD_ASSERT_THROW_MSG(socket_provider->Send(body, msglen) == msglen, this->id +
+																			   ": failed to send package over the network"
+																			   ", reason: " +
+																			   socket_provider->DescribeError());
+		metrics.on_package_sent(seqn, PACKAGE_HEADER_LENGTH + msglen);
+		RD_LOG_TRACE(logger, "{}: were sent {} bytes", this->id, msglen);
+		flush_pending_ack(true);
 		//        RD_ASSERT_MSG(socketProvider->Flush(), "{}: failed to flush");
 		return true;
 	}
 	catch (std::exception const& e)
 	{
 		//			async_send_buffer.pause("send0");
-		logger->warn("Send0 failed due to: | {}", e.what());
+		RD_LOG_WARN(logger, "Send0 failed due to: | {}", e.what());
 		return false;
 	}
 }
 
-void SocketWire::Base::send(RdId const& rd_id, std::function<void(Buffer& buffer)> writer) const
+Buffer::ByteArray SocketWire::Base::write_message(RdId const& rd_id, std::function<void(Buffer& buffer)> const& writer) const
 {
 	RD_ASSERT_MSG(!rd_id.isNull(), "{}: id mustn't be null");
 
+	if (writing_message)
+	{
+		// the writer sends on its own (e.g. interns a new value): the nested message is queued first,
+		// so it needs a buffer of its own not to overwrite the outer one
+		Buffer nested_buffer;
+		return write_message(nested_buffer, rd_id, writer, is_compact_encoding_negotiated());
+	}
+
+	writing_message = true;
+	try
+	{
+		auto res = write_message(local_send_buffer, rd_id, writer, is_compact_encoding_negotiated());
+		writing_message = false;
+		return res;
+	}
+	catch (...)
+	{
+		local_send_buffer.rewind();
+		local_send_buffer.set_compact(false);
+		writing_message = false;
+		throw;
+	}
+}
+
+Buffer::ByteArray SocketWire::Base::write_message(
+	Buffer& buffer, RdId const& rd_id, std::function<void(Buffer& buffer)> const& writer, bool compact)
+{
+	buffer.set_compact(compact);
+	{
+		Buffer::WriteCursor header(buffer, sizeof(int32_t) + sizeof(RdId::hash_t) + sizeof(int16_t));
+		header.write_integral<int32_t>(0);			  // placeholder for length
+		header.write_integral(rd_id.get_hash());	  // write id
+		header.write_integral<int16_t>(0);			  // placeholder for context
+	}
+	writer(buffer);	   // write rest
+
+	int32_t len = static_cast<int32_t>(buffer.get_position());
+
+	// the writer may have switched the encoding off, e.g. to send a payload written beforehand
+	const int32_t flag = buffer.is_compact() ? COMPACT_MESSAGE_FLAG : 0;
+	buffer.rewind();
+	buffer.write_integral<int32_t>((len - 4) | flag);
+	buffer.set_position(static_cast<size_t>(len));
+	auto res = std::move(buffer).getRealArray();
+	buffer.rewind();
+	buffer.set_compact(false);
+	return res;
+}
+
+bool SocketWire::Base::is_compact_encoding_negotiated() const
+{
+	return (local_capabilities & counterpart_capabilities & CAPABILITY_COMPACT_ENCODING) != 0;
+}
+
+void SocketWire::Base::send(RdId const& rd_id, std::function<void(Buffer& buffer)> writer) const
+{
+	std::lock_guard<decltype(wire_send_lock)> lock(wire_send_lock);
+	auto message = write_message(rd_id, writer);
+	if (is_send_batching())
+	{
+		add_to_send_batch(message);
+	}
+	else
+	{
+		async_send_buffer.put(std::move(message));
+	}
+	metrics.on_message_sent();
+}
+
+bool SocketWire::Base::try_send(RdId const& rd_id, std::function<void(Buffer& buffer)> writer) const
+{
 	std::lock_guard<decltype(wire_send_lock)> lock(wire_send_lock);
-	local_send_buffer.write_integral<int32_t>(0);	 // placeholder for length
+	if (async_send_buffer.is_congested())
+	{
+		return false;
+	}
+	if (is_send_batching())
+	{
+		add_to_send_batch(write_message(rd_id, writer));
+	}
+	else if (!async_send_buffer.try_put(write_message(rd_id, writer)))
+	{
+		return false;
+	}
+	metrics.on_message_sent();
+	return true;
+}
+
+bool SocketWire::Base::begin_send_batch() const
+{
+	std::thread::id none{};
+	return send_batch_thread.compare_exchange_strong(none, std::this_thread::get_id());
+}
+
+void SocketWire::Base::end_send_batch() const
+{
+	{
+		std::lock_guard<decltype(wire_send_lock)> lock(wire_send_lock);
+		flush_send_batch();
+	}
+	send_batch_thread = std::thread::id{};
+}
+
+bool SocketWire::Base::is_send_batching() const
+{
+	return send_batch_thread.load(std::memory_order_relaxed) == std::this_thread::get_id();
+}
+
+void SocketWire::Base::add_to_send_batch(Buffer::ByteArray const& message) const
+{
+	// the reader takes messages from the stream of packages, so a package may carry any number of them
+	send_batch_buffer.write_byte_array_raw(message);
+	if (send_batch_buffer.get_position() >= SEND_BATCH_MAX_BYTES)
+	{
+		flush_send_batch();
+	}
+}
+
+void SocketWire::Base::flush_send_batch() const
+{
+	if (send_batch_buffer.get_position() == 0)
+	{
+		return;
+	}
+	async_send_buffer.put(std::move(send_batch_buffer).getRealArray());
+}
 
-	rd_id.write(local_send_buffer);					 // write id
-	local_send_buffer.write_integral<int16_t>(0);	 // placeholder for context
-	writer(local_send_buffer);						 // write rest
+void SocketWire::Base::set_send_window(
+	ByteBufferAsyncProcessor::Window window, ByteBufferAsyncProcessor::BackpressurePolicy policy)
+{
+	async_send_buffer.set_window(window, policy);
+}
 
-	int32_t len = static_cast<int32_t>(local_send_buffer.get_position());
+ByteBufferAsyncProcessor::WindowOccupancy SocketWire::Base::get_send_window_occupancy() const
+{
+	return async_send_buffer.get_window_occupancy();
+}
+
+WireMetrics::Snapshot SocketWire::Base::get_metrics() const
+{
+	auto res = metrics.snapshot();
+	const auto occupancy = async_send_buffer.get_window_occupancy();
+	// gauges are read one by one, so the pending part may be momentarily ahead of the total
+	res.queued_messages = occupancy.messages - (std::min)(occupancy.messages, occupancy.pending_messages);
+	res.queued_bytes = occupancy.bytes - (std::min)(occupancy.bytes, occupancy.pending_bytes);
+	res.pending_messages = occupancy.pending_messages;
+	res.pending_bytes = occupancy.pending_bytes;
+	res.dropped_messages = occupancy.dropped_messages;
+	return res;
+}
 
-	local_send_buffer.rewind();
-	local_send_buffer.write_integral<int32_t>(len - 4);
-	local_send_buffer.set_position(static_cast<size_t>(len));
-	async_send_buffer.put(std::move(local_send_buffer).getRealArray());
-	local_send_buffer.rewind();
+void SocketWire::Base::reset_metrics()
+{
+	metrics.reset();
+}
+
+std::shared_ptr<CActiveSocket> SocketWire::Base::upgrade(std::shared_ptr<CActiveSocket> const& connected_socket) const
+{
+	if (!upgrade_connection)
+	{
+		return connected_socket;
+	}
+	try
+	{
+		auto upgraded = upgrade_connection(connected_socket);
+		if (upgraded != nullptr)
+		{
+			return upgraded;
+		}
+	}
+	catch (std::exception const& e)
+	{
+		// the stream may be in the middle of the upgrade exchange, so it can't carry packages anymore
+		RD_LOG_WARN(logger, "{}: failed to upgrade connection, dropping it | {}", this->id, e.what());
+		connected_socket->Shutdown(CSimpleSocket::Both);
+	}
+	return connected_socket;
 }
 
 void SocketWire::Base::set_socket_provider(std::shared_ptr<CActiveSocket> new_socket)
@@ -137,34 +332,117 @@ void SocketWire::Base::set_socket_provider(std::shared_ptr<CActiveSocket> new_so
 			return;
 		}
 	}
+	metrics.on_connected();
 
-	auto heartbeat = LifetimeDefinition::use([this](Lifetime heartbeatLifetime) {
-		const auto heartbeat = start_heartbeat(heartbeatLifetime).share();
+	LifetimeDefinition::use([this](Lifetime connectionLifetime) {
+		// terminating connectionLifetime cancels the heartbeat timer and waits for a ping in flight
+		start_connection(connectionLifetime);
 
-		async_send_buffer.resume();
+		receiverProc();
 
-		connected.set(true);
+		stop_connection();
+	});
 
-		receiverProc();
+	shutdown_socket_provider();
+}
+
+bool SocketWire::Base::attach_to_reactor(
+	Lifetime lifetime, std::shared_ptr<CActiveSocket> new_socket, std::function<void()> on_closed)
+{
+	{
+		std::lock_guard<decltype(socket_send_lock)> guard(socket_send_lock);
+		socket_provider = std::move(new_socket);
+		socket_send_var.notify_all();
+	}
+	try
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		if (lifetime->is_terminated())
+		{
+			return false;
+		}
+		connection_definition = std::make_unique<LifetimeDefinition>(lifetime);
+	}
+	catch (std::invalid_argument const&)
+	{
+		return false;	 // terminated concurrently
+	}
+	metrics.on_connected();
+	lo = hi = receiver_buffer.begin();
+	reactor_state = ReactorReceiveState();
+	pending_ack = 0;
+
+	Lifetime connection_lifetime = connection_definition->lifetime;
+	try
+	{
+		start_connection(connection_lifetime);
+		// actions run in reverse order: the socket leaves the reactor first, then the connection is stopped
+		connection_lifetime->add_action([this] { stop_connection(); });
+		SocketReactor::Instance().add(connection_lifetime, socket_provider->GetSocketDescriptor(), [this, on_closed] {
+			std::lock_guard<decltype(reactor_lock)> guard(reactor_lock);
+			if (receive_from_reactor())
+			{
+				return;
+			}
+			connection_definition->terminate();
+			shutdown_socket_provider();
+			if (on_closed)
+			{
+				on_closed();
+			}
+		});
+	}
+	catch (std::invalid_argument const&)
+	{
+		// terminated concurrently, stop_connection has run already or won't be needed
+		return false;
+	}
+	return true;
+}
+
+void SocketWire::Base::set_io_mode(IoMode requested)
+{
+	io_mode = requested;
+	if (io_mode == IoMode::Reactor && (!SocketReactor::is_supported() || upgrade_connection))
+	{
+		RD_LOG_WARN(logger, "{}: reactor mode isn't available {}, falling back to thread mode", this->id,
+			upgrade_connection ? "for upgraded connections" : "on this platform");
+		io_mode = IoMode::Thread;
+	}
+}
+
+void SocketWire::Base::start_connection(Lifetime connection_lifetime)
+{
+	start_heartbeat(connection_lifetime);
+
+	counterpart_capabilities = 0;
+	if (local_capabilities != 0)
+	{
+		send_handshake();
+	}
 
-		connected.set(false);
+	async_send_buffer.resume();
 
-		async_send_buffer.pause("Disconnected");
+	connected.set(true);
+}
 
-		return heartbeat;
-	});
-	const auto status = heartbeat.wait_for(timeout);
+void SocketWire::Base::stop_connection()
+{
+	connected.set(false);
 
-	logger->debug("{}: waited for heartbeat to stop with status: {}", this->id, status);
+	async_send_buffer.pause("Disconnected");
+}
 
+void SocketWire::Base::shutdown_socket_provider()
+{
 	if (!socket_provider->IsSocketValid())
 	{
-		logger->debug("{}: socket was already shut down", this->id);
+		RD_LOG_DEBUG(logger, "{}: socket was already shut down", this->id);
 	}
 	else if (!socket_provider->Shutdown(CSimpleSocket::Both))
 	{
 		// double close?
-		logger->warn("{}: possibly double close after disconnect", this->id);
+		RD_LOG_WARN(logger, "{}: possibly double close after disconnect", this->id);
 	}
 }
 
@@ -173,15 +451,9 @@ bool SocketWire::Base::connection_established(int32_t timestamp, int32_t notion_
 	return timestamp - notion_timestamp <= MaximumHeartbeatDelay;
 }
 
-std::future<void> SocketWire::Base::start_heartbeat(Lifetime lifetime)
+void SocketWire::Base::start_heartbeat(Lifetime lifetime)
 {
-	return std::async([this, lifetime] {
-		while (!lifetime->is_terminated())
-		{
-			std::this_thread::sleep_for(heartBeatInterval);
-			ping();
-		}
-	});
+	TimerWheel::Instance().schedule_periodic(lifetime, heartBeatInterval, [this] { ping(); });
 }
 
 bool SocketWire::Base::read_from_socket(Buffer::word_t* res, int32_t msglen) const
@@ -207,34 +479,36 @@ bool SocketWire::Base::read_from_socket(Buffer::word_t* res, int32_t msglen) con
 			{
 				hi = lo = receiver_buffer.begin();
 			}
-			logger->info("{}: receive started", this->id);
+			// everything received so far is dispatched, let it go before waiting for more
+			message_broker.flush_batch();
+			RD_LOG_TRACE(logger, "{}: receive started", this->id);
 			int32_t read = socket_provider->Receive(static_cast<int32_t>(receiver_buffer.end() - hi), &*hi);
 			if (read == -1)
 			{
 				auto err = socket_provider->GetSocketError();
 				if (err == CSimpleSocket::SocketInvalidSocket)
 				{
-					logger->info("{}: socket was shut down for receiving", this->id);
+					RD_LOG_INFO(logger, "{}: socket was shut down for receiving", this->id);
 					return false;
 				}
-				logger->error("{}: error has occurred while receiving", this->id);
+				RD_LOG_ERROR(logger, "{}: error has occurred while receiving", this->id);
 				return false;
 			}
 			if (read == 0)
 			{
-				logger->info("{}: socket was shut down for receiving", this->id);
+				RD_LOG_INFO(logger, "{}: socket was shut down for receiving", this->id);
 				return false;
 			}
 			hi += read;
 			if (read > 0)
 			{
-				logger->info("{}: receive finished: {} bytes read", this->id, read);
+				RD_LOG_TRACE(logger, "{}: receive finished: {} bytes read", this->id, read);
 			}
 		}
 	}
 	if (ptr != msglen)
 	{
-		logger->error("read invalid number of bytes from socket, expected: {}, actual: {}", msglen, ptr);
+		RD_LOG_ERROR(logger, "read invalid number of bytes from socket, expected: {}, actual: {}", msglen, ptr);
 		assert(false);
 	}
 	return true;
@@ -265,25 +539,7 @@ std::pair<int, sequence_number_t> SocketWire::Base::read_header() const
 				return INVALID_HEADER;
 			}
 
-			counterpart_timestamp = received_timestamp;
-			counterpart_acknowledge_timestamp = received_counterpart_timestamp;
-
-			if ((connection_established(current_timestamp, counterpart_acknowledge_timestamp)))
-			{
-				if (!heartbeatAlive.get())
-				{	 // only on change
-					logger->trace(
-						"Connection is alive after receiving PING {}: "
-						"received_timestamp: {}, "
-						"received_counterpart_timestamp: {}, "
-						"current_timestamp: {}, "
-						"counterpart_timestamp: {}, "
-						"counterpart_acknowledge_timestamp: {}, ",
-						id, received_timestamp, received_counterpart_timestamp, current_timestamp, counterpart_timestamp,
-						counterpart_acknowledge_timestamp);
-				}
-				heartbeatAlive.set(true);
-			}
+			on_ping(received_timestamp, received_counterpart_timestamp);
 			continue;
 		}
 		if (!read_integral_from_socket(seqn))
@@ -291,15 +547,54 @@ std::pair<int, sequence_number_t> SocketWire::Base::read_header() const
 			return INVALID_HEADER;
 		}
 
-		if (len == ACK_MESSAGE_LENGTH)
+		if (on_control_header(len, seqn))
 		{
-			async_send_buffer.acknowledge(seqn);
 			continue;
 		}
 		return std::make_pair(len, seqn);
 	}
 }
 
+void SocketWire::Base::on_ping(int32_t received_timestamp, int32_t received_counterpart_timestamp) const
+{
+	counterpart_timestamp = received_timestamp;
+	counterpart_acknowledge_timestamp = received_counterpart_timestamp;
+
+	if ((connection_established(current_timestamp, counterpart_acknowledge_timestamp)))
+	{
+		if (!heartbeatAlive.get())
+		{	 // only on change
+			RD_LOG_TRACE(logger, 
+				"Connection is alive after receiving PING {}: "
+				"received_timestamp: {}, "
+				"received_counterpart_timestamp: {}, "
+				"current_timestamp: {}, "
+				"counterpart_timestamp: {}, "
+				"counterpart_acknowledge_timestamp: {}, ",
+				id, received_timestamp, received_counterpart_timestamp, current_timestamp, counterpart_timestamp,
+				counterpart_acknowledge_timestamp);
+		}
+		heartbeatAlive.set(true);
+	}
+}
+
+bool SocketWire::Base::on_control_header(int32_t len, sequence_number_t seqn) const
+{
+	if (len == HANDSHAKE_MESSAGE_LENGTH)
+	{
+		RD_LOG_DEBUG(logger, "{}: received handshake, capabilities={}", this->id, seqn);
+		counterpart_capabilities = seqn;
+		return true;
+	}
+	if (len == ACK_MESSAGE_LENGTH)
+	{
+		metrics.on_acknowledged(seqn);
+		async_send_buffer.acknowledge(seqn);
+		return true;
+	}
+	return false;
+}
+
 int32_t SocketWire::Base::read_package() const
 {
 	receive_pkg.rewind();
@@ -307,59 +602,127 @@ int32_t SocketWire::Base::read_package() const
 	const auto pair = read_header();
 	if (pair == INVALID_HEADER)
 	{
-		logger->debug("{}: failed to read header", this->id);
+		RD_LOG_DEBUG(logger, "{}: failed to read header", this->id);
 		return -1;
 	}
-	const auto len = pair.first;
+	auto len = pair.first;
 	const auto seqn = pair.second;
 
-	logger->debug("{}: read len={}, seqn={}, max_received_seqn={}", this->id, len, seqn, max_received_seqn);
+	RD_LOG_TRACE(logger, "{}: read len={}, seqn={}, max_received_seqn={}", this->id, len, seqn, max_received_seqn);
 
-	receive_pkg.require_available(len);
-	if (!read_data_from_socket(receive_pkg.data(), len))
+	if ((len & COMPRESSED_PACKAGE_FLAG) != 0)
+	{
+		const int32_t compressed_len = len & ~COMPRESSED_PACKAGE_FLAG;
+		receive_compression_buffer.resize(compressed_len);
+		if (compressed_len < static_cast<int32_t>(sizeof(int32_t)) ||
+			!read_data_from_socket(receive_compression_buffer.data(), compressed_len))
+		{
+			RD_LOG_DEBUG(logger, "{}: failed to read compressed package", this->id);
+			return -1;
+		}
+	}
+	else
+	{
+		receive_pkg.require_available(len);
+		if (!read_data_from_socket(receive_pkg.data(), len))
+		{
+			RD_LOG_DEBUG(logger, "{}: failed to read package", this->id);
+			return -1;
+		}
+	}
+	len = unpack_package(len, seqn);
+	if (len < 0)
 	{
-		logger->debug("{}: failed to read package", this->id);
 		return -1;
 	}
-	send_ack(seqn);
-	if (seqn <= max_received_seqn && seqn != 1)
+	if (!accept_package(seqn))
 	{
 		return true;
 	}
-	max_received_seqn = seqn;
 
-	logger->info("{}: was received package, bytes={}, seqn={}", this->id, len, seqn);
+	RD_LOG_TRACE(logger, "{}: was received package, bytes={}, seqn={}", this->id, len, seqn);
 	return len;
 }
 
+int32_t SocketWire::Base::unpack_package(int32_t len, sequence_number_t seqn) const
+{
+	if ((len & COMPRESSED_PACKAGE_FLAG) == 0)
+	{
+		metrics.on_package_received(PACKAGE_HEADER_LENGTH + len);
+		return len;
+	}
+
+	const int32_t compressed_len = len & ~COMPRESSED_PACKAGE_FLAG;
+	metrics.on_package_received(PACKAGE_HEADER_LENGTH + compressed_len);
+	int32_t original_len = -1;
+	if (compressed_len >= static_cast<int32_t>(sizeof(int32_t)))
+	{
+		std::memcpy(&original_len, receive_compression_buffer.data(), sizeof(int32_t));
+	}
+	const auto payload_len = static_cast<size_t>(compressed_len) - sizeof(int32_t);
+	if (original_len < 0 || static_cast<size_t>(original_len) > Lz4BlockCodec::decompress_bound(payload_len))
+	{
+		// the length comes from the peer: don't let it size the buffer before the block is checked
+		RD_LOG_ERROR(logger, "{}: invalid original length of compressed package, len={}, compressed={}, seqn={}", this->id,
+			original_len, compressed_len, seqn);
+		return -1;
+	}
+	receive_pkg.rewind();
+	receive_pkg.require_available(original_len);
+	if (!Lz4BlockCodec::decompress(receive_compression_buffer.data() + sizeof(int32_t), payload_len, receive_pkg.data(), original_len))
+	{
+		RD_LOG_ERROR(logger, "{}: failed to decompress package, seqn={}", this->id, seqn);
+		return -1;
+	}
+	return original_len;
+}
+
+bool SocketWire::Base::accept_package(sequence_number_t seqn) const
+{
+	// never a blocking send from the receiving side: both counterparts could wait for each other to read
+	queue_ack(seqn);
+	if (seqn <= max_received_seqn && seqn != 1)
+	{
+		return false;
+	}
+	max_received_seqn = seqn;
+	return true;
+}
+
 bool SocketWire::Base::read_and_dispatch_message() const
 {
-	sz = (sz == -1 ? receive_pkg.read_integral<int32_t>() : sz);
 	if (sz == -1)
 	{
-		logger->debug("{}: sz == -1", this->id);
-		return false;
+		sz = receive_pkg.read_integral<int32_t>();
+		if (sz == -1)
+		{
+			RD_LOG_DEBUG(logger, "{}: sz == -1", this->id);
+			return false;
+		}
+		message.set_compact((sz & COMPACT_MESSAGE_FLAG) != 0);
+		sz &= ~COMPACT_MESSAGE_FLAG;
 	}
 	id_ = (id_ == -1 ? receive_pkg.read_integral<RdId::hash_t>() : id_);
 	if (id_ == -1)
 	{
-		logger->error("id == -1");
+		RD_LOG_ERROR(logger, "id == -1");
 		return false;
 	}
-	logger->trace("{}: message info: sz={}, id={}", this->id, sz, id_);
+	RD_LOG_TRACE(logger, "{}: message info: sz={}, id={}", this->id, sz, id_);
 	const RdId rd_id{id_};
 	sz -= 8;	// RdId
 	message.require_available(sz);
 
 	if (!receive_pkg.read(message.data() + message.get_position(), sz - message.get_position()))
 	{
-		logger->error("{}: constructing message failed", this->id);
+		RD_LOG_ERROR(logger, "{}: constructing message failed", this->id);
 		return false;
 	}
 
-	logger->debug("{}: message received", this->id);
+	RD_LOG_TRACE(logger, "{}: message received", this->id);
+	metrics.on_message_received();
 	message_broker.dispatch(rd_id, std::move(message));
-	logger->debug("{}: message dispatched", this->id);
+	RD_LOG_TRACE(logger, "{}: message dispatched", this->id);
 
 	sz = -1;
 	id_ = -1;
@@ -368,6 +731,187 @@ bool SocketWire::Base::read_and_dispatch_message() const
 	//		RD_ASSERT_MSG(summary_size == sz, "Broken message, read:%d bytes, expected:%d bytes", summary_size, sz)
 }
 
+bool SocketWire::Base::receive_from_reactor() const
+{
+	// a connection which keeps sending mustn't starve the other ones, the rest is reported again by the reactor
+	constexpr int MAX_READS_PER_EVENT = 4;
+	MessageBroker::BatchScope batch(message_broker);
+	for (int i = 0; i < MAX_READS_PER_EVENT; ++i)
+	{
+		// only an incomplete header may be left over by decode_received
+		hi = std::copy(lo, hi, receiver_buffer.begin());
+		lo = receiver_buffer.begin();
+
+		const auto capacity = static_cast<size_t>(receiver_buffer.end() - hi);
+		const int32_t read = SocketReactor::receive(socket_provider->GetSocketDescriptor(), &*hi, capacity);
+		if (read == SocketReactor::WOULD_BLOCK)
+		{
+			return true;
+		}
+		if (read == 0)
+		{
+			RD_LOG_INFO(logger, "{}: socket was shut down for receiving", this->id);
+			return false;
+		}
+		if (read < 0)
+		{
+			RD_LOG_ERROR(logger, "{}: error has occurred while receiving", this->id);
+			return false;
+		}
+		RD_LOG_TRACE(logger, "{}: receive finished: {} bytes read", this->id, read);
+		hi += read;
+		if (!decode_received())
+		{
+			return false;
+		}
+		if (static_cast<size_t>(read) < capacity)
+		{
+			return true;
+		}
+	}
+	return true;
+}
+
+bool SocketWire::Base::decode_received() const
+{
+	auto& state = reactor_state;
+	while (true)
+	{
+		if (state.in_package)
+		{
+			const int32_t copylen = (std::min)(state.package_size - state.package_filled, static_cast<int32_t>(hi - lo));
+			std::copy(lo, lo + copylen, state.package_target + state.package_filled);
+			lo += copylen;
+			state.package_filled += copylen;
+			if (state.package_filled < state.package_size)
+			{
+				return true;
+			}
+
+			state.in_package = false;
+			const int32_t len = unpack_package(state.package_len, state.package_seqn);
+			if (len < 0)
+			{
+				return false;
+			}
+			if (!accept_package(state.package_seqn))
+			{
+				continue;
+			}
+			RD_LOG_TRACE(logger, "{}: was received package, bytes={}, seqn={}", this->id, len, state.package_seqn);
+			if (!dispatch_payload(len))
+			{
+				return false;
+			}
+			continue;
+		}
+
+		// ping is as long as a header: length and two timestamps
+		if (hi - lo < PACKAGE_HEADER_LENGTH)
+		{
+			return true;
+		}
+		int32_t len = 0;
+		std::memcpy(&len, &*lo, sizeof(len));
+		if (len == PING_MESSAGE_LENGTH)
+		{
+			int32_t received_timestamp = 0;
+			int32_t received_counterpart_timestamp = 0;
+			std::memcpy(&received_timestamp, &*lo + sizeof(len), sizeof(received_timestamp));
+			std::memcpy(&received_counterpart_timestamp, &*lo + sizeof(len) + sizeof(received_timestamp),
+				sizeof(received_counterpart_timestamp));
+			lo += PACKAGE_HEADER_LENGTH;
+			on_ping(received_timestamp, received_counterpart_timestamp);
+			continue;
+		}
+		sequence_number_t seqn = 0;
+		std::memcpy(&seqn, &*lo + sizeof(len), sizeof(seqn));
+		lo += PACKAGE_HEADER_LENGTH;
+		if (on_control_header(len, seqn))
+		{
+			continue;
+		}
+
+		RD_LOG_TRACE(logger, "{}: read len={}, seqn={}, max_received_seqn={}", this->id, len, seqn, max_received_seqn);
+		state.package_len = len;
+		state.package_seqn = seqn;
+		state.package_filled = 0;
+		if ((len & COMPRESSED_PACKAGE_FLAG) != 0)
+		{
+			state.package_size = len & ~COMPRESSED_PACKAGE_FLAG;
+			receive_compression_buffer.resize(state.package_size);
+			state.package_target = receive_compression_buffer.data();
+		}
+		else if (len >= 0)
+		{
+			state.package_size = len;
+			receive_pkg.rewind();
+			receive_pkg.require_available(len);
+			state.package_target = receive_pkg.data();
+		}
+		else
+		{
+			RD_LOG_ERROR(logger, "{}: invalid package length: {}", this->id, len);
+			return false;
+		}
+		state.in_package = true;
+	}
+}
+
+bool SocketWire::Base::dispatch_payload(int32_t len) const
+{
+	auto& state = reactor_state;
+	Buffer::word_t const* ptr = receive_pkg.data();
+	Buffer::word_t const* const end = ptr + len;
+	while (true)
+	{
+		// messages may span packages, what is left of this one waits for the next
+		if (state.message_header_filled < state.message_header.size())
+		{
+			const size_t copylen = (std::min)(state.message_header.size() - state.message_header_filled, static_cast<size_t>(end - ptr));
+			std::copy(ptr, ptr + copylen, state.message_header.data() + state.message_header_filled);
+			ptr += copylen;
+			state.message_header_filled += copylen;
+			if (state.message_header_filled < state.message_header.size())
+			{
+				return true;
+			}
+
+			int32_t sz_with_id = 0;
+			std::memcpy(&sz_with_id, state.message_header.data(), sizeof(sz_with_id));
+			std::memcpy(&state.message_id, state.message_header.data() + sizeof(sz_with_id), sizeof(state.message_id));
+			const bool compact = (sz_with_id & COMPACT_MESSAGE_FLAG) != 0;
+			sz_with_id &= ~COMPACT_MESSAGE_FLAG;
+			RD_LOG_TRACE(logger, "{}: message info: sz={}, id={}", this->id, sz_with_id, state.message_id);
+			if (sz_with_id < static_cast<int32_t>(sizeof(RdId::hash_t)))
+			{
+				RD_LOG_ERROR(logger, "{}: invalid message size: {}", this->id, sz_with_id);
+				return false;
+			}
+			state.message_size = sz_with_id - static_cast<int32_t>(sizeof(RdId::hash_t));
+			state.message_filled = 0;
+			message.rewind();
+			message.set_compact(compact);
+			message.require_available(state.message_size);
+		}
+
+		const int32_t copylen = (std::min)(state.message_size - state.message_filled, static_cast<int32_t>(end - ptr));
+		std::copy(ptr, ptr + copylen, message.data() + state.message_filled);
+		ptr += copylen;
+		state.message_filled += copylen;
+		if (state.message_filled < state.message_size)
+		{
+			return true;
+		}
+
+		metrics.on_message_received();
+		message_broker.dispatch(RdId{state.message_id}, std::move(message));
+		RD_LOG_TRACE(logger, "{}: message dispatched", this->id);
+		message.rewind();
+		state.message_header_filled = 0;
+	}
+}
+
 CSimpleSocket* SocketWire::Base::get_socket_provider() const
 {
 	return socket_provider.get();
@@ -379,7 +923,7 @@ void SocketWire::Base::ping() const
 	{
 		if (heartbeatAlive.get())
 		{	 // only on change
-			logger->trace(
+			RD_LOG_TRACE(logger, 
 				"Disconnect detected while sending PING {}: "
 				"current_timestamp: {}, "
 				"counterpart_timestamp: {}, "
@@ -387,6 +931,7 @@ void SocketWire::Base::ping() const
 				this->id, current_timestamp, counterpart_timestamp, counterpart_acknowledge_timestamp);
 		}
 		heartbeatAlive.set(false);
+		metrics.on_heartbeat_missed();
 	}
 	try
 	{
@@ -394,38 +939,96 @@ void SocketWire::Base::ping() const
 		ping_pkg_header.write_integral(current_timestamp);
 		ping_pkg_header.write_integral(counterpart_timestamp);
 		{
-			std::lock_guard<decltype(socket_send_lock)> guard(socket_send_lock);
+			// pings of all wires share the timer thread, don't stall it behind a large package being written,
+			// the package proves liveness just as well
+			std::unique_lock<decltype(socket_send_lock)> guard(socket_send_lock, std::try_to_lock);
+			if (!guard.owns_lock())
+			{
+				RD_LOG_TRACE(logger, "{}: ping skipped, socket is busy sending", this->id);
+				return;
+			}
 			int32_t sent = socket_provider->Send(ping_pkg_header.data(), ping_pkg_header.get_position());
 			if (sent == 0 && !socket_provider->IsSocketValid())
 			{
-				logger->debug("{}: failed to send ping over the network, reason: socket was shut down for sending", this->id);
+				RD_LOG_DEBUG(logger, "{}: failed to send ping over the network, reason: socket was shut down for sending", this->id);
 				return;
 			}
 			RD_ASSERT_THROW_MSG(sent == PACKAGE_HEADER_LENGTH,
 				fmt::format("{}: failed to send ping over the network, reason: {}", this->id, socket_provider->DescribeError()))
+			flush_pending_ack(false);
 		}
 
 		++current_timestamp;
 	}
 	catch (std::exception const& e)
 	{
-		logger->warn("{}: exception raised during PING | {}", this->id, e.what());
+		RD_LOG_WARN(logger, "{}: exception raised during PING | {}", this->id, e.what());
+	}
+}
+
+void SocketWire::Base::queue_ack(sequence_number_t seqn) const
+{
+	pending_ack = seqn;
+	// the sender holding the lock may be blocked by the counterpart which waits for this very thread to read
+	std::unique_lock<decltype(socket_send_lock)> guard(socket_send_lock, std::try_to_lock);
+	if (guard.owns_lock())
+	{
+		flush_pending_ack(false);
+	}
+}
+
+void SocketWire::Base::flush_pending_ack(bool blocking) const
+{
+	const sequence_number_t seqn = pending_ack.exchange(0);
+	if (seqn == 0)
+	{
+		return;
+	}
+	RD_LOG_TRACE(logger, "{} send ack {}", id, seqn);
+	std::array<Buffer::word_t, PACKAGE_HEADER_LENGTH> frame{};
+	std::memcpy(frame.data(), &ACK_MESSAGE_LENGTH, sizeof(ACK_MESSAGE_LENGTH));
+	std::memcpy(frame.data() + sizeof(ACK_MESSAGE_LENGTH), &seqn, sizeof(seqn));
+
+	int32_t sent = 0;
+	// an upgraded connection, e.g. shared memory, has no descriptor of its own to write to, only its provider can send
+	if (!blocking && !upgrade_connection)
+	{
+		sent = SocketReactor::send(socket_provider->GetSocketDescriptor(), frame.data(), frame.size());
+		if (sent == SocketReactor::WOULD_BLOCK)
+		{
+			// unless a newer one has been queued meanwhile
+			sequence_number_t expected = 0;
+			pending_ack.compare_exchange_strong(expected, seqn);
+			return;
+		}
+		if (sent < 0)
+		{
+			RD_LOG_WARN(logger, "{}: failed to send ack over the network, seqn = {}", id, seqn);
+			return;
+		}
+	}
+	// the rest of a partially written frame can't wait, the next package would interleave with it
+	const int32_t rest = static_cast<int32_t>(frame.size()) - sent;
+	if (rest > 0 && socket_provider->Send(frame.data() + sent, rest) != rest)
+	{
+		RD_LOG_WARN(logger, "{}: failed to send ack over the network, seqn = {}, reason: {}", id, seqn,
+			socket_provider->DescribeError());
 	}
 }
 
-bool SocketWire::Base::send_ack(sequence_number_t seqn) const
+bool SocketWire::Base::send_handshake() const
 {
-	logger->trace("{} send ack {}", id, seqn);
 	try
 	{
-		ack_buffer.rewind();
-		ack_buffer.write_integral(ACK_MESSAGE_LENGTH);
-		ack_buffer.write_integral(seqn);
+		handshake_buffer.rewind();
+		handshake_buffer.write_integral(HANDSHAKE_MESSAGE_LENGTH);
+		handshake_buffer.write_integral(local_capabilities);
 		{
 			std::lock_guard<decltype(socket_send_lock)> guard(socket_send_lock);
-			RD_ASSERT_THROW_MSG(socket_provider->Send(ack_buffer.data(), ack_buffer.get_position()) == PACKAGE_HEADER_LENGTH,
+			RD_ASSERT_THROW_MSG(
+				socket_provider->Send(handshake_buffer.data(), handshake_buffer.get_position()) == PACKAGE_HEADER_LENGTH,
 				this->id +
-					": failed to send ack over the network"
+					": failed to send handshake over the network"
 					", reason: " +
 					socket_provider->DescribeError())
 		}
@@ -433,11 +1036,22 @@ bool SocketWire::Base::send_ack(sequence_number_t seqn) const
 	}
 	catch (std::exception const& e)
 	{
-		logger->warn("{}: exception raised during ACK, seqn = {} | {}", id, seqn, e.what());
+		RD_LOG_WARN(logger, "{}: exception raised during HANDSHAKE | {}", id, e.what());
 		return false;
 	}
 }
 
+void SocketWire::Base::enable_compression(int32_t threshold)
+{
+	compression_threshold = threshold;
+	local_capabilities |= CAPABILITY_COMPRESSION;
+}
+
+void SocketWire::Base::enable_compact_encoding()
+{
+	local_capabilities |= CAPABILITY_COMPACT_ENCODING;
+}
+
 bool SocketWire::Base::try_shutdown_connection() const
 {
 	auto s = get_socket_provider();
@@ -447,100 +1061,189 @@ bool SocketWire::Base::try_shutdown_connection() const
 	return s->Shutdown(CSimpleSocket::Both);
 }
 
-SocketWire::Client::Client(Lifetime parentLifetime, IScheduler* scheduler, uint16_t port, const std::string& id)
+SocketWire::IoMode SocketWire::Base::get_io_mode() const
+{
+	return io_mode;
+}
+
+SocketWire::Client::Client(
+	Lifetime parentLifetime, IScheduler* scheduler, uint16_t port, const std::string& id, IoMode io_mode)
+	: Client(parentLifetime, scheduler, port, id, connection_upgrade_t{}, io_mode)
+{
+}
+
+SocketWire::Client::Client(Lifetime parentLifetime, IScheduler* scheduler, uint16_t port, const std::string& id,
+	connection_upgrade_t upgrade_connection, IoMode io_mode)
 	: Base(id, parentLifetime, scheduler), port(port), clientLifetimeDefinition(parentLifetime)
 {
+	this->upgrade_connection = std::move(upgrade_connection);
+	set_io_mode(io_mode);
 	Lifetime lifetime = clientLifetimeDefinition.lifetime;
-	thread = std::thread([this, lifetime]() mutable {
-		rd::util::set_thread_name(this->id.empty() ? "SocketWire::Client Thread" : this->id.c_str());
+	reconnect_delay = timeout;
+	if (this->io_mode == IoMode::Reactor)
+	{
+		connect_in_reactor(lifetime, std::chrono::milliseconds::zero());
+	}
+	else
+	{
+		thread = std::thread([this, lifetime]() mutable {
+			rd::util::set_thread_name(this->id.empty() ? "SocketWire::Client Thread" : this->id.c_str());
 
-		try
-		{
-			while (!lifetime->is_terminated())
+			try
 			{
-				try
+				while (!lifetime->is_terminated())
 				{
-					socket = std::make_shared<CActiveSocket>();
-					RD_ASSERT_THROW_MSG(socket->Initialize(),
-						fmt::format("{}: failed to init ActiveSocket, reason: {}", this->id, socket->DescribeError()));
-					RD_ASSERT_THROW_MSG(socket->DisableNagleAlgoritm(),
-						fmt::format("{}: failed to DisableNagleAlgoritm, reason: {}", this->id, socket->DescribeError()));
-
-					// On windows connect will try to send SYN 3 times with interval of 500ms (total time is 1second)
-					// Connect timeout doesn't work if it's more than 1 second. But we don't need it because we can close socket any
-					// moment.
-
-					// https://stackoverflow.com/questions/22417228/prevent-tcp-socket-connection-retries
-					// HKLM\SYSTEM\CurrentControlSet\Services\Tcpip\Parameters\TcpMaxConnectRetransmissions
-					logger->info("{}: connecting 127.0.0.1: {}", this->id, this->port);
-					RD_ASSERT_THROW_MSG(socket->Open("127.0.0.1", this->port),
-						fmt::format("{}: failed to open ActiveSocket, reason: {}", this->id, socket->DescribeError()));
+					try
 					{
-						std::lock_guard<decltype(lock)> guard(lock);
-						if (lifetime->is_terminated())
+						socket = std::make_shared<CActiveSocket>();
+						RD_ASSERT_THROW_MSG(socket->Initialize(),
+							fmt::format("{}: failed to init ActiveSocket, reason: {}", this->id, socket->DescribeError()));
+						RD_ASSERT_THROW_MSG(socket->DisableNagleAlgoritm(),
+							fmt::format("{}: failed to DisableNagleAlgoritm, reason: {}", this->id, socket->DescribeError()));
+
+						// On windows connect will try to send SYN 3 times with interval of 500ms (total time is 1second)
+						// Connect timeout doesn't work if it's more than 1 second. But we don't need it because we can close socket any
+						// moment.
+
+						// https://stackoverflow.com/questions/22417228/prevent-tcp-socket-connection-retries
+						// HKLM\SYSTEM\CurrentControlSet\Services\Tcpip\Parameters\TcpMaxConnectRetransmissions
+						RD_LOG_INFO(logger, "{}: connecting 127.0.0.1: {}", this->id, this->port);
+						RD_ASSERT_THROW_MSG(socket->Open("127.0.0.1", this->port),
+							fmt::format("{}: failed to open ActiveSocket, reason: {}", this->id, socket->DescribeError()));
 						{
-							if (!socket->Close())
+							std::lock_guard<decltype(lock)> guard(lock);
+							if (lifetime->is_terminated())
 							{
-								logger->error("{} failed to close socket, reason: {}", this->id, socket->DescribeError());
+								if (!socket->Close())
+								{
+									RD_LOG_ERROR(logger, "{} failed to close socket, reason: {}", this->id, socket->DescribeError());
+								}
+								return;
 							}
-							return;
 						}
-					}
 
-					set_socket_provider(socket);
-				}
-				catch (std::exception const& e)
-				{
-					(void) e;
-					std::lock_guard<decltype(lock)> guard(lock);
-					bool should_reconnect = false;
-					if (!lifetime->is_terminated())
-					{
-						cv.wait_for(lock, timeout);
-						should_reconnect = !lifetime->is_terminated();
+						set_socket_provider(upgrade(socket));
+						reconnect_delay = timeout;
 					}
-					if (should_reconnect)
+					catch (std::exception const& e)
 					{
-						continue;
+						(void) e;
+						if (!wait_before_reconnect(lifetime, reconnect_delay))
+						{
+							break;
+						}
+						reconnect_delay = (std::min)(reconnect_delay * 2, max_reconnect_delay);
 					}
-					break;
 				}
 			}
-		}
-		catch (std::exception const& e)
-		{
-			logger->info("{}: closed with exception: {}", this->id, e.what());
-		}
-		logger->debug("{}: thread expired", this->id);
-	});
+			catch (std::exception const& e)
+			{
+				RD_LOG_INFO(logger, "{}: closed with exception: {}", this->id, e.what());
+			}
+			RD_LOG_DEBUG(logger, "{}: thread expired", this->id);
+		});
+	}
 
 	lifetime->add_action([this]() {
-		logger->info("{}: starts terminating lifetime", this->id);
+		RD_LOG_INFO(logger, "{}: starts terminating lifetime", this->id);
 
 		const bool send_buffer_stopped = async_send_buffer.stop(timeout);
-		logger->debug("{}: send buffer stopped, success: {}", this->id, send_buffer_stopped);
+		RD_LOG_DEBUG(logger, "{}: send buffer stopped, success: {}", this->id, send_buffer_stopped);
 
 		{
 			std::lock_guard<decltype(lock)> guard(lock);
-			logger->debug("{}: closing socket", this->id);
+			RD_LOG_DEBUG(logger, "{}: closing socket", this->id);
 
 			if (socket != nullptr)
 			{
 				if (!socket->Close())
 				{
-					logger->error("{}: failed to close socket", this->id);
+					RD_LOG_ERROR(logger, "{}: failed to close socket", this->id);
 				}
 			}
 		}
 		cv.notify_all();
 
-		logger->debug("{}: waiting for receiver thread", this->id);
-		logger->debug("{}: is thread joinable? {}", this->id, thread.joinable());
-		thread.join();
-		logger->info("{}: termination finished", this->id);
+		RD_LOG_DEBUG(logger, "{}: waiting for receiver thread", this->id);
+		RD_LOG_DEBUG(logger, "{}: is thread joinable? {}", this->id, thread.joinable());
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+		{
+			// the counterpart may have closed the connection at the same time, its handler is finishing
+			std::lock_guard<decltype(reactor_lock)> reactor_guard(reactor_lock);
+		}
+		RD_LOG_INFO(logger, "{}: termination finished", this->id);
 	});
 }
 
+void SocketWire::Client::connect_in_reactor(Lifetime lifetime, std::chrono::milliseconds delay)
+{
+	TimerWheel::Instance().schedule(lifetime, delay, [this, lifetime] {
+		try
+		{
+			auto connecting = std::make_shared<CActiveSocket>();
+			RD_ASSERT_THROW_MSG(connecting->Initialize(),
+				fmt::format("{}: failed to init ActiveSocket, reason: {}", this->id, connecting->DescribeError()));
+			RD_ASSERT_THROW_MSG(connecting->DisableNagleAlgoritm(),
+				fmt::format("{}: failed to DisableNagleAlgoritm, reason: {}", this->id, connecting->DescribeError()));
+
+			// connecting to localhost is either accepted or refused right away, so it doesn't hold the timer thread
+			RD_LOG_INFO(logger, "{}: connecting 127.0.0.1: {}", this->id, this->port);
+			RD_ASSERT_THROW_MSG(connecting->Open("127.0.0.1", this->port),
+				fmt::format("{}: failed to open ActiveSocket, reason: {}", this->id, connecting->DescribeError()));
+
+			std::lock_guard<decltype(reactor_lock)> reactor_guard(reactor_lock);
+			{
+				std::lock_guard<decltype(lock)> guard(lock);
+				if (lifetime->is_terminated())
+				{
+					if (!connecting->Close())
+					{
+						RD_LOG_ERROR(logger, "{} failed to close socket, reason: {}", this->id, connecting->DescribeError());
+					}
+					return;
+				}
+				socket = connecting;
+			}
+
+			reconnect_delay = timeout;
+			attach_to_reactor(lifetime, socket, [this, lifetime] { connect_in_reactor(lifetime, std::chrono::milliseconds::zero()); });
+			return;
+		}
+		catch (std::exception const& e)
+		{
+			RD_LOG_DEBUG(logger, "{}: connection failed, retrying in {}ms | {}", this->id, reconnect_delay.count(), e.what());
+		}
+		const auto retry_delay = reconnect_delay;
+		reconnect_delay = (std::min)(retry_delay * 2, max_reconnect_delay);
+		connect_in_reactor(lifetime, retry_delay);
+	});
+}
+
+bool SocketWire::Client::wait_before_reconnect(Lifetime lifetime, std::chrono::milliseconds delay)
+{
+	bool due = false;
+	// nested definition cancels the timer when the wait is over or the client is terminated
+	LifetimeDefinition wait_definition(lifetime);
+	TimerWheel::Instance().schedule(wait_definition.lifetime, delay, [this, &due] {
+		{
+			std::lock_guard<decltype(lock)> guard(lock);
+			due = true;
+		}
+		cv.notify_all();
+	});
+	{
+		std::unique_lock<decltype(lock)> guard(lock);
+		cv.wait(guard, [&due, &lifetime] { return due || lifetime->is_terminated(); });
+	}
+	const bool should_reconnect = !lifetime->is_terminated();
+	// outside of [lock]: termination waits for the timer action which takes it
+	wait_definition.terminate();
+	return should_reconnect;
+}
+
 SocketWire::Client::~Client()
 {
 	if (!clientLifetimeDefinition.is_terminated())
@@ -549,9 +1252,18 @@ SocketWire::Client::~Client()
 	}
 }
 
-SocketWire::Server::Server(Lifetime parentLifetime, IScheduler* scheduler, uint16_t port, const std::string& id)
+SocketWire::Server::Server(
+	Lifetime parentLifetime, IScheduler* scheduler, uint16_t port, const std::string& id, IoMode io_mode)
+	: Server(parentLifetime, scheduler, port, id, connection_upgrade_t{}, io_mode)
+{
+}
+
+SocketWire::Server::Server(Lifetime parentLifetime, IScheduler* scheduler, uint16_t port, const std::string& id,
+	connection_upgrade_t upgrade_connection, IoMode io_mode)
 	: Base(id, parentLifetime, scheduler), ss(std::make_unique<CPassiveSocket>()), serverLifetimeDefinition(parentLifetime)
 {
+	this->upgrade_connection = std::move(upgrade_connection);
+	set_io_mode(io_mode);
 #ifdef SIGPIPE
 	signal(SIGPIPE, SIG_IGN);
 #endif
@@ -562,87 +1274,159 @@ SocketWire::Server::Server(Lifetime parentLifetime, IScheduler* scheduler, uint1
 	this->port = ss->GetServerPort();
 	RD_ASSERT_MSG(this->port != 0, fmt::format("{}: port wasn't chosen", this->id));
 
-	logger->info("{}: listening 127.0.0.1/{}", this->id, this->port);
+	RD_LOG_INFO(logger, "{}: listening 127.0.0.1/{}", this->id, this->port);
 	Lifetime lifetime = serverLifetimeDefinition.lifetime;
 
-	thread = std::thread([this, lifetime]() mutable {
-		rd::util::set_thread_name(this->id.empty() ? "SocketWire::Server Thread" : this->id.c_str());
+	if (this->io_mode == IoMode::Reactor)
+	{
+		listen_in_reactor(lifetime);
+	}
+	else
+	{
+		thread = std::thread([this, lifetime]() mutable {
+			rd::util::set_thread_name(this->id.empty() ? "SocketWire::Server Thread" : this->id.c_str());
 
-		while (!lifetime->is_terminated())
-		{
-			try
+			while (!lifetime->is_terminated())
 			{
-				logger->info("{}: accepting started", this->id);
+				try
+				{
+					RD_LOG_INFO(logger, "{}: accepting started", this->id);
 				
-				// [HACK]: Fix RIDER-51111.
-				// winsock blocking accept hangs after creating new process with createprocess with inheritHandles=true
-				// property. Unreal Engine uses the same logic for handling sockets where they wait for timeout on select
-				// before trying to accept connection.
-				while(ss->IsSocketValid() && !ss->Select(0, 300)){}
+					// [HACK]: Fix RIDER-51111.
+					// winsock blocking accept hangs after creating new process with createprocess with inheritHandles=true
+					// property. Unreal Engine uses the same logic for handling sockets where they wait for timeout on select
+					// before trying to accept connection.
+					while(ss->IsSocketValid() && !ss->Select(0, 300)){}
 				
-				CActiveSocket* accepted = ss->Accept();
-				RD_ASSERT_THROW_MSG(
-					accepted != nullptr, fmt::format("{}: accepting failed, reason: {}", this->id, ss->DescribeError()));
-				socket.reset(accepted);
-				logger->info("{}: accepted passive socket {}/{}", this->id, socket->GetClientAddr(), socket->GetClientPort());
-				RD_ASSERT_THROW_MSG(socket->DisableNagleAlgoritm(),
-					fmt::format("{}: tcpNoDelay failed, reason: {}", this->id, socket->DescribeError()));
+					CActiveSocket* accepted = ss->Accept();
+					RD_ASSERT_THROW_MSG(
+						accepted != nullptr, fmt::format("{}: accepting failed, reason: {}", this->id, ss->DescribeError()));
+					socket.reset(accepted);
+					RD_LOG_INFO(logger, "{}: accepted passive socket {}/{}", this->id, socket->GetClientAddr(), socket->GetClientPort());
+					RD_ASSERT_THROW_MSG(socket->DisableNagleAlgoritm(),
+						fmt::format("{}: tcpNoDelay failed, reason: {}", this->id, socket->DescribeError()));
 
-				{
-					std::lock_guard<decltype(lock)> guard(lock);
-					if (lifetime->is_terminated())
 					{
-						logger->debug("{}: closing passive socket", this->id);
-						if (!socket->Close())
+						std::lock_guard<decltype(lock)> guard(lock);
+						if (lifetime->is_terminated())
 						{
-							logger->error("{}: failed to close socket", this->id);
+							RD_LOG_DEBUG(logger, "{}: closing passive socket", this->id);
+							if (!socket->Close())
+							{
+								RD_LOG_ERROR(logger, "{}: failed to close socket", this->id);
+							}
+							RD_LOG_INFO(logger, "{}: close passive socket", this->id);
 						}
-						logger->info("{}: close passive socket", this->id);
 					}
-				}
 
-				logger->debug("{}: setting socket provider", this->id);
-				set_socket_provider(socket);
-			}
-			catch (std::exception const& e)
-			{
-				logger->info("{}: closed with exception: {}", this->id, e.what());
+					RD_LOG_DEBUG(logger, "{}: setting socket provider", this->id);
+					set_socket_provider(upgrade(socket));
+				}
+				catch (std::exception const& e)
+				{
+					RD_LOG_INFO(logger, "{}: closed with exception: {}", this->id, e.what());
+				}
 			}
-		}
-		logger->debug("{}: thread expired", this->id);
-	});
+			RD_LOG_DEBUG(logger, "{}: thread expired", this->id);
+		});
+	}
 
 	lifetime->add_action([this] {
-		logger->info("{}: start terminating lifetime", this->id);
+		RD_LOG_INFO(logger, "{}: start terminating lifetime", this->id);
 
 		const bool send_buffer_stopped = async_send_buffer.stop(timeout);
-		logger->debug("{}: send buffer stopped, success: {}", this->id, send_buffer_stopped);
+		RD_LOG_DEBUG(logger, "{}: send buffer stopped, success: {}", this->id, send_buffer_stopped);
 
-		logger->debug("{}: closing server socket", this->id);
+		RD_LOG_DEBUG(logger, "{}: closing server socket", this->id);
 		if (!ss->Close())
 		{
-			logger->error("{}: failed to close server socket", this->id);
+			RD_LOG_ERROR(logger, "{}: failed to close server socket", this->id);
 		}
 
 		{
 			std::lock_guard<decltype(lock)> guard(lock);
-			logger->debug("{}: closing socket", this->id);
+			RD_LOG_DEBUG(logger, "{}: closing socket", this->id);
 			if (socket != nullptr)
 			{
 				if (!socket->Close())
 				{
-					logger->error("{}: failed to close socket", this->id);
+					RD_LOG_ERROR(logger, "{}: failed to close socket", this->id);
 				}
 			}
 		}
 
-		logger->debug("{}: waiting for receiver thread", this->id);
-		logger->debug("{}: is thread joinable? {}", this->id, thread.joinable());
-		thread.join();
-		logger->info("{}: termination finished", this->id);
+		RD_LOG_DEBUG(logger, "{}: waiting for receiver thread", this->id);
+		RD_LOG_DEBUG(logger, "{}: is thread joinable? {}", this->id, thread.joinable());
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+		{
+			// the counterpart may have closed the connection at the same time, its handler is finishing
+			std::lock_guard<decltype(reactor_lock)> reactor_guard(reactor_lock);
+		}
+		RD_LOG_INFO(logger, "{}: termination finished", this->id);
+	});
+}
+
+void SocketWire::Server::listen_in_reactor(Lifetime lifetime)
+{
+	try
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		if (lifetime->is_terminated())
+		{
+			return;
+		}
+		accept_definition = std::make_unique<LifetimeDefinition>(lifetime);
+	}
+	catch (std::invalid_argument const&)
+	{
+		return;	   // terminated concurrently
+	}
+	RD_LOG_INFO(logger, "{}: accepting started", this->id);
+	SocketReactor::Instance().add(accept_definition->lifetime, ss->GetSocketDescriptor(), [this, lifetime] {
+		std::lock_guard<decltype(reactor_lock)> guard(reactor_lock);
+		accept_in_reactor(lifetime);
 	});
 }
 
+void SocketWire::Server::accept_in_reactor(Lifetime lifetime)
+{
+	std::shared_ptr<CActiveSocket> accepted(ss->Accept());
+	if (accepted == nullptr)
+	{
+		RD_LOG_INFO(logger, "{}: accepting failed, reason: {}", this->id, ss->DescribeError());
+		return;
+	}
+	RD_LOG_INFO(logger, "{}: accepted passive socket {}/{}", this->id, accepted->GetClientAddr(), accepted->GetClientPort());
+	if (!accepted->DisableNagleAlgoritm())
+	{
+		RD_LOG_INFO(logger, "{}: tcpNoDelay failed, reason: {}", this->id, accepted->DescribeError());
+		accepted->Close();
+		return;
+	}
+
+	{
+		std::lock_guard<decltype(lock)> guard(lock);
+		if (lifetime->is_terminated())
+		{
+			RD_LOG_DEBUG(logger, "{}: closing passive socket", this->id);
+			if (!accepted->Close())
+			{
+				RD_LOG_ERROR(logger, "{}: failed to close socket", this->id);
+			}
+			return;
+		}
+		socket = accepted;
+	}
+
+	// one connection at a time: the listening socket is registered again once this one is closed
+	accept_definition->terminate();
+	RD_LOG_DEBUG(logger, "{}: setting socket provider", this->id);
+	attach_to_reactor(lifetime, socket, [this, lifetime] { listen_in_reactor(lifetime); });
+}
+
 SocketWire::Server::~Server()
 {
 	if (!serverLifetimeDefinition.is_terminated())
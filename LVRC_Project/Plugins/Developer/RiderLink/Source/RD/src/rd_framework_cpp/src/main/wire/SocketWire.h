@@ -10,9 +10,11 @@
 #include "base/WireBase.h"
 #include "ByteBufferAsyncProcessor.h"
 #include "PkgInputStream.h"
+#include "WireMetrics.h"
 
 #include <string>
 #include <array>
+#include <atomic>
 #include <condition_variable>
 
 #include <rd_framework_export.h>
@@ -28,6 +30,18 @@ class RD_FRAMEWORK_API SocketWire
 	static std::chrono::milliseconds timeout;
 
 public:
+	/**
+	 * \brief How a wire waits for incoming data. [Thread]: the wire blocks a thread of its own in accept and receive.
+	 * [Reactor]: the shared [SocketReactor] thread accepts and receives for all such wires without blocking, connection
+	 * attempts of a client are scheduled on the [TimerWheel]. Sending is the same in both modes.
+	 * Reactor is available on Linux only and not for wires which upgrade connections, they fall back to [Thread].
+	 */
+	enum class IoMode
+	{
+		Thread,
+		Reactor
+	};
+
 	class RD_FRAMEWORK_API Base : public WireBase
 	{
 	protected:
@@ -35,7 +49,7 @@ public:
 
 		std::timed_mutex lock;
 		mutable std::mutex socket_send_lock;
-		mutable std::mutex wire_send_lock;
+		mutable std::recursive_mutex wire_send_lock;
 
 		std::thread thread{};
 
@@ -55,11 +69,44 @@ public:
 
 		static constexpr size_t SEND_BUFFER_SIZE = 16 * 1024;
 		mutable Buffer local_send_buffer;
+		mutable bool writing_message = false;
+
+		// a batch is sent as soon as it grows larger, so it doesn't hold the window and the counterpart's reader for long
+		static constexpr size_t SEND_BATCH_MAX_BYTES = 64 * 1024;
+		// the batch is filled and sent only by [send_batch_thread], see [IWire::SendBatch]
+		mutable std::atomic<std::thread::id> send_batch_thread{};
+		mutable Buffer send_batch_buffer;
 
 		static constexpr int32_t ACK_MESSAGE_LENGTH = -1;
 		static constexpr int32_t PING_MESSAGE_LENGTH = -2;
+		static constexpr int32_t HANDSHAKE_MESSAGE_LENGTH = -3;
 		static constexpr int32_t PACKAGE_HEADER_LENGTH = sizeof(ACK_MESSAGE_LENGTH) + sizeof(sequence_number_t);
-		mutable Buffer ack_buffer{PACKAGE_HEADER_LENGTH};
+
+		/**
+		 * \brief Set in the length of a package header if the package body is compressed.
+		 */
+		static constexpr int32_t COMPRESSED_PACKAGE_FLAG = 1 << 30;
+
+		/**
+		 * \brief Set in the length of a message if its payload is written in compact encoding, see [Buffer::is_compact].
+		 */
+		static constexpr int32_t COMPACT_MESSAGE_FLAG = 1 << 30;
+
+		/**
+		 * \brief Bits of the handshake which is sent right after connect, in place of sequence number.
+		 * Handshake is sent only if at least one capability is enabled, so peers without capabilities stay compatible.
+		 */
+		using capabilities_t = int64_t;
+		static constexpr capabilities_t CAPABILITY_COMPRESSION = 1;
+		static constexpr capabilities_t CAPABILITY_COMPACT_ENCODING = 2;
+
+		capabilities_t local_capabilities = 0;
+		mutable std::atomic<capabilities_t> counterpart_capabilities{0};
+		mutable Buffer handshake_buffer{PACKAGE_HEADER_LENGTH};
+
+		int32_t compression_threshold = 0;
+		mutable Buffer::ByteArray send_compression_buffer;		  // used by async_send_buffer's thread only
+		mutable Buffer::ByteArray receive_compression_buffer;	  // used by receiver thread only
 
 		/**
 		 * \brief Timestamp of this wire which increases at intervals of [heartBeatInterval].
@@ -88,6 +135,51 @@ public:
 
 		mutable Buffer message{CHUNK_SIZE};
 
+		mutable WireMetrics metrics;
+
+		IoMode io_mode = IoMode::Thread;
+
+		/**
+		 * \brief Progress of decoding the received stream in reactor mode, where data comes in whatever pieces the socket
+		 * has at the moment. Used by the reactor thread only.
+		 */
+		struct ReactorReceiveState
+		{
+			// body of the package being received, goes to [receive_pkg] or [receive_compression_buffer]
+			bool in_package = false;
+			int32_t package_len = 0;
+			sequence_number_t package_seqn = 0;
+			Buffer::word_t* package_target = nullptr;
+			int32_t package_size = 0;
+			int32_t package_filled = 0;
+
+			// message being assembled from the payloads of packages: length, id, body
+			std::array<Buffer::word_t, sizeof(int32_t) + sizeof(RdId::hash_t)> message_header{};
+			size_t message_header_filled = 0;
+			RdId::hash_t message_id = 0;
+			int32_t message_size = 0;
+			int32_t message_filled = 0;
+		};
+		mutable ReactorReceiveState reactor_state;
+
+		/**
+		 * \brief Current connection in reactor mode, its termination ends the connection.
+		 */
+		std::unique_ptr<LifetimeDefinition> connection_definition;
+
+		/**
+		 * \brief Held by reactor handlers of the wire and the actions which set up its connections. Termination takes it
+		 * to wait for a handler finishing a connection closed by the counterpart at the same time.
+		 */
+		mutable std::recursive_mutex reactor_lock;
+
+		/**
+		 * \brief Reactor mode: the latest sequence number to acknowledge, 0 if none. Acknowledges are cumulative, so the
+		 * reactor thread never waits for the socket to send one: if the socket is busy, the ack is sent after the package
+		 * being sent or with the next ping.
+		 */
+		mutable std::atomic<sequence_number_t> pending_ack{0};
+
 		bool read_from_socket(Buffer::word_t* res, int32_t msglen) const;
 
 		template <typename T>
@@ -101,8 +193,71 @@ public:
 			return read_from_socket(reinterpret_cast<Buffer::word_t*>(data), static_cast<int32_t>(len));
 		}
 
+		Buffer::ByteArray write_message(RdId const& rd_id, std::function<void(Buffer& buffer)> const& writer) const;
+
+		static Buffer::ByteArray write_message(
+			Buffer& buffer, RdId const& rd_id, std::function<void(Buffer& buffer)> const& writer, bool compact);
+
+		bool is_compact_encoding_negotiated() const;
+
+		/**
+		 * \brief Turns a freshly connected socket into the socket provider of the wire, e.g. switches to another transport.
+		 * Runs on the connection thread before any package is exchanged. Empty means the socket is used as is,
+		 * a throwing upgrade drops the connection.
+		 */
+		using connection_upgrade_t = std::function<std::shared_ptr<CActiveSocket>(std::shared_ptr<CActiveSocket> const&)>;
+		connection_upgrade_t upgrade_connection;
+
+		std::shared_ptr<CActiveSocket> upgrade(std::shared_ptr<CActiveSocket> const& connected_socket) const;
+
 		void set_socket_provider(std::shared_ptr<CActiveSocket> new_socket);
 
+		/**
+		 * \brief Reactor mode counterpart of [set_socket_provider]: returns right away, [on_closed] is called on the reactor
+		 * thread once the connection is over, unless [lifetime] has been terminated.
+		 */
+		bool attach_to_reactor(Lifetime lifetime, std::shared_ptr<CActiveSocket> new_socket, std::function<void()> on_closed);
+
+		void set_io_mode(IoMode requested);
+
+		void start_connection(Lifetime connection_lifetime);
+
+		void stop_connection();
+
+		void shutdown_socket_provider();
+
+		void on_ping(int32_t received_timestamp, int32_t received_counterpart_timestamp) const;
+
+		/**
+		 * \brief Handles acknowledgement and handshake headers, returns false for a header of a package.
+		 */
+		bool on_control_header(int32_t len, sequence_number_t seqn) const;
+
+		/**
+		 * \brief Decompresses the package if needed, returns length of the payload in [receive_pkg] or -1.
+		 */
+		int32_t unpack_package(int32_t len, sequence_number_t seqn) const;
+
+		/**
+		 * \brief Acknowledges the package, returns false if it's a duplicate which must be skipped.
+		 */
+		bool accept_package(sequence_number_t seqn) const;
+
+		void queue_ack(sequence_number_t seqn) const;
+
+		/**
+		 * \brief Sends [pending_ack] if any, [socket_send_lock] must be held. Unless [blocking], a plain socket is written
+		 * without waiting and the ack is kept for later if it's full. An upgraded connection is always written through its
+		 * provider.
+		 */
+		void flush_pending_ack(bool blocking) const;
+
+		bool receive_from_reactor() const;
+
+		bool decode_received() const;
+
+		bool dispatch_payload(int32_t len) const;
+
 		CSimpleSocket* get_socket_provider() const;
 
 	public:
@@ -129,15 +284,56 @@ public:
 
 		void send(RdId const& rd_id, std::function<void(Buffer& buffer)> writer) const override;
 
+		bool try_send(RdId const& rd_id, std::function<void(Buffer& buffer)> writer) const override;
+
+		bool begin_send_batch() const override;
+
+		void end_send_batch() const override;
+
+		bool is_send_batching() const;
+
+		void add_to_send_batch(Buffer::ByteArray const& message) const;
+
+		void flush_send_batch() const;
+
+		void set_send_window(ByteBufferAsyncProcessor::Window window, ByteBufferAsyncProcessor::BackpressurePolicy policy);
+
+		ByteBufferAsyncProcessor::WindowOccupancy get_send_window_occupancy() const;
+
+		/**
+		 * \brief Traffic counters since creation or the last [reset_metrics], along with the current send queue depth.
+		 */
+		WireMetrics::Snapshot get_metrics() const;
+
+		void reset_metrics();
+
 		static bool connection_established(int32_t timestamp, int32_t acknowledged_timestamp);
 
-		std::future<void> start_heartbeat(Lifetime lifetime);
+		/**
+		 * \brief Pings the counterpart every [heartBeatInterval] from the shared TimerWheel until [lifetime] is terminated.
+		 */
+		void start_heartbeat(Lifetime lifetime);
 
 		void ping() const;
 
-		bool send_ack(sequence_number_t seqn) const;
+		bool send_handshake() const;
+
+		/**
+		 * \brief Compresses packages larger than [threshold] bytes, if the counterpart supports it.
+		 * Must be called before connection is established.
+		 */
+		void enable_compression(int32_t threshold = 4096);
+
+		/**
+		 * \brief Writes lengths, enums and integral values in compact encoding once the counterpart has announced that it
+		 * supports it too. Messages sent before the handshake arrives are written as usual, each message is marked,
+		 * so the counterpart reads both. Must be called before connection is established.
+		 */
+		void enable_compact_encoding();
 
 		bool try_shutdown_connection() const;
+
+		IoMode get_io_mode() const;
 		
 	private:		
 		LifetimeDefinition lifetimeDef;
@@ -148,16 +344,43 @@ public:
 	public:
 		uint16_t port = 0;
 
+		/**
+		 * \brief Failed connection attempts are retried after a delay doubling from [timeout] up to this value,
+		 * it starts over once a connection was established.
+		 */
+		std::chrono::milliseconds max_reconnect_delay = std::chrono::milliseconds(8000);
+
 		// region ctor/dtor
 
-		Client(Lifetime parentLifetime, IScheduler* scheduler, uint16_t port = 0, const std::string& id = "ClientSocket");
+		Client(Lifetime parentLifetime, IScheduler* scheduler, uint16_t port = 0, const std::string& id = "ClientSocket",
+			IoMode io_mode = IoMode::Thread);
 
 		virtual ~Client() override;
 		// endregion
 
+	protected:
+		Client(Lifetime parentLifetime, IScheduler* scheduler, uint16_t port, const std::string& id,
+			connection_upgrade_t upgrade_connection, IoMode io_mode = IoMode::Thread);
+
+	public:
 		std::condition_variable_any cv;
 	private:		
 		LifetimeDefinition clientLifetimeDefinition;
+
+		/**
+		 * \brief Returns false if [lifetime] was terminated while waiting [delay].
+		 */
+		bool wait_before_reconnect(Lifetime lifetime, std::chrono::milliseconds delay);
+
+		/**
+		 * \brief Delay before the next connection attempt, used by the connecting thread or timer only.
+		 */
+		std::chrono::milliseconds reconnect_delay{0};
+
+		/**
+		 * \brief Reactor mode: tries to connect after [delay] on the timer thread, retries with backoff.
+		 */
+		void connect_in_reactor(Lifetime lifetime, std::chrono::milliseconds delay);
 	};
 
 	class RD_FRAMEWORK_API Server : public Base
@@ -169,12 +392,27 @@ public:
 
 		// region ctor/dtor
 
-		Server(Lifetime lifetime, IScheduler* scheduler, uint16_t port = 0, const std::string& id = "ServerSocket");
+		Server(Lifetime lifetime, IScheduler* scheduler, uint16_t port = 0, const std::string& id = "ServerSocket",
+			IoMode io_mode = IoMode::Thread);
 
 		virtual ~Server() override;
 		// endregion
+
+	protected:
+		Server(Lifetime lifetime, IScheduler* scheduler, uint16_t port, const std::string& id,
+			connection_upgrade_t upgrade_connection, IoMode io_mode = IoMode::Thread);
 	private:
 		LifetimeDefinition serverLifetimeDefinition;
+
+		/**
+		 * \brief Reactor mode: the listening socket is registered while there is no connection, like the thread mode
+		 * accepts one connection at a time.
+		 */
+		std::unique_ptr<LifetimeDefinition> accept_definition;
+
+		void listen_in_reactor(Lifetime lifetime);
+
+		void accept_in_reactor(Lifetime lifetime);
 	};
 };
 }	 // namespace rd
@@ -0,0 +1,547 @@
+#include "wire/WireBenchmark.h"
+
+#include "wire/LoopbackWire.h"
+#include "wire/SharedMemoryWire.h"
+#include "wire/SocketWire.h"
+#include "protocol/Protocol.h"
+#include "impl/RdSignal.h"
+#include "impl/RdProperty.h"
+#include "impl/RdMap.h"
+#include "task/RdCall.h"
+#include "task/RdEndpoint.h"
+#include "task/RdTaskCoroutine.h"
+#include "serialization/InternedSerializer.h"
+#include "scheduler/SingleThreadScheduler.h"
+#include "util/hashing.h"
+
+#include "spdlog/fmt/fmt.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace rd
+{
+namespace test
+{
+namespace util
+{
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+constexpr rd::util::hash_t PROTOCOL_INTERN_KEY = rd::util::getPlatformIndependentHash("Protocol");
+constexpr size_t INTERNED_VALUES_COUNT = 64;
+constexpr int64_t BENCHMARK_ENTITY_ID = 1;
+
+/**
+ * \brief Strings are serialized as UTF-16, so a payload of N bytes is N/2 characters. The leading digits make
+ * consecutive payloads distinct, which properties require.
+ */
+std::wstring make_payload(size_t payload_size, size_t index)
+{
+	const auto digits = std::to_wstring(index);
+	std::wstring res((std::max)(payload_size / sizeof(char16_t), digits.size()), L'x');
+	std::copy(digits.begin(), digits.end(), res.begin());
+	return res;
+}
+
+std::string next_session_name()
+{
+	// scheduler names register loggers, which must be unique
+	static std::atomic<uint32_t> counter{0};
+	return "Benchmark-" + std::to_string(counter++);
+}
+
+class Session
+{
+public:
+	const std::string name = next_session_name();
+	LifetimeDefinition definition{Lifetime::Eternal()};
+	Lifetime lifetime = definition.lifetime;
+	SingleThreadScheduler server_scheduler{lifetime, name + "-ServerScheduler"};
+	SingleThreadScheduler client_scheduler{lifetime, name + "-ClientScheduler"};
+	LifetimeDefinition wire_definition{lifetime};
+	std::shared_ptr<IWire> server_wire;
+	std::shared_ptr<IWire> client_wire;
+	std::unique_ptr<Protocol> server;
+	std::unique_ptr<Protocol> client;
+
+	// region ctor/dtor
+
+	explicit Session(WireBenchmark::Transport transport)
+	{
+		switch (transport)
+		{
+			case WireBenchmark::Transport::Loopback:
+			{
+				auto wires = LoopbackWire::create_pair(wire_definition.lifetime, &server_scheduler, &client_scheduler, name);
+				server_wire = wires.first;
+				client_wire = wires.second;
+				break;
+			}
+			case WireBenchmark::Transport::Socket:
+			{
+				auto wire = std::make_shared<SocketWire::Server>(wire_definition.lifetime, &server_scheduler, 0, name + "-Server");
+				client_wire = std::make_shared<SocketWire::Client>(wire_definition.lifetime, &client_scheduler, wire->port, name + "-Client");
+				server_wire = std::move(wire);
+				break;
+			}
+			case WireBenchmark::Transport::SocketReactor:
+			{
+				auto wire = std::make_shared<SocketWire::Server>(
+					wire_definition.lifetime, &server_scheduler, 0, name + "-Server", SocketWire::IoMode::Reactor);
+				client_wire = std::make_shared<SocketWire::Client>(
+					wire_definition.lifetime, &client_scheduler, wire->port, name + "-Client", SocketWire::IoMode::Reactor);
+				server_wire = std::move(wire);
+				break;
+			}
+			case WireBenchmark::Transport::SharedMemory:
+			{
+				auto wire = std::make_shared<SharedMemoryWire::Server>(wire_definition.lifetime, &server_scheduler, 0, name + "-Server");
+				client_wire =
+					std::make_shared<SharedMemoryWire::Client>(wire_definition.lifetime, &client_scheduler, wire->port, name + "-Client");
+				server_wire = std::move(wire);
+				break;
+			}
+		}
+		server = std::make_unique<Protocol>(Identities::SERVER, &server_scheduler, server_wire, lifetime);
+		client = std::make_unique<Protocol>(Identities::CLIENT, &client_scheduler, client_wire, lifetime);
+
+		// creating the contexts queues binding of the intern roots, which must happen before anything is interned
+		server->get_serialization_context();
+		client->get_serialization_context();
+	}
+
+	Session(Session const&) = delete;
+
+	~Session()
+	{
+		close();
+	}
+	// endregion
+
+	bool await_connection(clock_type::time_point deadline) const
+	{
+		while (!(server_wire->connected.get() && client_wire->connected.get()))
+		{
+			if (clock_type::now() > deadline)
+			{
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+
+	template <typename S, typename C>
+	void bind(S& server_entity, C& client_entity, std::function<void()> on_server_bound)
+	{
+		statics(server_entity, BENCHMARK_ENTITY_ID);
+		statics(client_entity, BENCHMARK_ENTITY_ID);
+		server_scheduler.queue([&, on_server_bound] {
+			server_entity.bind(lifetime, server.get(), "benchmark");
+			on_server_bound();
+		});
+		client_scheduler.queue([&] { client_entity.bind(lifetime, client.get(), "benchmark"); });
+		server_scheduler.flush();
+		client_scheduler.flush();
+	}
+
+	/**
+	 * \brief Disconnects first and drains the schedulers, so that nothing is dispatched to entities while they unbind.
+	 */
+	void close()
+	{
+		if (definition.is_terminated())
+		{
+			return;
+		}
+		wire_definition.terminate();
+		server_scheduler.flush();
+		client_scheduler.flush();
+		definition.terminate();
+	}
+};
+
+/**
+ * \brief Send and receive timestamps of every message. Each slot is written by a single thread,
+ * [completed] publishes them to the benchmark thread.
+ */
+class Recorder
+{
+	std::vector<clock_type::time_point> sent;
+	std::vector<clock_type::time_point> received;
+	std::atomic<size_t> completed{0};
+
+public:
+	// region ctor/dtor
+
+	explicit Recorder(size_t messages) : sent(messages), received(messages)
+	{
+	}
+	// endregion
+
+	void on_sent(size_t index)
+	{
+		sent[index] = clock_type::now();
+	}
+
+	/**
+	 * \brief For ordered delivery: the n-th arrival is the n-th message.
+	 */
+	void on_received_next()
+	{
+		const size_t index = completed.load(std::memory_order_relaxed);
+		received[index] = clock_type::now();
+		completed.store(index + 1, std::memory_order_release);
+	}
+
+	void on_received(size_t index)
+	{
+		received[index] = clock_type::now();
+		completed.fetch_add(1, std::memory_order_acq_rel);
+	}
+
+	void await(clock_type::time_point deadline) const
+	{
+		while (completed.load(std::memory_order_acquire) < sent.size() && clock_type::now() < deadline)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	}
+
+	WireBenchmark::Result result(WireBenchmark::Transport transport, WireBenchmark::Scenario scenario, size_t payload_size) const
+	{
+		WireBenchmark::Result res{transport, scenario, payload_size, sent.size(), completed.load(std::memory_order_acquire),
+			std::chrono::nanoseconds::zero(), 0, 0, std::chrono::nanoseconds::zero(), std::chrono::nanoseconds::zero()};
+
+		std::vector<std::chrono::nanoseconds> latencies;
+		latencies.reserve(sent.size());
+		clock_type::time_point first = clock_type::time_point::max();
+		clock_type::time_point last = clock_type::time_point::min();
+		for (size_t i = 0; i < sent.size(); ++i)
+		{
+			if (received[i] == clock_type::time_point{})
+			{
+				continue;
+			}
+			first = (std::min)(first, sent[i]);
+			last = (std::max)(last, received[i]);
+			latencies.push_back(received[i] - sent[i]);
+		}
+		if (latencies.empty())
+		{
+			return res;
+		}
+
+		res.elapsed = last - first;
+		const double seconds = std::chrono::duration<double>(res.elapsed).count();
+		if (seconds > 0)
+		{
+			res.messages_per_second = static_cast<double>(latencies.size()) / seconds;
+			res.bytes_per_second = static_cast<double>(latencies.size() * payload_size) / seconds;
+		}
+		std::sort(latencies.begin(), latencies.end());
+		res.p50 = latencies[latencies.size() / 2];
+		res.p99 = latencies[(std::min)(latencies.size() - 1, latencies.size() * 99 / 100)];
+		return res;
+	}
+};
+
+/**
+ * \brief Entities live on the stack of the scenario, so everything must be delivered (or timed out)
+ * and the protocols unbound before it returns.
+ */
+void complete(Session& session, Recorder const& recorder, clock_type::time_point deadline)
+{
+	session.client_scheduler.flush();
+	recorder.await(deadline);
+	session.close();
+}
+
+void run_signal(Session& session, Recorder& recorder, size_t payload_size, size_t messages, clock_type::time_point deadline)
+{
+	RdSignal<std::wstring> server_signal;
+	RdSignal<std::wstring> client_signal;
+	session.bind(server_signal, client_signal,
+		[&] { server_signal.advise(session.lifetime, [&](std::wstring const&) { recorder.on_received_next(); }); });
+
+	const auto payload = make_payload(payload_size, 0);
+	session.client_scheduler.queue([&] {
+		for (size_t i = 0; i < messages; ++i)
+		{
+			recorder.on_sent(i);
+			client_signal.fire(payload);
+		}
+	});
+	complete(session, recorder, deadline);
+}
+
+void run_property(Session& session, Recorder& recorder, size_t payload_size, size_t messages, clock_type::time_point deadline)
+{
+	RdProperty<std::wstring> server_property;
+	RdProperty<std::wstring> client_property;
+	session.bind(server_property, client_property,
+		[&] { server_property.advise(session.lifetime, [&](std::wstring const&) { recorder.on_received_next(); }); });
+
+	session.client_scheduler.queue([&] {
+		for (size_t i = 0; i < messages; ++i)
+		{
+			auto value = make_payload(payload_size, i);
+			recorder.on_sent(i);
+			client_property.set(std::move(value));
+		}
+	});
+	complete(session, recorder, deadline);
+}
+
+void run_map(Session& session, Recorder& recorder, size_t payload_size, size_t messages, clock_type::time_point deadline)
+{
+	RdMap<int32_t, std::wstring> server_map;
+	RdMap<int32_t, std::wstring> client_map;
+	session.bind(server_map, client_map, [&] {
+		server_map.advise_add_remove(session.lifetime, [&](AddRemove kind, int32_t const&, std::wstring const&) {
+			if (kind == AddRemove::ADD)
+			{
+				recorder.on_received_next();
+			}
+		});
+	});
+
+	const auto payload = make_payload(payload_size, 0);
+	session.client_scheduler.queue([&] {
+		for (size_t i = 0; i < messages; ++i)
+		{
+			recorder.on_sent(i);
+			client_map.set(static_cast<int32_t>(i), payload);
+		}
+	});
+	complete(session, recorder, deadline);
+}
+
+void run_call(Session& session, Recorder& recorder, size_t payload_size, size_t messages, clock_type::time_point deadline)
+{
+	RdEndpoint<std::wstring, std::wstring> server_endpoint;
+	RdCall<std::wstring, std::wstring> client_call;
+	session.bind(server_endpoint, client_call,
+		[&] { server_endpoint.set([](std::wstring const& request) -> std::wstring { return request; }); });
+
+	const auto payload = make_payload(payload_size, 0);
+	// the broker only keeps a raw pointer to a pending task, so the tasks must outlive the session
+	std::vector<WiredRdTask<std::wstring>> tasks;
+	tasks.reserve(messages);
+	session.client_scheduler.queue([&] {
+		for (size_t i = 0; i < messages; ++i)
+		{
+			recorder.on_sent(i);
+			tasks.push_back(client_call.start(payload));
+			tasks.back().advise(session.lifetime, [&recorder, i](auto const&) { recorder.on_received(i); });
+		}
+	});
+	complete(session, recorder, deadline);
+}
+
+void run_call_batch(Session& session, Recorder& recorder, size_t payload_size, size_t messages, clock_type::time_point deadline)
+{
+	RdEndpoint<std::wstring, std::wstring> server_endpoint;
+	RdCall<std::wstring, std::wstring> client_call;
+	session.bind(server_endpoint, client_call,
+		[&] { server_endpoint.set([](std::wstring const& request) -> std::wstring { return request; }); });
+
+	const auto payload = make_payload(payload_size, 0);
+	// the broker only keeps a raw pointer to a pending task, so the tasks must outlive the session
+	std::vector<WiredRdTask<std::wstring>> tasks;
+	tasks.reserve(messages);
+	session.client_scheduler.queue([&] {
+		for (size_t i = 0; i < messages; i += WireBenchmark::CALL_BATCH_SIZE)
+		{
+			const size_t count = (std::min)(WireBenchmark::CALL_BATCH_SIZE, messages - i);
+			for (size_t j = i; j < i + count; ++j)
+			{
+				recorder.on_sent(j);
+			}
+			for (auto& task : client_call.start_batch(std::vector<std::wstring>(count, payload)))
+			{
+				const size_t index = tasks.size();
+				tasks.push_back(std::move(task));
+				tasks.back().advise(session.lifetime, [&recorder, index](auto const&) { recorder.on_received(index); });
+			}
+		}
+	});
+	complete(session, recorder, deadline);
+}
+
+#if RD_CPP_HAS_COROUTINES
+/**
+ * \brief One call of [run_coroutine_call], resumed where its response is set, that's on [scheduler].
+ */
+RdTask<bool> await_call(
+	RdCall<std::wstring, std::wstring> const& call, std::wstring const& request, IScheduler* scheduler, Recorder& recorder, size_t index)
+{
+	auto result = co_await call.start(request, scheduler);
+	if (result.is_succeeded())
+	{
+		recorder.on_received(index);
+	}
+	co_return result.is_succeeded();
+}
+#endif
+
+void run_coroutine_call(
+	Session& session, Recorder& recorder, size_t payload_size, size_t messages, clock_type::time_point deadline)
+{
+#if RD_CPP_HAS_COROUTINES
+	RdEndpoint<std::wstring, std::wstring> server_endpoint;
+	RdCall<std::wstring, std::wstring> client_call;
+	session.bind(server_endpoint, client_call, [&] {
+		server_endpoint.set([](Lifetime, std::wstring const& request) -> RdTask<std::wstring> { co_return request; });
+	});
+
+	const auto payload = make_payload(payload_size, 0);
+	// a coroutine keeps its task until it's resumed, a timed out one is resumed cancelled when the session is closed
+	session.client_scheduler.queue([&] {
+		for (size_t i = 0; i < messages; ++i)
+		{
+			recorder.on_sent(i);
+			await_call(client_call, payload, &session.client_scheduler, recorder, i);
+		}
+	});
+	complete(session, recorder, deadline);
+#else
+	(void) payload_size;
+	(void) messages;
+	complete(session, recorder, deadline);
+#endif
+}
+
+void run_interning(Session& session, Recorder& recorder, size_t payload_size, size_t messages, clock_type::time_point deadline)
+{
+	using interned_signal_t = RdSignal<std::wstring, InternedSerializer<Polymorphic<std::wstring>, PROTOCOL_INTERN_KEY>>;
+	interned_signal_t server_signal;
+	interned_signal_t client_signal;
+	session.bind(server_signal, client_signal,
+		[&] { server_signal.advise(session.lifetime, [&](std::wstring const&) { recorder.on_received_next(); }); });
+
+	std::vector<std::wstring> values;
+	for (size_t i = 0; i < INTERNED_VALUES_COUNT; ++i)
+	{
+		values.push_back(make_payload(payload_size, i));
+	}
+	session.client_scheduler.queue([&] {
+		for (size_t i = 0; i < messages; ++i)
+		{
+			recorder.on_sent(i);
+			client_signal.fire(values[i % values.size()]);
+		}
+	});
+	complete(session, recorder, deadline);
+}
+}	 // namespace
+
+constexpr size_t WireBenchmark::CALL_BATCH_SIZE;
+
+WireBenchmark::Result WireBenchmark::run(
+	Transport transport, Scenario scenario, size_t payload_size, size_t messages, std::chrono::milliseconds timeout)
+{
+	const auto deadline = clock_type::now() + timeout;
+	Recorder recorder(messages);
+	Session session(transport);
+	if (!session.await_connection(deadline))
+	{
+		return recorder.result(transport, scenario, payload_size);
+	}
+
+	switch (scenario)
+	{
+		case Scenario::Signal:
+			run_signal(session, recorder, payload_size, messages, deadline);
+			break;
+		case Scenario::Property:
+			run_property(session, recorder, payload_size, messages, deadline);
+			break;
+		case Scenario::Map:
+			run_map(session, recorder, payload_size, messages, deadline);
+			break;
+		case Scenario::Call:
+			run_call(session, recorder, payload_size, messages, deadline);
+			break;
+		case Scenario::Interning:
+			run_interning(session, recorder, payload_size, messages, deadline);
+			break;
+		case Scenario::CallBatch:
+			run_call_batch(session, recorder, payload_size, messages, deadline);
+			break;
+		case Scenario::CoroutineCall:
+			run_coroutine_call(session, recorder, payload_size, messages, deadline);
+			break;
+	}
+	return recorder.result(transport, scenario, payload_size);
+}
+
+std::vector<WireBenchmark::Result> WireBenchmark::run(Options const& options)
+{
+	std::vector<Result> res;
+	for (auto transport : options.transports)
+	{
+		for (auto scenario : options.scenarios)
+		{
+			for (auto payload_size : options.payload_sizes)
+			{
+				const size_t budget = (std::max)(options.max_bytes_per_run / (std::max)(payload_size, size_t{1}), size_t{1});
+				res.push_back(run(transport, scenario, payload_size, (std::min)(options.messages, budget), options.timeout));
+			}
+		}
+	}
+	return res;
+}
+
+std::string WireBenchmark::to_string(Transport transport)
+{
+	switch (transport)
+	{
+		case Transport::Loopback:
+			return "Loopback";
+		case Transport::Socket:
+			return "Socket";
+		case Transport::SharedMemory:
+			return "SharedMemory";
+		case Transport::SocketReactor:
+			return "SocketReactor";
+	}
+	return "";
+}
+
+std::string WireBenchmark::to_string(Scenario scenario)
+{
+	switch (scenario)
+	{
+		case Scenario::Signal:
+			return "Signal";
+		case Scenario::Property:
+			return "Property";
+		case Scenario::Map:
+			return "Map";
+		case Scenario::Call:
+			return "Call";
+		case Scenario::Interning:
+			return "Interning";
+		case Scenario::CallBatch:
+			return "CallBatch";
+		case Scenario::CoroutineCall:
+			return "CoroutineCall";
+	}
+	return "";
+}
+
+std::string WireBenchmark::to_string(Result const& result)
+{
+	using micros = std::chrono::duration<double, std::micro>;
+	return fmt::format("{:<12} {:<9} {:>7} B {:>6}/{:<6} msg {:>10.0f} msg/s {:>9.2f} MB/s p50 {:>9.1f} us p99 {:>9.1f} us",
+		to_string(result.transport), to_string(result.scenario), result.payload_size, result.completed, result.messages,
+		result.messages_per_second, result.bytes_per_second / (1024 * 1024), micros(result.p50).count(),
+		micros(result.p99).count());
+}
+}	 // namespace util
+}	 // namespace test
+}	 // namespace rd
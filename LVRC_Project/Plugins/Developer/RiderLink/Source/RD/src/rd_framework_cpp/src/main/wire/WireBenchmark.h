@@ -0,0 +1,110 @@
+#ifndef RD_CPP_WIREBENCHMARK_H
+#define RD_CPP_WIREBENCHMARK_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+namespace test
+{
+namespace util
+{
+/**
+ * \brief Throughput and latency of the RD stack end to end: entity -> serializers -> wire -> broker -> entity.
+ * Every run builds a fresh pair of protocols with their own scheduler threads connected by the chosen transport.
+ */
+class RD_FRAMEWORK_API WireBenchmark
+{
+public:
+	enum class Transport
+	{
+		Loopback,
+		Socket,
+		SharedMemory,
+		// SocketWire in SocketWire::IoMode::Reactor
+		SocketReactor
+	};
+
+	enum class Scenario
+	{
+		Signal,
+		Property,
+		Map,
+		Call,
+		Interning,
+		/**
+		 * \brief [Call] started in pipelined batches of [CALL_BATCH_SIZE] with [RdCall::start_batch].
+		 */
+		CallBatch,
+		/**
+		 * \brief [Call] awaited with `co_await` and answered by a coroutine endpoint handler. Needs C++20 coroutines,
+		 * see [RD_CPP_HAS_COROUTINES], nothing is sent without them. Not in the default [Options] for this reason.
+		 */
+		CoroutineCall
+	};
+
+	static constexpr size_t CALL_BATCH_SIZE = 64;
+
+	struct Options
+	{
+		std::vector<Transport> transports{Transport::Loopback, Transport::Socket};
+		std::vector<Scenario> scenarios{Scenario::Signal, Scenario::Property, Scenario::Map, Scenario::Call, Scenario::Interning,
+			Scenario::CallBatch};
+		std::vector<size_t> payload_sizes{16, 1024, 16 * 1024};
+		/**
+		 * \brief Messages per run, reduced for big payloads so that a run moves at most [max_bytes_per_run].
+		 */
+		size_t messages = 20000;
+		size_t max_bytes_per_run = 64 * 1024 * 1024;
+		std::chrono::milliseconds timeout{30000};
+	};
+
+	struct Result
+	{
+		Transport transport;
+		Scenario scenario;
+		size_t payload_size;
+		size_t messages;
+		/**
+		 * \brief Messages which arrived (or calls which completed) before the timeout.
+		 */
+		size_t completed;
+		std::chrono::nanoseconds elapsed;
+		double messages_per_second;
+		double bytes_per_second;
+		/**
+		 * \brief One way delivery time, round trip for [Scenario::Call].
+		 */
+		std::chrono::nanoseconds p50;
+		std::chrono::nanoseconds p99;
+	};
+
+	static Result run(Transport transport, Scenario scenario, size_t payload_size, size_t messages,
+		std::chrono::milliseconds timeout = std::chrono::milliseconds(30000));
+
+	static std::vector<Result> run(Options const& options);
+
+	static std::string to_string(Transport transport);
+
+	static std::string to_string(Scenario scenario);
+
+	static std::string to_string(Result const& result);
+};
+}	 // namespace util
+}	 // namespace test
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_WIREBENCHMARK_H
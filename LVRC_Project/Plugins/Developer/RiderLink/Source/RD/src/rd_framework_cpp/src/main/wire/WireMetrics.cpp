@@ -0,0 +1,160 @@
+#include "wire/WireMetrics.h"
+
+#include "spdlog/fmt/fmt.h"
+
+namespace rd
+{
+namespace
+{
+int64_t now_in_microseconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t ack_rtt_bucket(int64_t microseconds)
+{
+	size_t bucket = 0;
+	while (microseconds > 0 && bucket + 1 < WireMetrics::ACK_RTT_BUCKETS)
+	{
+		microseconds >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+}	 // namespace
+
+constexpr size_t WireMetrics::ACK_RTT_BUCKETS;
+constexpr size_t WireMetrics::IN_FLIGHT_SLOTS;
+
+uint64_t WireMetrics::Snapshot::ack_rtt_count() const
+{
+	uint64_t res = 0;
+	for (auto count : ack_rtt_histogram)
+	{
+		res += count;
+	}
+	return res;
+}
+
+std::chrono::microseconds WireMetrics::Snapshot::ack_rtt_percentile(double percentile) const
+{
+	const uint64_t total = ack_rtt_count();
+	if (total == 0)
+	{
+		return std::chrono::microseconds::zero();
+	}
+	const auto rank = static_cast<uint64_t>(static_cast<double>(total) * percentile / 100.0);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < ack_rtt_histogram.size(); ++i)
+	{
+		seen += ack_rtt_histogram[i];
+		if (seen > rank || seen == total)
+		{
+			return std::chrono::microseconds(int64_t{1} << i);
+		}
+	}
+	return std::chrono::microseconds(int64_t{1} << (ACK_RTT_BUCKETS - 1));
+}
+
+void WireMetrics::on_message_sent()
+{
+	messages_sent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WireMetrics::on_package_sent(sequence_number_t seqn, size_t bytes)
+{
+	packages_sent.fetch_add(1, std::memory_order_relaxed);
+	bytes_sent.fetch_add(bytes, std::memory_order_relaxed);
+
+	auto& slot = in_flight[static_cast<size_t>(seqn) % IN_FLIGHT_SLOTS];
+	slot.seqn.store(0, std::memory_order_relaxed);
+	slot.sent_at.store(now_in_microseconds(), std::memory_order_relaxed);
+	slot.seqn.store(seqn, std::memory_order_release);
+}
+
+void WireMetrics::on_package_received(size_t bytes)
+{
+	packages_received.fetch_add(1, std::memory_order_relaxed);
+	bytes_received.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void WireMetrics::on_message_received()
+{
+	messages_received.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WireMetrics::on_acknowledged(sequence_number_t seqn)
+{
+	auto& slot = in_flight[static_cast<size_t>(seqn) % IN_FLIGHT_SLOTS];
+	sequence_number_t expected = seqn;
+	const int64_t sent_at = slot.sent_at.load(std::memory_order_acquire);
+	// slot may have been reused by a newer package or the ack may be a duplicate after reconnect
+	if (slot.seqn.compare_exchange_strong(expected, 0, std::memory_order_acq_rel))
+	{
+		ack_rtt_histogram[ack_rtt_bucket(now_in_microseconds() - sent_at)].fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void WireMetrics::on_connected()
+{
+	connections.fetch_add(1, std::memory_order_relaxed);
+	if (ever_connected.exchange(true))
+	{
+		reconnects.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void WireMetrics::on_heartbeat_missed()
+{
+	heartbeat_misses.fetch_add(1, std::memory_order_relaxed);
+}
+
+WireMetrics::Snapshot WireMetrics::snapshot() const
+{
+	Snapshot res;
+	res.messages_sent = messages_sent.load(std::memory_order_relaxed);
+	res.messages_received = messages_received.load(std::memory_order_relaxed);
+	res.bytes_sent = bytes_sent.load(std::memory_order_relaxed);
+	res.bytes_received = bytes_received.load(std::memory_order_relaxed);
+	res.packages_sent = packages_sent.load(std::memory_order_relaxed);
+	res.packages_received = packages_received.load(std::memory_order_relaxed);
+	res.connections = connections.load(std::memory_order_relaxed);
+	res.reconnects = reconnects.load(std::memory_order_relaxed);
+	res.heartbeat_misses = heartbeat_misses.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < ACK_RTT_BUCKETS; ++i)
+	{
+		res.ack_rtt_histogram[i] = ack_rtt_histogram[i].load(std::memory_order_relaxed);
+	}
+	return res;
+}
+
+void WireMetrics::reset()
+{
+	messages_sent = 0;
+	messages_received = 0;
+	bytes_sent = 0;
+	bytes_received = 0;
+	packages_sent = 0;
+	packages_received = 0;
+	connections = 0;
+	reconnects = 0;
+	heartbeat_misses = 0;
+	for (auto& bucket : ack_rtt_histogram)
+	{
+		bucket = 0;
+	}
+}
+
+std::string to_string(WireMetrics::Snapshot const& snapshot)
+{
+	return fmt::format(
+		"messages out/in: {}/{}, bytes out/in: {}/{}, packages out/in: {}/{}, "
+		"queued: {} ({} bytes), pending ack: {} ({} bytes), dropped: {}, "
+		"connections: {}, reconnects: {}, heartbeat misses: {}, "
+		"ack rtt: {} samples, p50 <= {} us, p99 <= {} us",
+		snapshot.messages_sent, snapshot.messages_received, snapshot.bytes_sent, snapshot.bytes_received, snapshot.packages_sent,
+		snapshot.packages_received, snapshot.queued_messages, snapshot.queued_bytes, snapshot.pending_messages,
+		snapshot.pending_bytes, snapshot.dropped_messages, snapshot.connections, snapshot.reconnects, snapshot.heartbeat_misses,
+		snapshot.ack_rtt_count(), snapshot.ack_rtt_percentile(50).count(), snapshot.ack_rtt_percentile(99).count());
+}
+}	 // namespace rd
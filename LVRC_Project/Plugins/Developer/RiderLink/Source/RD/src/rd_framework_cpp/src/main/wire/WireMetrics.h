@@ -0,0 +1,127 @@
+#ifndef RD_CPP_WIREMETRICS_H
+#define RD_CPP_WIREMETRICS_H
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+#include "ByteBufferAsyncProcessor.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <rd_framework_export.h>
+
+namespace rd
+{
+/**
+ * \brief Traffic counters of a single wire. Updated by the wire threads and readable from any thread without locks.
+ */
+class RD_FRAMEWORK_API WireMetrics
+{
+public:
+	/**
+	 * \brief Bucket i counts acknowledgements which took [2^(i-1), 2^i) microseconds, the last bucket is open-ended.
+	 */
+	static constexpr size_t ACK_RTT_BUCKETS = 24;
+
+	struct RD_FRAMEWORK_API Snapshot
+	{
+		uint64_t messages_sent = 0;
+		uint64_t messages_received = 0;
+		/**
+		 * \brief Package headers and bodies as written to/read from the transport, pings and acks excluded.
+		 */
+		uint64_t bytes_sent = 0;
+		uint64_t bytes_received = 0;
+		/**
+		 * \brief Send batches: every package carries all messages queued since the previous one.
+		 */
+		uint64_t packages_sent = 0;
+		uint64_t packages_received = 0;
+		uint64_t queued_messages = 0;
+		uint64_t queued_bytes = 0;
+		uint64_t pending_messages = 0;
+		uint64_t pending_bytes = 0;
+		uint64_t dropped_messages = 0;
+		uint64_t connections = 0;
+		uint64_t reconnects = 0;
+		uint64_t heartbeat_misses = 0;
+		std::array<uint64_t, ACK_RTT_BUCKETS> ack_rtt_histogram{};
+
+		uint64_t ack_rtt_count() const;
+
+		/**
+		 * \return upper bound of the bucket holding the [percentile] (0..100) of acknowledgement round trips.
+		 */
+		std::chrono::microseconds ack_rtt_percentile(double percentile) const;
+	};
+
+	// region ctor/dtor
+
+	WireMetrics() = default;
+
+	WireMetrics(WireMetrics const&) = delete;
+	// endregion
+
+	void on_message_sent();
+
+	void on_package_sent(sequence_number_t seqn, size_t bytes);
+
+	void on_package_received(size_t bytes);
+
+	void on_message_received();
+
+	void on_acknowledged(sequence_number_t seqn);
+
+	void on_connected();
+
+	void on_heartbeat_missed();
+
+	/**
+	 * \brief Counters only: queue depths are gauges owned by the send buffer and filled in by the wire.
+	 */
+	Snapshot snapshot() const;
+
+	/**
+	 * \brief Zeroes counters and histogram; doesn't affect messages in flight.
+	 */
+	void reset();
+
+private:
+	static constexpr size_t IN_FLIGHT_SLOTS = 1024;
+
+	/**
+	 * \brief Send time of a recent package, matched by seqn when its ack arrives. Written by the sending thread only.
+	 */
+	struct InFlight
+	{
+		std::atomic<sequence_number_t> seqn{0};
+		std::atomic<int64_t> sent_at{0};
+	};
+
+	std::atomic<uint64_t> messages_sent{0};
+	std::atomic<uint64_t> messages_received{0};
+	std::atomic<uint64_t> bytes_sent{0};
+	std::atomic<uint64_t> bytes_received{0};
+	std::atomic<uint64_t> packages_sent{0};
+	std::atomic<uint64_t> packages_received{0};
+	std::atomic<uint64_t> connections{0};
+	std::atomic<uint64_t> reconnects{0};
+	std::atomic<bool> ever_connected{false};
+	std::atomic<uint64_t> heartbeat_misses{0};
+	std::array<std::atomic<uint64_t>, ACK_RTT_BUCKETS> ack_rtt_histogram{};
+	std::array<InFlight, IN_FLIGHT_SLOTS> in_flight{};
+};
+
+std::string RD_FRAMEWORK_API to_string(WireMetrics::Snapshot const& snapshot);
+}	 // namespace rd
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif	  // RD_CPP_WIREMETRICS_H
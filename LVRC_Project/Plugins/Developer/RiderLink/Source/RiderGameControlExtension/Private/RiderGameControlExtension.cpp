@@ -307,7 +307,8 @@ void FRiderGameControl::RequestPlayWorldCommand(const FCachedCommandInfo& Comman
 void FRiderGameControl::ScheduleModelAction(TFunction<void(JetBrains::EditorPlugin::RdEditorModel const&)> Action)
 {
     IRiderLinkModule& RiderLinkModule = IRiderLinkModule::Get();
-    RiderLinkModule.QueueAction([Action, this]()
+    // Play state goes to Rider ahead of the log events waiting in the Bulk lane
+    RiderLinkModule.QueueAction(rd::SchedulerLane::Control, [Action, this]()
     {
         Action(Model);
     });
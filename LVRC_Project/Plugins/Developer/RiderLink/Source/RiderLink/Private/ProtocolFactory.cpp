@@ -27,6 +27,7 @@
 #endif
 
 #include "spdlog/sinks/daily_file_sink.h"
+#include "util/core_log.h"
 
 static FString GetLocalAppdataFolder()
 {
@@ -81,9 +82,15 @@ static FString GetLogFile()
 }
 
 
+static constexpr size_t SEND_WINDOW_MAX_BYTES = 16 * 1024 * 1024;
+static constexpr size_t SEND_WINDOW_MAX_MESSAGES = 64 * 1024;
+// RD logs are written by a background thread, bounds how much of them a crash can lose
+static constexpr std::chrono::seconds LOG_FLUSH_INTERVAL{3};
+
 void ProtocolFactory::InitRdLogging()
 {
     spdlog::set_level(spdlog::level::err);
+    rd::util::set_log_flush_interval(LOG_FLUSH_INTERVAL);
 #if defined(ENABLE_LOG_FILE) && ENABLE_LOG_FILE == 1
     const FString LogFile = GetLogFile();
     const FString Msg = TEXT("[RiderLink] Path to log file: ") + LogFile;
@@ -99,9 +106,24 @@ void ProtocolFactory::InitRdLogging()
 std::shared_ptr<rd::SocketWire::Server> ProtocolFactory::CreateWire(rd::IScheduler* Scheduler, rd::Lifetime SocketLifetime)
 {
     const FString ProjectName = GetProjectName();
-    return std::make_shared<rd::SocketWire::Server>(SocketLifetime, Scheduler, 0,
+#if defined(ENABLE_WIRE_REACTOR) && ENABLE_WIRE_REACTOR == 1
+    constexpr rd::SocketWire::IoMode IoMode = rd::SocketWire::IoMode::Reactor;
+#else
+    constexpr rd::SocketWire::IoMode IoMode = rd::SocketWire::IoMode::Thread;
+#endif
+    auto Wire = std::make_shared<rd::SocketWire::Server>(SocketLifetime, Scheduler, 0,
                                                          TCHAR_TO_UTF8(*FString::Printf(TEXT("UnrealEditorServer-%s"),
-                                                             *ProjectName)));
+                                                             *ProjectName)), IoMode);
+    // Editor may run for hours without Rider connected: logs are shed once the window is full, see SendMessageToRider.
+    // Model updates are never dropped, a lost versioned update or call response would desync the model
+    rd::ByteBufferAsyncProcessor::Window SendWindow;
+    SendWindow.max_bytes = SEND_WINDOW_MAX_BYTES;
+    SendWindow.max_messages = SEND_WINDOW_MAX_MESSAGES;
+    Wire->set_send_window(SendWindow, rd::ByteBufferAsyncProcessor::BackpressurePolicy::Admit);
+#if defined(ENABLE_WIRE_COMPRESSION) && ENABLE_WIRE_COMPRESSION == 1
+    Wire->enable_compression();
+#endif
+    return Wire;
 }
 
 
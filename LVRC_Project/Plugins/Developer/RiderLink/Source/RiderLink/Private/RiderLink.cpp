@@ -2,6 +2,9 @@
 
 #include "ProtocolFactory.h"
 #include "UE4Library/UE4Library.Generated.h"
+#include "scheduler/TimerWheel.h"
+#include "wire/SocketReactor.h"
+#include "util/core_log.h"
 
 #include "Misc/ScopeRWLock.h"
 #include "Modules/ModuleManager.h"
@@ -13,10 +16,44 @@ DEFINE_LOG_CATEGORY(FLogRiderLinkModule);
 
 IMPLEMENT_MODULE(FRiderLinkModule, RiderLink);
 
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning( disable:4250 )
+#endif
+
+namespace RiderLinkImpl
+{
+// Getters of the generated model are const, its fields are set up from a subclass before the model is bound
+class FEditorModel : public JetBrains::EditorPlugin::RdEditorModel
+{
+public:
+	FEditorModel()
+	{
+		// Requests of the IDE overtake the queued model traffic on the main scheduler
+		allowSetForegroundWindow_.set_lane(rd::SchedulerLane::Control);
+		requestPlayFromRider_.set_lane(rd::SchedulerLane::Control);
+		requestPauseFromRider_.set_lane(rd::SchedulerLane::Control);
+		requestResumeFromRider_.set_lane(rd::SchedulerLane::Control);
+		requestStopFromRider_.set_lane(rd::SchedulerLane::Control);
+		requestFrameSkipFromRider_.set_lane(rd::SchedulerLane::Control);
+		playModeFromRider_.set_lane(rd::SchedulerLane::Control);
+	}
+};
+}
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
+
 void FRiderLinkModule::ShutdownModule()
 {
 	UE_LOG(FLogRiderLinkModule, Verbose, TEXT("RiderLink SHUTDOWN START"));
 	ModuleLifetimeDef.terminate();
+	// timers and reactor registrations of the wire end with its lifetime, join their threads before the module is unloaded
+	rd::TimerWheel::Instance().stop();
+	rd::SocketReactor::Instance().stop();
+	// Wire and scheduler threads are joined by now, nothing logs anymore
+	rd::util::shutdown_logging();
 	UE_LOG(FLogRiderLinkModule, Verbose, TEXT("RiderLink SHUTDOWN FINISH"));
 }
 
@@ -24,6 +61,14 @@ void FRiderLinkModule::StartupModule()
 {
 	UE_LOG(FLogRiderLinkModule, Verbose, TEXT("RiderLink STARTUP START"));
 	ProtocolFactory::InitRdLogging();
+	// stopped by the previous ShutdownModule if the module is reloaded
+	rd::TimerWheel::Instance().start();
+#if !UE_BUILD_SHIPPING
+	// Before anything is queued: queue latency, run time and a warning about tasks stuck on the main scheduler
+	auto SchedulerMetrics = std::make_shared<rd::SchedulerMetrics>("MainScheduler");
+	SchedulerMetrics->start_watchdog(ModuleLifetimeDef.lifetime);
+	Scheduler.set_metrics(std::move(SchedulerMetrics));
+#endif
 	Scheduler.queue([this]()
 	{
 		InitProtocol();
@@ -35,8 +80,9 @@ void FRiderLinkModule::InitProtocol()
 {
 	WireLifetimeDef = MakeUnique<rd::LifetimeDefinition>(ModuleLifetimeDef.lifetime);
 	rd::Lifetime WireLifetime = WireLifetimeDef->lifetime;
-	std::shared_ptr<rd::SocketWire::Server> Wire = ProtocolFactory::CreateWire(&Scheduler, WireLifetime);
-	Protocol = ProtocolFactory::CreateProtocol(&Scheduler, WireLifetime.create_nested(), Wire);
+	std::shared_ptr<rd::SocketWire::Server> NewWire = ProtocolFactory::CreateWire(&Scheduler, WireLifetime);
+	std::atomic_store(&Wire, NewWire);
+	Protocol = ProtocolFactory::CreateProtocol(&Scheduler, WireLifetime.create_nested(), NewWire);
 	// Exception fired for Server::Base::~Base() when trying to invoke it this way
 //	WireLifetime->add_action([this]()
 //	{
@@ -55,7 +101,7 @@ void FRiderLinkModule::InitProtocol()
 			if (!IsConnected) return;
 
 			FRWScopeLock LockOnConnect(ModelLock, SLT_Write);
-			EditorModel = MakeUnique<JetBrains::EditorPlugin::RdEditorModel>();
+			EditorModel = MakeUnique<RiderLinkImpl::FEditorModel>();
 			EditorModel->connect(ConnectionLifetime, Protocol.Get());
 			JetBrains::EditorPlugin::UE4Library::serializersOwner.registerSerializersCore(
 				EditorModel->get_serialization_context().get_serializers()
@@ -75,6 +121,36 @@ void FRiderLinkModule::InitProtocol()
 
 bool FRiderLinkModule::SupportsDynamicReloading() { return true; }
 
+bool FRiderLinkModule::GetWireMetrics(rd::WireMetrics::Snapshot& OutMetrics) const
+{
+	const std::shared_ptr<rd::SocketWire::Server> CurrentWire = std::atomic_load(&Wire);
+	if (!CurrentWire) return false;
+
+	OutMetrics = CurrentWire->get_metrics();
+	return true;
+}
+
+void FRiderLinkModule::ResetWireMetrics()
+{
+	const std::shared_ptr<rd::SocketWire::Server> CurrentWire = std::atomic_load(&Wire);
+	if (CurrentWire) CurrentWire->reset_metrics();
+}
+
+bool FRiderLinkModule::GetSchedulerMetrics(rd::SchedulerMetrics::Snapshot& OutMetrics) const
+{
+	const rd::SchedulerMetrics* Metrics = Scheduler.get_metrics();
+	if (!Metrics) return false;
+
+	OutMetrics = Metrics->snapshot();
+	return true;
+}
+
+void FRiderLinkModule::ResetSchedulerMetrics()
+{
+	rd::SchedulerMetrics* Metrics = Scheduler.get_metrics();
+	if (Metrics) Metrics->reset();
+}
+
 
 // Can't place RdEditorModel or TUniquePtr<RdEditorModel> into RdProperty.
 // Have to resort to RdProperty<bool> and change it before creating new RdEditorModel
@@ -98,6 +174,19 @@ void FRiderLinkModule::QueueAction(TFunction<void()> Handler)
 	});
 }
 
+void FRiderLinkModule::QueueAction(rd::SchedulerLane Lane, TFunction<void()> Handler)
+{
+	if (Scheduler.is_active())
+	{
+		Handler();
+		return;
+	}
+	Scheduler.queue_in_lane(Lane, [Handler]
+	{
+		Handler();
+	});
+}
+
 bool FRiderLinkModule::FireAsyncAction(TFunction<void(JetBrains::EditorPlugin::RdEditorModel const&)> Handler)
 {
 	FRWScopeLock Lock(ModelLock, SLT_ReadOnly);
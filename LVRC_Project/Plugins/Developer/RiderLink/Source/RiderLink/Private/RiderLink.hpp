@@ -4,6 +4,7 @@
 #include "impl/RdProperty.h"
 #include "lifetime/LifetimeDefinition.h"
 #include "scheduler/SingleThreadScheduler.h"
+#include "scheduler/base/SchedulerMetrics.h"
 #include "wire/SocketWire.h"
 
 #include "Logging/LogMacros.h"
@@ -39,8 +40,17 @@ public:
 	                       TFunction<void(rd::Lifetime,
 	                                      JetBrains::EditorPlugin::RdEditorModel const&)> Handler) override;
 	virtual void QueueAction(TFunction<void()> Handler) override;
+	virtual void QueueAction(rd::SchedulerLane Lane, TFunction<void()> Handler) override;
 	virtual bool FireAsyncAction(TFunction<void(JetBrains::EditorPlugin::RdEditorModel const&)> Handler) override;
 
+	/** Traffic counters of the editor connection, false until the wire is created */
+	bool GetWireMetrics(rd::WireMetrics::Snapshot& OutMetrics) const;
+	void ResetWireMetrics();
+
+	/** Timings of the main scheduler, false if they are turned off (shipping builds) */
+	bool GetSchedulerMetrics(rd::SchedulerMetrics::Snapshot& OutMetrics) const;
+	void ResetSchedulerMetrics();
+
 private:
 	void InitProtocol();
 
@@ -48,6 +58,8 @@ private:
 	rd::SingleThreadScheduler Scheduler{ModuleLifetimeDef.lifetime, "MainScheduler"};
 	TUniquePtr<rd::LifetimeDefinition> WireLifetimeDef;
 	TUniquePtr<rd::Protocol> Protocol;
+	// Created on the scheduler thread, read from the game thread
+	std::shared_ptr<rd::SocketWire::Server> Wire;
 	rd::RdProperty<bool> RdIsModelAlive;
 	TUniquePtr<JetBrains::EditorPlugin::RdEditorModel> EditorModel;
 	FRWLock ModelLock;
@@ -0,0 +1,111 @@
+#include "RiderLink.hpp"
+
+#include "scheduler/base/SchedulerMetrics.h"
+#include "wire/WireBenchmark.h"
+#include "wire/WireMetrics.h"
+
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Modules/ModuleManager.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+	std::atomic<bool> bWireBenchmarkRunning{false};
+
+	void RunWireBenchmark(const TArray<FString>& Args)
+	{
+		using rd::test::util::WireBenchmark;
+
+		if (bWireBenchmarkRunning.exchange(true))
+		{
+			UE_LOG(FLogRiderLinkModule, Warning, TEXT("Wire benchmark is already running"));
+			return;
+		}
+
+		WireBenchmark::Options Options;
+		if (Args.Num() > 0 && FCString::Atoi(*Args[0]) > 0)
+		{
+			Options.messages = FCString::Atoi(*Args[0]);
+		}
+
+		// Runs its own protocols on their own threads, the editor connection is not involved
+		Async(EAsyncExecution::Thread, [Options]()
+		{
+			UE_LOG(FLogRiderLinkModule, Display, TEXT("Wire benchmark started, %d messages per run"),
+			       static_cast<int32>(Options.messages));
+			for (const auto Transport : Options.transports)
+			{
+				for (const auto Scenario : Options.scenarios)
+				{
+					for (const size_t PayloadSize : Options.payload_sizes)
+					{
+						const size_t Budget = (std::max)(Options.max_bytes_per_run / PayloadSize, size_t{1});
+						const WireBenchmark::Result Result = WireBenchmark::run(
+							Transport, Scenario, PayloadSize, (std::min)(Options.messages, Budget), Options.timeout);
+						UE_LOG(FLogRiderLinkModule, Display, TEXT("%s"),
+						       UTF8_TO_TCHAR(WireBenchmark::to_string(Result).c_str()));
+					}
+				}
+			}
+			UE_LOG(FLogRiderLinkModule, Display, TEXT("Wire benchmark finished"));
+			bWireBenchmarkRunning = false;
+		});
+	}
+
+	void DumpWireMetrics(const TArray<FString>& Args)
+	{
+		FRiderLinkModule* Module = FModuleManager::GetModulePtr<FRiderLinkModule>(TEXT("RiderLink"));
+		rd::WireMetrics::Snapshot Metrics;
+		if (!Module || !Module->GetWireMetrics(Metrics))
+		{
+			UE_LOG(FLogRiderLinkModule, Warning, TEXT("RiderLink wire is not created yet"));
+			return;
+		}
+
+		UE_LOG(FLogRiderLinkModule, Display, TEXT("RiderLink wire: %s"), UTF8_TO_TCHAR(rd::to_string(Metrics).c_str()));
+		if (Args.Num() > 0 && Args[0].Equals(TEXT("reset"), ESearchCase::IgnoreCase))
+		{
+			Module->ResetWireMetrics();
+			UE_LOG(FLogRiderLinkModule, Display, TEXT("RiderLink wire metrics reset"));
+		}
+	}
+
+	void DumpSchedulerMetrics(const TArray<FString>& Args)
+	{
+		FRiderLinkModule* Module = FModuleManager::GetModulePtr<FRiderLinkModule>(TEXT("RiderLink"));
+		rd::SchedulerMetrics::Snapshot Metrics;
+		if (!Module || !Module->GetSchedulerMetrics(Metrics))
+		{
+			UE_LOG(FLogRiderLinkModule, Warning, TEXT("RiderLink scheduler metrics are turned off"));
+			return;
+		}
+
+		UE_LOG(FLogRiderLinkModule, Display, TEXT("RiderLink scheduler: %s"), UTF8_TO_TCHAR(rd::to_string(Metrics).c_str()));
+		if (Args.Num() > 0 && Args[0].Equals(TEXT("reset"), ESearchCase::IgnoreCase))
+		{
+			Module->ResetSchedulerMetrics();
+			UE_LOG(FLogRiderLinkModule, Display, TEXT("RiderLink scheduler metrics reset"));
+		}
+	}
+}
+
+static FAutoConsoleCommand RunWireBenchmarkCommand(
+	TEXT("RiderLink.RunWireBenchmark"),
+	TEXT("Measures messages/s, MB/s and p50/p99 latency of RD signals, properties, maps, calls and interning ")
+	TEXT("over in-process and loopback socket wires. Usage: RiderLink.RunWireBenchmark [MessagesPerRun]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunWireBenchmark));
+
+static FAutoConsoleCommand DumpWireMetricsCommand(
+	TEXT("RiderLink.WireMetrics"),
+	TEXT("Logs message, byte and package counters, send queue depth, reconnects, missed heartbeats and ack round trip ")
+	TEXT("percentiles of the Rider connection. Usage: RiderLink.WireMetrics [reset]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&DumpWireMetrics));
+
+static FAutoConsoleCommand DumpSchedulerMetricsCommand(
+	TEXT("RiderLink.SchedulerMetrics"),
+	TEXT("Logs queued and executed tasks, queue depth and its high-water mark, long tasks and queue latency and run time ")
+	TEXT("percentiles of the RiderLink main scheduler. Usage: RiderLink.SchedulerMetrics [reset]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&DumpSchedulerMetrics));
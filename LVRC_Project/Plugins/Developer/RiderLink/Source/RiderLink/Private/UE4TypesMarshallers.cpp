@@ -9,10 +9,23 @@
 namespace rd {
 
     FString Polymorphic<FString, void>::read(SerializationCtx& ctx, Buffer& buffer) {
-        UCS2CHAR * str = buffer.read_char16_string();
-        FString tmp{str};
-        delete str;
-        return tmp;
+        // UTF-16 units in the buffer aren't aligned, so they are copied bytewise instead of being read as UCS2CHAR
+        const auto str = buffer.read_string_view();
+        const int32 Len = static_cast<int32>(str.size());
+        FString Result;
+        if (Len == 0) return Result;
+#if PLATFORM_TCHAR_IS_4_BYTES
+        TArray<UCS2CHAR> Units;
+        Units.SetNumUninitialized(Len);
+        FMemory::Memcpy(Units.GetData(), str.data(), Len * sizeof(UCS2CHAR));
+        return FString(Len, Units.GetData());
+#else
+        TArray<TCHAR>& Chars = Result.GetCharArray();
+        Chars.SetNumUninitialized(Len + 1);
+        FMemory::Memcpy(Chars.GetData(), str.data(), Len * sizeof(TCHAR));
+        Chars[Len] = TEXT('\0');
+        return Result;
+#endif
     }
 
     void Polymorphic<FString, void>::write(SerializationCtx& ctx, Buffer& buffer, FString const& value) {
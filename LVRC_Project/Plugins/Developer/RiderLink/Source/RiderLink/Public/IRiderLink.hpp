@@ -2,6 +2,7 @@
 
 #include "RdEditorModel/RdEditorModel.Generated.h"
 #include "lifetime/LifetimeDefinition.h"
+#include "scheduler/base/IScheduler.h"
 
 #include "Modules/ModuleInterface.h"
 #include "Modules/ModuleManager.h"
@@ -24,5 +25,7 @@ public:
 	virtual rd::LifetimeDefinition CreateNestedLifetimeDefinition() const = 0;
 	virtual void ViewModel(rd::Lifetime Lifetime, TFunction<void(rd::Lifetime, JetBrains::EditorPlugin::RdEditorModel const&)> Handler) = 0;
 	virtual void QueueAction(TFunction<void()> Handler) = 0;
+	// Queued behind the earlier actions of the same lane, e.g. Bulk for traffic that must not delay the play controls
+	virtual void QueueAction(rd::SchedulerLane Lane, TFunction<void()> Handler) = 0;
 	virtual bool FireAsyncAction(TFunction<void(JetBrains::EditorPlugin::RdEditorModel const&)> Handler) = 0;
 };
@@ -23,6 +23,10 @@ public class RiderLink : ModuleRules
 		};
 		
 		PrivateDefinitions.Add("ENABLE_LOG_FILE=0");
+		// Requires Rider side to answer the wire handshake
+		PrivateDefinitions.Add("ENABLE_WIRE_COMPRESSION=0");
+		// Receive on the shared epoll thread instead of a thread per wire, Linux only
+		PrivateDefinitions.Add("ENABLE_WIRE_REACTOR=0");
 
 		foreach(var Item in Paths)
 		{
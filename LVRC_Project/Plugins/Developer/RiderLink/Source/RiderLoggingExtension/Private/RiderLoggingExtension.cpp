@@ -53,17 +53,20 @@ static TArray<rd::Wrapper<JetBrains::EditorPlugin::StringRange>> GetMethodRanges
 static const FRegexPattern PathPattern = FRegexPattern(TEXT("[^\\s]*/[^\\s]+"));
 static const FRegexPattern MethodPattern = FRegexPattern(TEXT("[0-9a-z_A-Z]+::~?[0-9a-z_A-Z]+"));
 
-static bool SendMessageToRider(const JetBrains::EditorPlugin::LogMessageInfo& MessageInfo, const FString& Message)
+// Sends the chunks of one log line in the Bulk lane of the RiderLink scheduler, so the play controls and the
+// other model traffic are sent ahead of a log flood. The rest of the line is dropped once the wire is congested.
+static void SendMessagesToRider(TArray<JetBrains::EditorPlugin::UnrealLogEvent> Events)
 {
-	return IRiderLinkModule::Get().FireAsyncAction(
-	[&MessageInfo, &Message] (JetBrains::EditorPlugin::RdEditorModel const& RdEditorModel)
+	IRiderLinkModule::Get().QueueAction(rd::SchedulerLane::Bulk, [Events = MoveTemp(Events)]()
 	{
-		rd::ISignal<JetBrains::EditorPlugin::UnrealLogEvent> const& UnrealLog = RdEditorModel.get_unrealLog();
-		UnrealLog.fire({
-			MessageInfo,
-			Message,
-			GetPathRanges(PathPattern, Message),
-			GetMethodRanges(MethodPattern, Message)
+		IRiderLinkModule::Get().FireAsyncAction(
+		[&Events] (JetBrains::EditorPlugin::RdEditorModel const& RdEditorModel)
+		{
+			rd::ISignal<JetBrains::EditorPlugin::UnrealLogEvent> const& UnrealLog = RdEditorModel.get_unrealLog();
+			for (const JetBrains::EditorPlugin::UnrealLogEvent& Event : Events)
+			{
+				if (!UnrealLog.try_fire(Event)) return;
+			}
 		});
 	});
 }
@@ -71,11 +74,22 @@ static bool SendMessageToRider(const JetBrains::EditorPlugin::LogMessageInfo& Me
 void SendMessageInChunks(FString* Msg, const JetBrains::EditorPlugin::LogMessageInfo& MessageInfo)
 {
 	static int NUMBER_OF_CHUNKS = 1024;
+	TArray<JetBrains::EditorPlugin::UnrealLogEvent> Events;
 	while (!Msg->IsEmpty())
 	{
-		SendMessageToRider(MessageInfo, Msg->Left(NUMBER_OF_CHUNKS));
+		const FString Chunk = Msg->Left(NUMBER_OF_CHUNKS);
+		Events.Emplace(
+			MessageInfo,
+			Chunk,
+			GetPathRanges(PathPattern, Chunk),
+			GetMethodRanges(MethodPattern, Chunk)
+		);
 		*Msg = Msg->RightChop(NUMBER_OF_CHUNKS);
 	}
+	if (Events.Num() > 0)
+	{
+		SendMessagesToRider(MoveTemp(Events));
+	}
 }
 
 void ScheduledSendMessage(FString* Msg, const JetBrains::EditorPlugin::LogMessageInfo& MessageInfo)